@@ -0,0 +1,1393 @@
+﻿#include "Bvh.h"
+#include "CameraRelative.h"
+#include "Collision.h"
+#include "DebugDraw.h"
+#include "FastMath.h"
+#include "FrameArena.h"
+#include "Grid.h"
+#include "HeadlessDrawSink.h"
+#include "JobSystem.h"
+#include "LineBatch.h"
+#include "MathSimd.h"
+#include "Mathfunction.h"
+#include "Quaternion.h"
+#include "Rasterizer.h"
+#include "SceneFile.h"
+#include "ScreenVertex.h"
+#include "TransformHierarchy.h"
+#include "Vector3Soa.h"
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <filesystem>
+#include <new>
+#include <random>
+#include <string>
+#include <vector>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#endif
+#if defined(__linux__)
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+/*---------------------------------
+ ベンチマーク
+ ・Mathfunction.h の各関数 (マイクロ) と 1 フレーム分の描画 (マクロ) を計る
+ ・使い方: Benchmark [--filter=文字列] [--isa=scalar|sse|avx2|avx512] [--threads=数]
+           [--json=出力先]
+ ・ns/op, ops/s, ヒープ確保の回数と、取れる環境 (Linux の perf) ならキャッシュミス数を出す
+------------------------------------*/
+
+/*---------------------------------
+ ヒープ確保の回数
+ ・グローバルの operator new を置き換えて数える (計測中に確保していないかを見る)
+------------------------------------*/
+static std::atomic<uint64_t> gAllocationCount{0};
+
+void* operator new(std::size_t size) {
+	gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	if (void* p = std::malloc(size == 0 ? 1 : size)) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void* operator new(std::size_t size, std::align_val_t alignment) {
+	gAllocationCount.fetch_add(1, std::memory_order_relaxed);
+	size_t align = size_t(alignment);
+#if defined(_MSC_VER)
+	void* p = _aligned_malloc(size == 0 ? 1 : size, align);
+#else
+	// aligned_alloc は大きさが境界の倍数でないといけない
+	void* p = std::aligned_alloc(align, (size + align - 1) / align * align);
+#endif
+	if (p) {
+		return p;
+	}
+	throw std::bad_alloc();
+}
+
+void operator delete(void* p) noexcept { std::free(p); }
+void operator delete(void* p, std::size_t) noexcept { std::free(p); }
+
+void operator delete(void* p, std::align_val_t) noexcept {
+#if defined(_MSC_VER)
+	_aligned_free(p);
+#else
+	std::free(p);
+#endif
+}
+void operator delete(void* p, std::size_t, std::align_val_t alignment) noexcept {
+	operator delete(p, alignment);
+}
+
+namespace {
+
+// 計測対象の結果を最適化で消されないようにする
+inline void ClobberMemory() {
+#if defined(_MSC_VER)
+	_ReadWriteBarrier();
+#else
+	__asm__ volatile("" : : : "memory");
+#endif
+}
+
+/*---------------------------------
+ キャッシュミスカウンタ (Linux の perf のみ。使えなければ -1)
+------------------------------------*/
+class CacheMissCounter {
+public:
+	CacheMissCounter() {
+#if defined(__linux__)
+		perf_event_attr attr;
+		std::memset(&attr, 0, sizeof(attr));
+		attr.type = PERF_TYPE_HARDWARE;
+		attr.size = sizeof(attr);
+		attr.config = PERF_COUNT_HW_CACHE_MISSES;
+		attr.disabled = 1;
+		attr.exclude_kernel = 1;
+		attr.exclude_hv = 1;
+		fd_ = (int)syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0);
+#endif
+	}
+	~CacheMissCounter() {
+#if defined(__linux__)
+		if (fd_ >= 0) {
+			close(fd_);
+		}
+#endif
+	}
+	CacheMissCounter(const CacheMissCounter&) = delete;
+	CacheMissCounter& operator=(const CacheMissCounter&) = delete;
+
+	bool IsAvailable() const { return fd_ >= 0; }
+
+	void Start() {
+#if defined(__linux__)
+		if (fd_ >= 0) {
+			ioctl(fd_, PERF_EVENT_IOC_RESET, 0);
+			ioctl(fd_, PERF_EVENT_IOC_ENABLE, 0);
+		}
+#endif
+	}
+
+	// Start からのキャッシュミス数
+	int64_t Stop() {
+#if defined(__linux__)
+		if (fd_ >= 0) {
+			ioctl(fd_, PERF_EVENT_IOC_DISABLE, 0);
+			int64_t count = 0;
+			if (read(fd_, &count, sizeof(count)) == sizeof(count)) {
+				return count;
+			}
+		}
+#endif
+		return -1;
+	}
+
+private:
+	int fd_ = -1;
+};
+
+/*---------------------------------
+ 計測の枠組み
+------------------------------------*/
+
+// ベンチマーク関数に渡す状態
+// 準備が済んだら StartTimer、iterations 回まわしたら StopTimer を呼ぶ
+struct BenchmarkContext {
+	size_t batch;
+	uint64_t iterations;
+	CacheMissCounter* counter;
+	std::chrono::steady_clock::time_point start;
+	double elapsedNs;
+	int64_t cacheMisses;
+	uint64_t allocationsAtStart;
+	uint64_t allocations;
+
+	void StartTimer() {
+		allocationsAtStart = gAllocationCount.load(std::memory_order_relaxed);
+		counter->Start();
+		start = std::chrono::steady_clock::now();
+	}
+	void StopTimer() {
+		auto end = std::chrono::steady_clock::now();
+		cacheMisses = counter->Stop();
+		allocations = gAllocationCount.load(std::memory_order_relaxed) - allocationsAtStart;
+		elapsedNs = std::chrono::duration<double, std::nano>(end - start).count();
+	}
+};
+
+using BenchmarkFunction = void (*)(BenchmarkContext& context);
+
+struct Benchmark {
+	const char* name;
+	BenchmarkFunction function;
+	// 1 回あたりに処理する要素数 (ops = iterations * batch)
+	std::vector<size_t> batches;
+};
+
+struct BenchmarkResult {
+	std::string name;
+	size_t batch;
+	uint64_t iterations;
+	double nsPerOp;
+	double opsPerSecond;
+	double allocationsPerOp;
+	double cacheMissesPerOp; // 取れなければ負
+};
+
+// 入力データ (毎回同じ値になるよう固定シード)
+std::vector<Vector3> MakeRandomVectors(size_t count, float range) {
+	std::mt19937 engine(12345);
+	std::uniform_real_distribution<float> distribution(-range, range);
+	std::vector<Vector3> vectors(count);
+	for (Vector3& v : vectors) {
+		v = {distribution(engine), distribution(engine), distribution(engine)};
+	}
+	return vectors;
+}
+
+std::vector<Matrix4x4> MakeRandomAffineMatrices(size_t count) {
+	std::vector<Vector3> scales = MakeRandomVectors(count, 2.0f);
+	std::vector<Vector3> rotates = MakeRandomVectors(count, 3.14f);
+	std::vector<Vector3> translates = MakeRandomVectors(count, 100.0f);
+	std::vector<Matrix4x4> matrices(count);
+	for (size_t i = 0; i < count; ++i) {
+		scales[i].x += 3.0f;
+		scales[i].y += 3.0f;
+		scales[i].z += 3.0f;
+		matrices[i] = MakeAffineMatrix(scales[i], rotates[i], translates[i]);
+	}
+	return matrices;
+}
+
+// オイラー角から作った回転
+std::vector<Quaternion> MakeRandomQuaternions(size_t count) {
+	std::vector<Vector3> rotates = MakeRandomVectors(count, 3.14f);
+	std::vector<Quaternion> quaternions(count);
+	for (size_t i = 0; i < count; ++i) {
+		quaternions[i] = MakeEulerQuaternion(rotates[i]);
+	}
+	return quaternions;
+}
+
+// main.cpp と同じカメラ
+Matrix4x4 MakeSceneViewProjection() {
+	Matrix4x4 cameraMatrix =
+	    MakeAffineMatrix({1.0f, 1.0f, 1.0f}, {0.26f, 0.0f, 0.0f}, {0.0f, 1.9f, -6.49f});
+	return Multiply(
+	    InverseRigid(cameraMatrix), MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f));
+}
+
+Matrix4x4 MakeSceneViewport() { return MakeViewportMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f); }
+
+/*---------------------------------
+ マイクロベンチマーク (行列)
+------------------------------------*/
+
+void BM_Multiply(BenchmarkContext& context) {
+	std::vector<Matrix4x4> a = MakeRandomAffineMatrices(context.batch);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Multiply(a[i], a[context.batch - 1 - i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// BM_Multiply と同じ積を 1 回の呼び出しでまとめて求める
+void BM_MultiplyArray(BenchmarkContext& context) {
+	std::vector<Matrix4x4> a = MakeRandomAffineMatrices(context.batch);
+	std::vector<Matrix4x4> b(a.rbegin(), a.rend());
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		MultiplyArray(a.data(), b.data(), out.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_Inverse(BenchmarkContext& context) {
+	std::vector<Matrix4x4> a = MakeRandomAffineMatrices(context.batch);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Inverse(a[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_TryInverse(BenchmarkContext& context) {
+	std::vector<Matrix4x4> a = MakeRandomAffineMatrices(context.batch);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			TryInverse(a[i], out[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_InverseAffine(BenchmarkContext& context) {
+	std::vector<Matrix4x4> a = MakeRandomAffineMatrices(context.batch);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = InverseAffine(a[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// スケールなしのワールド行列 (回転 + 平行移動のみ)
+void BM_InverseRigid(BenchmarkContext& context) {
+	std::vector<Vector3> r = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<Vector3> t = MakeRandomVectors(context.batch, 100.0f);
+	std::vector<Matrix4x4> a(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		a[i] = MakeAffineMatrix({1.0f, 1.0f, 1.0f}, r[i], t[i]);
+	}
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = InverseRigid(a[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_MakeAffineMatrix(BenchmarkContext& context) {
+	std::vector<Vector3> s = MakeRandomVectors(context.batch, 2.0f);
+	std::vector<Vector3> r = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<Vector3> t = MakeRandomVectors(context.batch, 100.0f);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = MakeAffineMatrix(s[i], r[i], t[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_MakeAffineMatrices(BenchmarkContext& context) {
+	std::vector<Vector3> s = MakeRandomVectors(context.batch, 2.0f);
+	std::vector<Vector3> r = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<Vector3> t = MakeRandomVectors(context.batch, 100.0f);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		MakeAffineMatrices(s.data(), r.data(), t.data(), out.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// 原点から遠い double の位置をカメラからの相対位置にしてから作る
+void BM_MakeAffineCameraRelative(BenchmarkContext& context) {
+	std::vector<Vector3> s = MakeRandomVectors(context.batch, 2.0f);
+	std::vector<Vector3> r = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<Vector3> t = MakeRandomVectors(context.batch, 100.0f);
+	const Vector3d cameraPosition = {1.0e6, 0.0, 1.0e6};
+	std::vector<Vector3d> positions(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		positions[i] = Vec3Add(cameraPosition, Vec3Cast<double>(t[i]));
+	}
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		MakeCameraRelativeAffineMatrices(
+		    s.data(), r.data(), positions.data(), cameraPosition, out.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// オイラー角の代わりにクォータニオンで回転を渡す
+void BM_MakeAffineQuaternion(BenchmarkContext& context) {
+	std::vector<Vector3> s = MakeRandomVectors(context.batch, 2.0f);
+	std::vector<Quaternion> r = MakeRandomQuaternions(context.batch);
+	std::vector<Vector3> t = MakeRandomVectors(context.batch, 100.0f);
+	std::vector<Matrix4x4> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		MakeQuaternionAffineMatrices(s.data(), r.data(), t.data(), out.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_MakeRotateMatrix(BenchmarkContext& context) {
+	std::vector<Vector3> r = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<Matrix4x4> out(context.batch * 3);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i * 3] = MakeRotateXMatrix(r[i].x);
+			out[i * 3 + 1] = MakeRotateYMatrix(r[i].y);
+			out[i * 3 + 2] = MakeRotateZMatrix(r[i].z);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_MakeScaleTranslateMatrix(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Matrix4x4> out(context.batch * 2);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i * 2] = MakeScaleMatrix(v[i]);
+			out[i * 2 + 1] = MakeTranslateMatrix(v[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_MakeProjectionMatrix(BenchmarkContext& context) {
+	std::vector<Matrix4x4> out(context.batch * 3);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			float f = 1.0f + float(i & 15);
+			out[i * 3] = MakePerspectiveFovMatrix(0.45f, 16.0f / 9.0f, 0.1f, 100.0f * f);
+			out[i * 3 + 1] = MakeOrthographicMatrix(-f, f, f, -f, 0.0f, 100.0f);
+			out[i * 3 + 2] = MakeViewportMatrix(0.0f, 0.0f, 1280.0f * f, 720.0f, 0.0f, 1.0f);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+/*---------------------------------
+ マイクロベンチマーク (クォータニオン)
+ ・キーフレーム間の補間。batch はオブジェクトの数
+------------------------------------*/
+
+void BM_Slerp(BenchmarkContext& context) {
+	std::vector<Quaternion> q0 = MakeRandomQuaternions(context.batch * 2);
+	std::vector<Quaternion> q1(q0.begin() + context.batch, q0.end());
+	std::vector<float> t(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		t[i] = float(i % 64) / 64.0f;
+	}
+	std::vector<Quaternion> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Slerp(q0[i], q1[i], t[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_SlerpFastArray(BenchmarkContext& context) {
+	std::vector<Quaternion> q0 = MakeRandomQuaternions(context.batch * 2);
+	std::vector<Quaternion> q1(q0.begin() + context.batch, q0.end());
+	std::vector<float> t(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		t[i] = float(i % 64) / 64.0f;
+	}
+	std::vector<Quaternion> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		SlerpFastArray(q0.data(), q1.data(), t.data(), out.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+/*---------------------------------
+ トランスフォームの階層
+ ・batch はノードの数。1000 本の木に分け、親は子より前に並ぶ
+ ・1 回ごとに movedPercent % のノードを動かしてからワールド行列を更新する
+------------------------------------*/
+
+void RunTransformHierarchy(BenchmarkContext& context, size_t movedPercent) {
+	std::vector<Vector3> translates = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Quaternion> rotates = MakeRandomQuaternions(context.batch);
+	TransformHierarchy hierarchy;
+	hierarchy.Reserve(context.batch);
+	const size_t kRootCount = 1000;
+	for (size_t i = 0; i < context.batch; ++i) {
+		uint32_t parent = i < kRootCount ? TransformHierarchy::kNoParent : uint32_t(i / 8);
+		hierarchy.AddNode(parent, {1.0f, 1.0f, 1.0f}, rotates[i], translates[i]);
+	}
+	hierarchy.UpdateWorldMatrices();
+
+	// 動かすノードは毎回同じ (散らばるように素数おきに選ぶ)
+	size_t movedCount = context.batch * movedPercent / 100;
+	std::vector<uint32_t> moved(movedCount);
+	for (size_t i = 0; i < movedCount; ++i) {
+		moved[i] = uint32_t(i * 7919 % context.batch);
+	}
+
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		float offset = float(it & 1);
+		for (uint32_t index : moved) {
+			Vector3 translate = translates[index];
+			translate.x += offset;
+			hierarchy.SetTranslate(index, translate);
+		}
+		hierarchy.UpdateWorldMatrices();
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_TransformHierarchy(BenchmarkContext& context) { RunTransformHierarchy(context, 10); }
+
+void BM_TransformHierarchyAll(BenchmarkContext& context) {
+	RunTransformHierarchy(context, 100);
+}
+
+/*---------------------------------
+ マイクロベンチマーク (ベクトル)
+------------------------------------*/
+
+void BM_Transform(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> out(context.batch);
+	Matrix4x4 m = MakeSceneViewProjection();
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Transform(v[i], m);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_TransformArray(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> out(context.batch);
+	Matrix4x4 m = MakeSceneViewProjection();
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		TransformArray(v.data(), out.data(), context.batch, m);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_TransformArraySoa(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	Vector3Soa soa(v.data(), v.size());
+	Vector3Soa out(context.batch);
+	Matrix4x4 m = MakeSceneViewProjection();
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		TransformArray(soa, out, m);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// screen 座標を詰めた形式で書く (ビューポート行列まで掛ける。深度も書く)
+void BM_TransformArrayFixed(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<ScreenPointFixed> points(context.batch);
+	std::vector<uint16_t> depths(context.batch);
+	Matrix4x4 m = Multiply(MakeSceneViewProjection(), MakeSceneViewport());
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		TransformArrayToScreenFixed(v.data(), points.data(), depths.data(), context.batch, m);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_TransformArray16(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<ScreenPoint16> points(context.batch);
+	std::vector<uint16_t> depths(context.batch);
+	Matrix4x4 m = Multiply(MakeSceneViewProjection(), MakeSceneViewport());
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		TransformArrayToScreen16(v.data(), points.data(), depths.data(), context.batch, m);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_Normalize(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Normalize(v[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_NormalizeSoa(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	Vector3Soa soa(v.data(), v.size());
+	Vector3Soa out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		Normalize(soa, out);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_Length(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<float> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Length(v[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_NormalizeFast(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = NormalizeFast(v[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_LengthFast(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<float> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = LengthFast(v[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// 角度は -π〜π
+template<MathPrecision precision>
+void RunSinCos(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<float> sines(context.batch);
+	std::vector<float> cosines(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			SinCos<precision>(v[i].x, sines[i], cosines[i]);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_SinCos(BenchmarkContext& context) { RunSinCos<MathPrecision::kPrecise>(context); }
+void BM_SinCosFast(BenchmarkContext& context) { RunSinCos<MathPrecision::kFast>(context); }
+void BM_SinCosCoarse(BenchmarkContext& context) { RunSinCos<MathPrecision::kCoarse>(context); }
+
+void BM_SinCosArrayFast(BenchmarkContext& context) {
+	std::vector<Vector3> v = MakeRandomVectors(context.batch, 3.14f);
+	std::vector<float> radians(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		radians[i] = v[i].x;
+	}
+	std::vector<float> sines(context.batch);
+	std::vector<float> cosines(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		SinCosArrayFast(radians.data(), sines.data(), cosines.data(), context.batch);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_Vec3Arithmetic(BenchmarkContext& context) {
+	std::vector<Vector3> a = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> b = MakeRandomVectors(context.batch, 5.0f);
+	std::vector<Vector3> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			out[i] = Vec3Add(Vec3Subtract(a[i], b[i]), Vec3Multiply(0.5f, b[i]));
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_DotCross(BenchmarkContext& context) {
+	std::vector<Vector3> a = MakeRandomVectors(context.batch, 10.0f);
+	std::vector<Vector3> b = MakeRandomVectors(context.batch, 5.0f);
+	std::vector<Vector3> out(context.batch);
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < context.batch; ++i) {
+			Vector3 c = Cross(a[i], b[i]);
+			out[i] = Vec3Multiply(Dot(a[i], b[i]), c);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+/*---------------------------------
+ マクロベンチマーク (1 フレーム分の描画)
+ ・batch は球の数。Grid 1 枚と batch 個の球を HeadlessDrawSink に描く
+------------------------------------*/
+
+// 並列版で使うジョブシステム (--threads で数を指定)
+JobSystem* gJobSystem = nullptr;
+
+// 球の描き方
+enum class FrameMode {
+	kSerial,        // DrawSphere を 1 つずつ呼ぶ
+	kParallel,      // DrawSpheres で描画先へ直接出す
+	kParallelArena, // フレームアリーナの線バッファに溜めてから SubmitLines で出す
+	kParallelLod,   // DrawSpheres に球ごとの詳細度を覚えておく配列を渡す
+	kParallelBatch, // LineBatch に色ごとに溜めてから Flush で出す
+};
+
+// worldRange: 球を置く範囲 (大きくすると画面外の球が増える)
+void RunFrame(
+    BenchmarkContext& context, HeadlessDrawSink& sink, FrameMode mode,
+    float worldRange = 2.0f) {
+	std::vector<Vector3> centers = MakeRandomVectors(context.batch, worldRange);
+	std::vector<Sphere> spheres(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		spheres[i] = {centers[i], 0.05f + 0.02f * float(i % 8)};
+	}
+	Matrix4x4 viewProjectionMatrix = MakeSceneViewProjection();
+	Matrix4x4 viewportMatrix = MakeSceneViewport();
+
+	ParallelLineBuffer lineBuffer;
+	FrameArena frameArena;
+	LineBatch lineBatch;
+	std::vector<uint8_t> lods(context.batch, kSphereLodNone);
+
+	auto drawFrame = [&] {
+		sink.Clear();
+		switch (mode) {
+		case FrameMode::kSerial:
+			DrawGrid(viewProjectionMatrix, viewportMatrix, sink);
+			for (const Sphere& sphere : spheres) {
+				DrawSphere(sphere, viewProjectionMatrix, viewportMatrix, kColorBlack, sink);
+			}
+			break;
+		case FrameMode::kParallel:
+			DrawGrid(viewProjectionMatrix, viewportMatrix, sink);
+			DrawSpheres(
+			    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorBlack,
+			    *gJobSystem, lineBuffer, sink);
+			break;
+		case FrameMode::kParallelArena: {
+			frameArena.Reset();
+			FrameLineBuffer lines(frameArena);
+			DrawGrid(viewProjectionMatrix, viewportMatrix, lines);
+			DrawSpheres(
+			    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorBlack,
+			    *gJobSystem, lineBuffer, lines);
+			SubmitLines(lines, sink);
+			break;
+		}
+		case FrameMode::kParallelLod:
+			DrawGrid(viewProjectionMatrix, viewportMatrix, sink);
+			DrawSpheres(
+			    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorBlack,
+			    *gJobSystem, lineBuffer, sink, lods.data());
+			break;
+		case FrameMode::kParallelBatch:
+			DrawGrid(viewProjectionMatrix, viewportMatrix, lineBatch);
+			DrawSpheres(
+			    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorBlack,
+			    *gJobSystem, lineBuffer, lineBatch);
+			lineBatch.Flush(sink);
+			break;
+		}
+	};
+
+	// バッファの容量を確保しておく (計測するのは使い回しているときの 1 フレーム)
+	drawFrame();
+
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		drawFrame();
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_FrameLines(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kSerial);
+}
+
+void BM_FrameLinesParallel(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kParallel);
+}
+
+void BM_FrameLinesArena(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kParallelArena);
+}
+
+void BM_FrameLinesBatch(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kParallelBatch);
+}
+
+// 広いワールドに散らばった球 (ほとんどが視錐台の外)
+void BM_FrameLinesLargeWorld(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kSerial, 100.0f);
+}
+
+// 奥まで混み合った球 (遠くの小さい球は粗い詳細度で描くか、画素未満なら描かない)
+void BM_FrameLinesCrowd(BenchmarkContext& context) {
+	HeadlessDrawSink sink;
+	RunFrame(context, sink, FrameMode::kParallelLod, 20.0f);
+}
+
+void BM_FrameRaster(BenchmarkContext& context) {
+	HeadlessDrawSink sink(1280, 720);
+	sink.SetRecordLines(false);
+	RunFrame(context, sink, FrameMode::kSerial);
+}
+
+// 塗りつぶしの球 (ソフトウェアラスタライザ。深度バッファあり)
+void RunSolidFrame(BenchmarkContext& context, bool parallel) {
+	std::vector<Vector3> centers = MakeRandomVectors(context.batch, 2.0f);
+	std::vector<Sphere> spheres(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		spheres[i] = {centers[i], 0.05f + 0.02f * float(i % 8)};
+	}
+	Matrix4x4 viewProjectionMatrix = MakeSceneViewProjection();
+	Matrix4x4 viewportMatrix = MakeSceneViewport();
+	Rasterizer rasterizer(1280, 720);
+
+	auto drawFrame = [&] {
+		rasterizer.Clear(kColorBlack);
+		DrawSolidSpheres(
+		    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorWhite,
+		    rasterizer);
+		if (parallel) {
+			rasterizer.Flush(*gJobSystem);
+		} else {
+			rasterizer.Flush();
+		}
+	};
+
+	// タイルの箱の容量を確保しておく
+	drawFrame();
+
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		drawFrame();
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_FrameSolid(BenchmarkContext& context) { RunSolidFrame(context, false); }
+
+void BM_FrameSolidParallel(BenchmarkContext& context) { RunSolidFrame(context, true); }
+
+/*---------------------------------
+ Grid
+ ・batch は一辺の分割数。主線と遠くを薄くする設定で線をフレームアリーナに溜める
+ ・moving なら毎フレーム行列を変え (画面の線を作り直す)、そうでなければ同じ行列で描く
+------------------------------------*/
+void RunGrid(BenchmarkContext& context, bool moving) {
+	GridSettings settings;
+	settings.halfWidth = float(context.batch) * 0.5f;
+	settings.subdivision = uint32_t(context.batch);
+	settings.majorEvery = 10;
+	settings.minorColor = 0xAAAAAAFF;
+	settings.fadeStart = 20.0f;
+	settings.fadeEnd = 60.0f;
+	Grid grid(settings);
+	Matrix4x4 viewProjectionMatrices[2] = {
+	    MakeSceneViewProjection(), Multiply(MakeTranslateMatrix({0.1f, 0.0f, 0.0f}),
+	                                        MakeSceneViewProjection())};
+	Matrix4x4 viewportMatrix = MakeSceneViewport();
+	FrameArena frameArena;
+
+	auto drawFrame = [&](uint64_t frame) {
+		frameArena.Reset();
+		FrameLineBuffer lines(frameArena);
+		grid.Draw(viewProjectionMatrices[moving ? frame % 2 : 0], viewportMatrix, lines);
+	};
+	drawFrame(1);
+
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		drawFrame(it);
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_GridIdle(BenchmarkContext& context) { RunGrid(context, false); }
+
+void BM_GridMoving(BenchmarkContext& context) { RunGrid(context, true); }
+
+/*---------------------------------
+ 衝突判定 (1 フレーム分)
+ ・batch は球の数。球を少し動かしてから Update と FindPairs を行う
+ ・密度は球の数によらず一定 (1 つの球のまわりに平均 0.1 個程度)
+------------------------------------*/
+
+void RunCollision(BenchmarkContext& context, bool parallel) {
+	const float kRadius = 0.25f;
+	// 球 1 個あたり 1 辺 1.6 の立方体
+	const float range = std::cbrt(float(context.batch)) * 0.8f;
+	std::vector<Vector3> centers = MakeRandomVectors(context.batch, range);
+	// 乱数の種が同じなので、位置と相関しないよう後ろ半分を速度に使う
+	std::vector<Vector3> velocities = MakeRandomVectors(context.batch * 2, 0.02f);
+	velocities.erase(velocities.begin(), velocities.begin() + context.batch);
+	std::vector<Sphere> spheres(context.batch);
+	for (size_t i = 0; i < context.batch; ++i) {
+		spheres[i] = {centers[i], kRadius};
+	}
+
+	SphereBroadphase broadphase(kRadius * 2.0f);
+	broadphase.Update(spheres.data(), spheres.size());
+	std::vector<CollisionPair> pairs;
+
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (size_t i = 0; i < spheres.size(); ++i) {
+			Vector3& center = spheres[i].center;
+			center = Vec3Add(center, velocities[i]);
+			// 範囲の外に出たら向きを変える
+			if (center.x < -range || center.x > range) {
+				velocities[i].x = -velocities[i].x;
+			}
+			if (center.y < -range || center.y > range) {
+				velocities[i].y = -velocities[i].y;
+			}
+			if (center.z < -range || center.z > range) {
+				velocities[i].z = -velocities[i].z;
+			}
+		}
+		broadphase.Update(spheres.data(), spheres.size());
+		if (parallel) {
+			broadphase.FindPairs(pairs, *gJobSystem);
+		} else {
+			broadphase.FindPairs(pairs);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_Collision(BenchmarkContext& context) { RunCollision(context, false); }
+
+void BM_CollisionParallel(BenchmarkContext& context) { RunCollision(context, true); }
+
+/*---------------------------------
+ BVH
+ ・Build / Refit の batch は球の数
+ ・問い合わせの batch は 1 回あたりの問い合わせ数。球 50 万個の場面を 1 度だけ作って使う
+------------------------------------*/
+
+std::vector<Sphere> MakeBvhScene(size_t count) {
+	// 球 1 個あたり 1 辺 10 の立方体
+	const float range = std::cbrt(float(count)) * 5.0f;
+	std::vector<Vector3> centers = MakeRandomVectors(count, range);
+	std::vector<Sphere> spheres(count);
+	for (size_t i = 0; i < count; ++i) {
+		spheres[i] = {centers[i], 0.5f + 0.1f * float(i % 8)};
+	}
+	return spheres;
+}
+
+const SphereBvh& GetBvhQueryScene() {
+	static const SphereBvh bvh = [] {
+		std::vector<Sphere> spheres = MakeBvhScene(500000);
+		SphereBvh result;
+		result.Build(spheres.data(), spheres.size());
+		return result;
+	}();
+	return bvh;
+}
+
+// 場面の外 (z の手前) から奥へ向かう半直線
+std::vector<Ray> MakeQueryRays(size_t count) {
+	const float range = std::cbrt(500000.0f) * 5.0f;
+	std::vector<Vector3> origins = MakeRandomVectors(count, range);
+	std::vector<Ray> rays(count);
+	for (size_t i = 0; i < count; ++i) {
+		rays[i] = {{origins[i].x, origins[i].y, -range * 2.0f},
+		           {origins[i].y * 0.1f, origins[i].z * 0.1f, range}};
+	}
+	return rays;
+}
+
+void BM_BvhBuild(BenchmarkContext& context) {
+	std::vector<Sphere> spheres = MakeBvhScene(context.batch);
+	SphereBvh bvh;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		bvh.Build(spheres.data(), spheres.size());
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_BvhRefit(BenchmarkContext& context) {
+	std::vector<Sphere> spheres = MakeBvhScene(context.batch);
+	SphereBvh bvh;
+	bvh.Build(spheres.data(), spheres.size());
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		bvh.Refit(spheres.data(), spheres.size());
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_BvhRaycast(BenchmarkContext& context) {
+	const SphereBvh& bvh = GetBvhQueryScene();
+	std::vector<Ray> rays = MakeQueryRays(context.batch);
+	RayHit hit;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (const Ray& ray : rays) {
+			bvh.Raycast(ray, hit);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_BvhRaycastAll(BenchmarkContext& context) {
+	const SphereBvh& bvh = GetBvhQueryScene();
+	std::vector<Ray> rays = MakeQueryRays(context.batch);
+	std::vector<RayHit> hits;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (const Ray& ray : rays) {
+			bvh.RaycastAll(ray, hits);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+void BM_BvhQueryOverlap(BenchmarkContext& context) {
+	const SphereBvh& bvh = GetBvhQueryScene();
+	std::vector<Vector3> centers = MakeRandomVectors(context.batch, std::cbrt(500000.0f) * 5.0f);
+	std::vector<uint32_t> indices;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		for (const Vector3& center : centers) {
+			bvh.QueryOverlap({center, 20.0f}, indices);
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+/*---------------------------------
+ シーンファイル
+ ・メモリマップで開く (ページキャッシュに載った状態) のと、同じ内容のテキストを読むのを比べる
+------------------------------------*/
+
+// 球とトランスフォームを count 個ずつ持つシーン
+SceneData MakeRandomScene(size_t count) {
+	SceneData scene;
+	scene.sphereCenters = MakeRandomVectors(count, std::cbrt(float(count)) * 5.0f);
+	scene.sphereRadii.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		scene.sphereRadii[i] = 0.5f + 0.1f * float(i % 8);
+	}
+	scene.transformScales.assign(count, {1.0f, 1.0f, 1.0f});
+	scene.transformRotates = MakeRandomVectors(count, 3.14f);
+	scene.transformTranslates = scene.sphereCenters;
+	return scene;
+}
+
+// 一時ディレクトリに書いたシーンファイル (数ごとに一度だけ書く)
+std::string GetSceneFilePath(size_t count) {
+	std::filesystem::path path =
+	    std::filesystem::temp_directory_path() / ("benchmark_" + std::to_string(count) + ".scene");
+	static std::vector<size_t> written;
+	for (size_t writtenCount : written) {
+		if (writtenCount == count) {
+			return path.string();
+		}
+	}
+	std::string error;
+	if (!WriteSceneFile(path.string().c_str(), MakeRandomScene(count), error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		std::abort();
+	}
+	written.push_back(count);
+	return path.string();
+}
+
+void BM_SceneFileOpen(BenchmarkContext& context) {
+	std::string path = GetSceneFilePath(context.batch);
+	SceneFile file;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		if (!file.Open(path.c_str()) || file.GetSphereCount() != context.batch) {
+			std::abort();
+		}
+		file.Close();
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+// 同じ球とトランスフォームをテキストで書いて読む
+void BM_SceneTextParse(BenchmarkContext& context) {
+	SceneData source = MakeRandomScene(context.batch);
+	std::string text;
+	char line[256];
+	for (size_t i = 0; i < context.batch; ++i) {
+		const Vector3& c = source.sphereCenters[i];
+		const Vector3& s = source.transformScales[i];
+		const Vector3& r = source.transformRotates[i];
+		const Vector3& t = source.transformTranslates[i];
+		std::snprintf(
+		    line, sizeof(line), "sphere %g %g %g %g\ntransform %g %g %g %g %g %g %g %g %g\n", c.x,
+		    c.y, c.z, source.sphereRadii[i], s.x, s.y, s.z, r.x, r.y, r.z, t.x, t.y, t.z);
+		text += line;
+	}
+	std::string error;
+	context.StartTimer();
+	for (uint64_t it = 0; it < context.iterations; ++it) {
+		SceneData scene;
+		if (!ParseSceneText(text.data(), text.size(), scene, error)) {
+			std::abort();
+		}
+		ClobberMemory();
+	}
+	context.StopTimer();
+}
+
+const std::vector<size_t> kMathBatches = {64, 4096, 262144};
+const std::vector<size_t> kSphereCounts = {1, 100, 1000};
+const std::vector<size_t> kGridCounts = {10, 100, 1000};
+const std::vector<size_t> kCollisionCounts = {1000, 10000, 100000};
+const std::vector<size_t> kBvhCounts = {1000, 100000, 500000};
+const std::vector<size_t> kBvhQueries = {1, 64, 1024};
+const std::vector<size_t> kSceneCounts = {1000, 100000, 2000000};
+
+const Benchmark kBenchmarks[] = {
+    {"Multiply",                BM_Multiply,                 kMathBatches    },
+    {"MultiplyArray",           BM_MultiplyArray,            kMathBatches    },
+    {"Inverse",                 BM_Inverse,                  kMathBatches    },
+    {"TryInverse",              BM_TryInverse,               kMathBatches    },
+    {"InverseAffine",           BM_InverseAffine,            kMathBatches    },
+    {"InverseRigid",            BM_InverseRigid,             kMathBatches    },
+    {"MakeAffineMatrix",        BM_MakeAffineMatrix,         kMathBatches    },
+    {"MakeAffineMatrices",      BM_MakeAffineMatrices,       kMathBatches    },
+    {"MakeAffineMatricesQuat",  BM_MakeAffineQuaternion,     kMathBatches    },
+    {"MakeAffineRelative",      BM_MakeAffineCameraRelative, kMathBatches    },
+    {"MakeRotateXYZMatrix",     BM_MakeRotateMatrix,         kMathBatches    },
+    {"MakeScaleTranslateMatrix", BM_MakeScaleTranslateMatrix, kMathBatches    },
+    {"MakeProjectionMatrix",    BM_MakeProjectionMatrix,     kMathBatches    },
+    {"Slerp",                   BM_Slerp,                    kMathBatches    },
+    {"SlerpFastArray",          BM_SlerpFastArray,           kMathBatches    },
+    {"TransformHierarchy/10%",  BM_TransformHierarchy,       kMathBatches    },
+    {"TransformHierarchy/All",  BM_TransformHierarchyAll,    kMathBatches    },
+    {"Transform",               BM_Transform,                kMathBatches    },
+    {"TransformArray",          BM_TransformArray,           kMathBatches    },
+    {"TransformArraySoa",       BM_TransformArraySoa,        kMathBatches    },
+    {"TransformArrayFixed",     BM_TransformArrayFixed,      kMathBatches    },
+    {"TransformArray16",        BM_TransformArray16,         kMathBatches    },
+    {"Normalize",               BM_Normalize,                kMathBatches    },
+    {"NormalizeSoa",            BM_NormalizeSoa,             kMathBatches    },
+    {"NormalizeFast",           BM_NormalizeFast,            kMathBatches    },
+    {"Length",                  BM_Length,                   kMathBatches    },
+    {"LengthFast",              BM_LengthFast,               kMathBatches    },
+    {"SinCos",                  BM_SinCos,                   kMathBatches    },
+    {"SinCosFast",              BM_SinCosFast,               kMathBatches    },
+    {"SinCosCoarse",            BM_SinCosCoarse,             kMathBatches    },
+    {"SinCosArrayFast",         BM_SinCosArrayFast,          kMathBatches    },
+    {"Vec3AddSubtractMultiply", BM_Vec3Arithmetic,           kMathBatches    },
+    {"DotCross",                BM_DotCross,                 kMathBatches    },
+    {"Frame/Lines",             BM_FrameLines,               kSphereCounts   },
+    {"Frame/LinesParallel",     BM_FrameLinesParallel,       kSphereCounts   },
+    {"Frame/LinesArena",        BM_FrameLinesArena,          kSphereCounts   },
+    {"Frame/LinesBatch",        BM_FrameLinesBatch,          kSphereCounts   },
+    {"Frame/LinesLargeWorld",   BM_FrameLinesLargeWorld,     kSphereCounts   },
+    {"Frame/LinesCrowd",        BM_FrameLinesCrowd,          kSphereCounts   },
+    {"Frame/Raster",            BM_FrameRaster,              kSphereCounts   },
+    {"Frame/Solid",             BM_FrameSolid,               kSphereCounts   },
+    {"Frame/SolidParallel",     BM_FrameSolidParallel,       kSphereCounts   },
+    {"Grid/Idle",               BM_GridIdle,                 kGridCounts     },
+    {"Grid/Moving",             BM_GridMoving,               kGridCounts     },
+    {"Collision",               BM_Collision,                kCollisionCounts},
+    {"CollisionParallel",       BM_CollisionParallel,        kCollisionCounts},
+    {"Bvh/Build",               BM_BvhBuild,                 kBvhCounts      },
+    {"Bvh/Refit",               BM_BvhRefit,                 kBvhCounts      },
+    {"Bvh/Raycast",             BM_BvhRaycast,               kBvhQueries     },
+    {"Bvh/RaycastAll",          BM_BvhRaycastAll,            kBvhQueries     },
+    {"Bvh/QueryOverlap",        BM_BvhQueryOverlap,          kBvhQueries     },
+    {"SceneFile/Open",          BM_SceneFileOpen,            kSceneCounts    },
+    {"SceneFile/TextParse",     BM_SceneTextParse,           kSceneCounts    },
+};
+
+// 最低 minTimeNs かかるまで回数を増やして計測する
+BenchmarkResult RunBenchmark(
+    const Benchmark& benchmark, size_t batch, double minTimeNs, CacheMissCounter& counter) {
+	BenchmarkContext context{};
+	context.batch = batch;
+	context.counter = &counter;
+	context.iterations = 1;
+	while (true) {
+		benchmark.function(context);
+		if (context.elapsedNs >= minTimeNs || context.iterations >= (1ull << 40)) {
+			break;
+		}
+		// 次で minTimeNs を少し超えるくらいの回数にする (増やしすぎない)
+		double scale = context.elapsedNs > 0.0 ? minTimeNs * 1.4 / context.elapsedNs : 10.0;
+		scale = scale < 2.0 ? 2.0 : (scale > 10.0 ? 10.0 : scale);
+		context.iterations = uint64_t(double(context.iterations) * scale);
+	}
+
+	double ops = double(context.iterations) * double(batch);
+	BenchmarkResult result;
+	result.name = benchmark.name;
+	result.batch = batch;
+	result.iterations = context.iterations;
+	result.nsPerOp = context.elapsedNs / ops;
+	result.opsPerSecond = ops / (context.elapsedNs * 1.0e-9);
+	result.allocationsPerOp = double(context.allocations) / ops;
+	result.cacheMissesPerOp = context.cacheMisses >= 0 ? double(context.cacheMisses) / ops : -1.0;
+	return result;
+}
+
+bool ParseIsa(const char* text, MathIsa& isa) {
+	const struct {
+		const char* name;
+		MathIsa isa;
+	} kIsaNames[] = {
+	    {"scalar", MathIsa::kScalar},
+	    {"sse",    MathIsa::kSse   },
+	    {"avx2",   MathIsa::kAvx2  },
+	    {"avx512", MathIsa::kAvx512},
+	};
+	for (const auto& entry : kIsaNames) {
+		if (std::strcmp(text, entry.name) == 0) {
+			isa = entry.isa;
+			return true;
+		}
+	}
+	return false;
+}
+
+// Google Benchmark の --benchmark_format=json に近い形で書き出す
+bool WriteJson(const char* path, const std::vector<BenchmarkResult>& results) {
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	if (fopen_s(&file, path, "w") != 0) {
+		file = nullptr;
+	}
+#else
+	file = std::fopen(path, "w");
+#endif
+	if (!file) {
+		return false;
+	}
+	std::fprintf(file, "{\n  \"context\": {\n");
+	std::fprintf(file, "    \"cpu_isa\": \"%s\",\n", GetMathIsaName(GetCpuMathIsa()));
+	std::fprintf(file, "    \"kernel_isa\": \"%s\",\n", GetMathIsaName(GetMathKernels().isa));
+	std::fprintf(file, "    \"threads\": %u\n  },\n", gJobSystem->GetWorkerCount());
+	std::fprintf(file, "  \"benchmarks\": [\n");
+	for (size_t i = 0; i < results.size(); ++i) {
+		const BenchmarkResult& r = results[i];
+		std::fprintf(
+		    file,
+		    "    {\"name\": \"%s/%zu\", \"batch\": %zu, \"iterations\": %llu, "
+		    "\"ns_per_op\": %.4f, \"ops_per_second\": %.1f, \"allocations_per_op\": %.5f, "
+		    "\"cache_misses_per_op\": ",
+		    r.name.c_str(), r.batch, r.batch, (unsigned long long)r.iterations, r.nsPerOp,
+		    r.opsPerSecond, r.allocationsPerOp);
+		if (r.cacheMissesPerOp >= 0.0) {
+			std::fprintf(file, "%.5f}", r.cacheMissesPerOp);
+		} else {
+			std::fprintf(file, "null}");
+		}
+		std::fprintf(file, "%s\n", i + 1 < results.size() ? "," : "");
+	}
+	std::fprintf(file, "  ]\n}\n");
+	std::fclose(file);
+	return true;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	const char* filter = nullptr;
+	const char* jsonPath = nullptr;
+	double minTimeNs = 0.2e9;
+	uint32_t threadCount = 0;
+
+	for (int i = 1; i < argc; ++i) {
+		const char* arg = argv[i];
+		if (std::strncmp(arg, "--filter=", 9) == 0) {
+			filter = arg + 9;
+		} else if (std::strncmp(arg, "--json=", 7) == 0) {
+			jsonPath = arg + 7;
+		} else if (std::strncmp(arg, "--min_time=", 11) == 0) {
+			minTimeNs = std::atof(arg + 11) * 1.0e9;
+		} else if (std::strncmp(arg, "--threads=", 10) == 0) {
+			threadCount = uint32_t(std::atoi(arg + 10));
+		} else if (std::strncmp(arg, "--isa=", 6) == 0) {
+			MathIsa isa;
+			if (!ParseIsa(arg + 6, isa)) {
+				std::fprintf(stderr, "unknown isa: %s\n", arg + 6);
+				return 1;
+			}
+			SelectMathKernels(isa);
+		} else {
+			std::fprintf(
+			    stderr,
+			    "usage: %s [--filter=NAME] [--isa=scalar|sse|avx2|avx512] [--threads=N] "
+			    "[--min_time=SEC] [--json=PATH]\n",
+			    argv[0]);
+			return 1;
+		}
+	}
+
+	JobSystem jobSystem(threadCount);
+	gJobSystem = &jobSystem;
+
+	CacheMissCounter counter;
+	std::printf(
+	    "cpu: %s  kernels: %s  threads: %u  cache-miss counter: %s\n",
+	    GetMathIsaName(GetCpuMathIsa()), GetMathIsaName(GetMathKernels().isa),
+	    jobSystem.GetWorkerCount(), counter.IsAvailable() ? "perf" : "n/a");
+	std::printf(
+	    "%-36s %14s %10s %16s %10s %14s\n", "benchmark", "iterations", "ns/op", "ops/s",
+	    "allocs/op", "misses/op");
+
+	std::vector<BenchmarkResult> results;
+	for (const Benchmark& benchmark : kBenchmarks) {
+		if (filter && !std::strstr(benchmark.name, filter)) {
+			continue;
+		}
+		for (size_t batch : benchmark.batches) {
+			BenchmarkResult result = RunBenchmark(benchmark, batch, minTimeNs, counter);
+			std::string label = result.name + "/" + std::to_string(batch);
+			std::printf(
+			    "%-36s %14llu %10.3f %16.0f %10.4f ", label.c_str(),
+			    (unsigned long long)result.iterations, result.nsPerOp, result.opsPerSecond,
+			    result.allocationsPerOp);
+			if (result.cacheMissesPerOp >= 0.0) {
+				std::printf("%14.4f\n", result.cacheMissesPerOp);
+			} else {
+				std::printf("%14s\n", "-");
+			}
+			results.push_back(result);
+		}
+	}
+
+	if (jsonPath && !WriteJson(jsonPath, results)) {
+		std::fprintf(stderr, "failed to write %s\n", jsonPath);
+		return 1;
+	}
+	return 0;
+}
@@ -0,0 +1,425 @@
+﻿#include "Bvh.h"
+#include "Collision.h"
+#include <algorithm>
+#include <cassert>
+#include <limits>
+
+// 葉に入れる球の数の目安
+static const uint32_t kMaxLeafSize = 4;
+// SAH で分け方を探すときのビンの数
+static const int kBinCount = 16;
+// SAH で分ける深さの上限 (これより深いところは中心の並びの真ん中で分ける)
+// 真ん中で分けると 1 段ごとに数が半分になるので、木の深さは 32 + 30 段までに収まる
+static const uint32_t kMaxSahDepth = 32;
+// たどるときのスタックの深さ (深さ + 1 あれば足りる)
+static const int kStackSize = 64;
+
+namespace {
+
+AABB MakeEmptyBounds() {
+	const float kMax = std::numeric_limits<float>::max();
+	return {{kMax, kMax, kMax}, {-kMax, -kMax, -kMax}};
+}
+
+void Grow(AABB& bounds, const Vector3& min, const Vector3& max) {
+	bounds.min = {std::min(bounds.min.x, min.x), std::min(bounds.min.y, min.y),
+	              std::min(bounds.min.z, min.z)};
+	bounds.max = {std::max(bounds.max.x, max.x), std::max(bounds.max.y, max.y),
+	              std::max(bounds.max.z, max.z)};
+}
+
+void Grow(AABB& bounds, const Sphere& sphere) {
+	Vector3 r{sphere.radius, sphere.radius, sphere.radius};
+	Grow(bounds, Vec3Subtract(sphere.center, r), Vec3Add(sphere.center, r));
+}
+
+// 表面積の半分 (SAH では比しか使わない)
+float HalfArea(const AABB& bounds) {
+	Vector3 d = Vec3Subtract(bounds.max, bounds.min);
+	if (d.x < 0.0f) {
+		return 0.0f;
+	}
+	return d.x * d.y + d.y * d.z + d.z * d.x;
+}
+
+float GetAxis(const Vector3& v, int axis) { return axis == 0 ? v.x : (axis == 1 ? v.y : v.z); }
+
+// 箱が最も長い軸 (どの軸も長さ 0 なら -1)
+int GetLongestAxis(const AABB& bounds) {
+	int longest = -1;
+	float longestExtent = 0.0f;
+	for (int axis = 0; axis < 3; ++axis) {
+		float extent = GetAxis(bounds.max, axis) - GetAxis(bounds.min, axis);
+		if (extent > longestExtent) {
+			longest = axis;
+			longestExtent = extent;
+		}
+	}
+	return longest;
+}
+
+// 半直線と箱が [0, maxT] の中で交わるか (スラブ法)。交わるなら入る t を返す
+bool IntersectBounds(
+    const Vector3& min, const Vector3& max, const Vector3& origin, const Vector3& invDiff,
+    float maxT, float& tEnter) {
+	float tx1 = (min.x - origin.x) * invDiff.x;
+	float tx2 = (max.x - origin.x) * invDiff.x;
+	float tNear = std::min(tx1, tx2);
+	float tFar = std::max(tx1, tx2);
+	float ty1 = (min.y - origin.y) * invDiff.y;
+	float ty2 = (max.y - origin.y) * invDiff.y;
+	tNear = std::max(tNear, std::min(ty1, ty2));
+	tFar = std::min(tFar, std::max(ty1, ty2));
+	float tz1 = (min.z - origin.z) * invDiff.z;
+	float tz2 = (max.z - origin.z) * invDiff.z;
+	tNear = std::max(tNear, std::min(tz1, tz2));
+	tFar = std::min(tFar, std::max(tz1, tz2));
+	tEnter = std::max(tNear, 0.0f);
+	return tEnter <= tFar && tEnter <= maxT;
+}
+
+} // namespace
+
+void SphereBvh::ComputeBounds(Node& node) const {
+	AABB bounds = MakeEmptyBounds();
+	for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+		Grow(bounds, spheres_[i]);
+	}
+	node.min = bounds.min;
+	node.max = bounds.max;
+}
+
+void SphereBvh::Build(const Sphere* spheres, size_t count) {
+	assert(count < std::numeric_limits<uint32_t>::max());
+	spheres_.assign(spheres, spheres + count);
+	indices_.resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		indices_[i] = uint32_t(i);
+	}
+	nodes_.clear();
+	depth_ = 0;
+	if (count == 0) {
+		return;
+	}
+	// 子は必ず 2 つずつ増えるので、ノードは多くても 2 * count - 1 個
+	nodes_.reserve(count * 2 - 1);
+	nodes_.push_back({});
+	nodes_[0].first = 0;
+	nodes_[0].count = uint32_t(count);
+	ComputeBounds(nodes_[0]);
+
+	struct Bin {
+		AABB bounds;
+		uint32_t count;
+	};
+
+	// 分ける前のノードと深さ
+	struct Pending {
+		uint32_t node;
+		uint32_t depth;
+	};
+	std::vector<Pending> pending = {{0, 0}};
+	// 真ん中で分けるときの並べ替えの作業用
+	std::vector<uint32_t> order;
+	std::vector<Sphere> sortedSpheres;
+	std::vector<uint32_t> sortedIndices;
+	while (!pending.empty()) {
+		const Pending current = pending.back();
+		pending.pop_back();
+		depth_ = std::max(depth_, current.depth);
+		Node& node = nodes_[current.node];
+		if (node.count <= kMaxLeafSize) {
+			continue;
+		}
+
+		// 中心の範囲でビンを切る
+		AABB centerBounds = MakeEmptyBounds();
+		for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+			Grow(centerBounds, spheres_[i].center, spheres_[i].center);
+		}
+
+		// 3 軸それぞれのビンの境目で分けたときの SAH コストを比べる
+		// (深すぎるときは調べずに真ん中で分ける)
+		const bool useSah = current.depth < kMaxSahDepth;
+		int bestAxis = -1;
+		int bestSplit = 0;
+		float bestCost = std::numeric_limits<float>::max();
+		for (int axis = 0; useSah && axis < 3; ++axis) {
+			float lo = GetAxis(centerBounds.min, axis);
+			float extent = GetAxis(centerBounds.max, axis) - lo;
+			if (extent <= 0.0f) {
+				continue;
+			}
+			float scale = float(kBinCount) / extent;
+			Bin bins[kBinCount];
+			for (Bin& bin : bins) {
+				bin = {MakeEmptyBounds(), 0};
+			}
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				float position = GetAxis(spheres_[i].center, axis) - lo;
+				int b = std::min(kBinCount - 1, int(position * scale));
+				Grow(bins[b].bounds, spheres_[i]);
+				++bins[b].count;
+			}
+			// 左から足した面積と数、右から足した面積と数
+			float leftArea[kBinCount - 1];
+			uint32_t leftCount[kBinCount - 1];
+			AABB left = MakeEmptyBounds();
+			uint32_t leftSum = 0;
+			for (int b = 0; b < kBinCount - 1; ++b) {
+				Grow(left, bins[b].bounds.min, bins[b].bounds.max);
+				leftSum += bins[b].count;
+				leftArea[b] = HalfArea(left);
+				leftCount[b] = leftSum;
+			}
+			AABB right = MakeEmptyBounds();
+			uint32_t rightSum = 0;
+			for (int b = kBinCount - 1; b > 0; --b) {
+				Grow(right, bins[b].bounds.min, bins[b].bounds.max);
+				rightSum += bins[b].count;
+				if (leftCount[b - 1] == 0 || rightSum == 0) {
+					continue;
+				}
+				float cost =
+				    leftArea[b - 1] * float(leftCount[b - 1]) + HalfArea(right) * float(rightSum);
+				if (cost < bestCost) {
+					bestCost = cost;
+					bestAxis = axis;
+					bestSplit = b;
+				}
+			}
+		}
+		uint32_t leftCount;
+		if (bestAxis >= 0) {
+			AABB nodeBounds{node.min, node.max};
+			float leafCost = HalfArea(nodeBounds) * float(node.count);
+			if (bestCost >= leafCost && node.count <= kMaxLeafSize * 4) {
+				// 分けても得をしない
+				continue;
+			}
+			leftCount = PartitionAtBin(node, centerBounds, bestAxis, bestSplit);
+		} else {
+			// 深すぎるか、面積が大きすぎて SAH で比べられない (無限大になる)
+			int axis = GetLongestAxis(centerBounds);
+			if (axis < 0) {
+				// 中心がすべて同じ点にあるので分けられない
+				continue;
+			}
+			leftCount = PartitionAtMedian(node, axis, order, sortedSpheres, sortedIndices);
+		}
+		assert(leftCount > 0 && leftCount < node.count);
+
+		uint32_t childIndex = uint32_t(nodes_.size());
+		Node leftNode{};
+		leftNode.first = node.first;
+		leftNode.count = leftCount;
+		ComputeBounds(leftNode);
+		Node rightNode{};
+		rightNode.first = node.first + leftCount;
+		rightNode.count = node.count - leftCount;
+		ComputeBounds(rightNode);
+		// reserve してあるので node は無効にならない
+		nodes_.push_back(leftNode);
+		nodes_.push_back(rightNode);
+		node.first = childIndex;
+		node.count = 0;
+		pending.push_back({childIndex, current.depth + 1});
+		pending.push_back({childIndex + 1, current.depth + 1});
+	}
+	assert(depth_ < uint32_t(kStackSize));
+}
+
+uint32_t SphereBvh::PartitionAtBin(
+    const Node& node, const AABB& centerBounds, int axis, int split) {
+	float lo = GetAxis(centerBounds.min, axis);
+	float scale = float(kBinCount) / (GetAxis(centerBounds.max, axis) - lo);
+	auto isLeft = [&](const Sphere& sphere) {
+		int b = std::min(kBinCount - 1, int((GetAxis(sphere.center, axis) - lo) * scale));
+		return b < split;
+	};
+	// 球と番号を一緒に動かす
+	uint32_t i = node.first;
+	uint32_t j = node.first + node.count;
+	while (i < j) {
+		if (isLeft(spheres_[i])) {
+			++i;
+		} else {
+			--j;
+			std::swap(spheres_[i], spheres_[j]);
+			std::swap(indices_[i], indices_[j]);
+		}
+	}
+	return i - node.first;
+}
+
+uint32_t SphereBvh::PartitionAtMedian(
+    const Node& node, int axis, std::vector<uint32_t>& order, std::vector<Sphere>& sortedSpheres,
+    std::vector<uint32_t>& sortedIndices) {
+	// 中心が同じなら元の番号の順にして、処理系によらず同じ木にする
+	order.resize(node.count);
+	for (uint32_t i = 0; i < node.count; ++i) {
+		order[i] = node.first + i;
+	}
+	std::sort(order.begin(), order.end(), [&](uint32_t a, uint32_t b) {
+		float ca = GetAxis(spheres_[a].center, axis);
+		float cb = GetAxis(spheres_[b].center, axis);
+		return ca < cb || (ca == cb && indices_[a] < indices_[b]);
+	});
+	sortedSpheres.resize(node.count);
+	sortedIndices.resize(node.count);
+	for (uint32_t i = 0; i < node.count; ++i) {
+		sortedSpheres[i] = spheres_[order[i]];
+		sortedIndices[i] = indices_[order[i]];
+	}
+	std::copy(sortedSpheres.begin(), sortedSpheres.end(), spheres_.begin() + node.first);
+	std::copy(sortedIndices.begin(), sortedIndices.end(), indices_.begin() + node.first);
+	return node.count / 2;
+}
+
+void SphereBvh::Refit(const Sphere* spheres, size_t count) {
+	assert(count == spheres_.size());
+	(void)count;
+	for (size_t i = 0; i < spheres_.size(); ++i) {
+		spheres_[i] = spheres[indices_[i]];
+	}
+	// 子は親より後ろにあるので、後ろから直せば子が先に終わっている
+	for (size_t n = nodes_.size(); n-- > 0;) {
+		Node& node = nodes_[n];
+		if (node.count > 0) {
+			ComputeBounds(node);
+		} else {
+			const Node& left = nodes_[node.first];
+			const Node& right = nodes_[node.first + 1];
+			AABB bounds{left.min, left.max};
+			Grow(bounds, right.min, right.max);
+			node.min = bounds.min;
+			node.max = bounds.max;
+		}
+	}
+}
+
+template<typename OnHit>
+void SphereBvh::Traverse(const Ray& ray, float maxT, OnHit onHit) const {
+	if (nodes_.empty()) {
+		return;
+	}
+	// diff の成分が 0 なら無限大になり、スラブ法はそのまま動く
+	const Vector3 invDiff{1.0f / ray.diff.x, 1.0f / ray.diff.y, 1.0f / ray.diff.z};
+
+	struct StackEntry {
+		uint32_t node;
+		float tEnter;
+	};
+	StackEntry stack[kStackSize];
+	int top = 0;
+	float tEnter;
+	if (!IntersectBounds(nodes_[0].min, nodes_[0].max, ray.origin, invDiff, maxT, tEnter)) {
+		return;
+	}
+	stack[top++] = {0, tEnter};
+
+	while (top > 0) {
+		StackEntry entry = stack[--top];
+		if (entry.tEnter > maxT) {
+			// 積んだあとにもっと近い球が見つかった
+			continue;
+		}
+		const Node& node = nodes_[entry.node];
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				float t;
+				if (Intersect(ray, spheres_[i], t) && t <= maxT) {
+					maxT = onHit(i, t);
+				}
+			}
+			continue;
+		}
+
+		// 近い方の子を先に調べるよう、遠い方から積む
+		uint32_t nearChild = node.first;
+		uint32_t farChild = node.first + 1;
+		float tNear;
+		float tFar;
+		bool hitNear = IntersectBounds(
+		    nodes_[nearChild].min, nodes_[nearChild].max, ray.origin, invDiff, maxT, tNear);
+		bool hitFar = IntersectBounds(
+		    nodes_[farChild].min, nodes_[farChild].max, ray.origin, invDiff, maxT, tFar);
+		if (hitNear && hitFar && tFar < tNear) {
+			std::swap(nearChild, farChild);
+			std::swap(tNear, tFar);
+		}
+		assert(top + 2 <= kStackSize);
+		if (hitFar) {
+			stack[top++] = {farChild, tFar};
+		}
+		if (hitNear) {
+			stack[top++] = {nearChild, tNear};
+		}
+	}
+}
+
+bool SphereBvh::Raycast(const Ray& ray, RayHit& hit) const {
+	uint32_t bestPosition = std::numeric_limits<uint32_t>::max();
+	float bestT = std::numeric_limits<float>::max();
+	Traverse(ray, bestT, [&](uint32_t position, float t) {
+		if (t < bestT || (t == bestT && indices_[position] < indices_[bestPosition])) {
+			bestT = t;
+			bestPosition = position;
+		}
+		return bestT;
+	});
+	if (bestPosition == std::numeric_limits<uint32_t>::max()) {
+		return false;
+	}
+	hit = {indices_[bestPosition], bestT};
+	return true;
+}
+
+void SphereBvh::RaycastAll(const Ray& ray, std::vector<RayHit>& hits) const {
+	hits.clear();
+	const float kMaxT = std::numeric_limits<float>::max();
+	Traverse(ray, kMaxT, [&](uint32_t position, float t) {
+		hits.push_back({indices_[position], t});
+		return kMaxT;
+	});
+	std::sort(hits.begin(), hits.end(), [](const RayHit& a, const RayHit& b) {
+		return a.t < b.t || (a.t == b.t && a.index < b.index);
+	});
+}
+
+void SphereBvh::QueryOverlap(const Sphere& sphere, std::vector<uint32_t>& indices) const {
+	indices.clear();
+	if (nodes_.empty()) {
+		return;
+	}
+	uint32_t stack[kStackSize];
+	int top = 0;
+	stack[top++] = 0;
+	while (top > 0) {
+		const Node& node = nodes_[stack[--top]];
+		if (!IsCollision(AABB{node.min, node.max}, sphere)) {
+			continue;
+		}
+		if (node.count > 0) {
+			for (uint32_t i = node.first; i < node.first + node.count; ++i) {
+				if (IsCollision(spheres_[i], sphere)) {
+					indices.push_back(indices_[i]);
+				}
+			}
+			continue;
+		}
+		assert(top + 2 <= kStackSize);
+		stack[top++] = node.first + 1;
+		stack[top++] = node.first;
+	}
+}
+
+Ray MakeScreenRay(
+    float screenX, float screenY, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix) {
+	// スクリーン座標の深度 0 が近クリップ面、1 が遠クリップ面
+	Matrix4x4 inverse = Inverse(Multiply(viewProjectionMatrix, viewportMatrix));
+	Vector3 nearPoint = Transform({screenX, screenY, 0.0f}, inverse);
+	Vector3 farPoint = Transform({screenX, screenY, 1.0f}, inverse);
+	return {nearPoint, Vec3Subtract(farPoint, nearPoint)};
+}
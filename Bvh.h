@@ -0,0 +1,77 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include "Shape.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ 球の BVH (バウンディングボリューム階層)
+ ・ビン分割の SAH で作り、ノードは 1 本の配列に並べる (子は親より後ろ、兄弟は隣同士)
+ ・偏った配置で SAH が少しずつしか分けずに深くなったら、中心の並びの真ん中で分けて深さを抑える
+   (たどるときのスタックは固定の大きさ)
+ ・葉の球は葉の順にコピーしておき、調べるときに元の配列を引かない
+ ・球が動いたら Refit で箱だけ直す (木の形は変えない。大きく動いたら Build し直す)
+------------------------------------*/
+
+// 半直線が当たった球 (index は Build に渡した配列の番号)
+struct RayHit {
+	uint32_t index;
+	float t;
+};
+
+class SphereBvh {
+public:
+	// 作り直す
+	void Build(const Sphere* spheres, size_t count);
+	// Build と同じ数・同じ並びの球で箱を直す
+	void Refit(const Sphere* spheres, size_t count);
+
+	// 最初に当たる球 (なければ false)
+	bool Raycast(const Ray& ray, RayHit& hit) const;
+	// 当たる球をすべて t の小さい順に出す (hits は一度空にする)
+	void RaycastAll(const Ray& ray, std::vector<RayHit>& hits) const;
+	// sphere と重なる球の番号をすべて出す (indices は一度空にする)
+	void QueryOverlap(const Sphere& sphere, std::vector<uint32_t>& indices) const;
+
+	size_t GetCount() const { return spheres_.size(); }
+	size_t GetNodeCount() const { return nodes_.size(); }
+	// 根から最も深い葉までの段数 (根だけなら 0)
+	uint32_t GetDepth() const { return depth_; }
+
+private:
+	// 32 バイト (キャッシュライン 1 本に 2 つ)
+	// count が 0 なら内部ノードで子は first と first + 1、そうでなければ葉で球は [first, first + count)
+	struct Node {
+		Vector3 min;
+		uint32_t first;
+		Vector3 max;
+		uint32_t count;
+	};
+
+	// [first, first + count) の球を囲む箱
+	void ComputeBounds(Node& node) const;
+	// node の球を並べ替えて左の子に入る数を返す
+	// ビンの境目 split より前を左にする
+	uint32_t PartitionAtBin(const Node& node, const AABB& centerBounds, int axis, int split);
+	// 中心の並びの真ん中で分ける (作業用の配列を使い回す)
+	uint32_t PartitionAtMedian(
+	    const Node& node, int axis, std::vector<uint32_t>& order,
+	    std::vector<Sphere>& sortedSpheres, std::vector<uint32_t>& sortedIndices);
+	// 半直線をたどり、当たった球ごとに onHit(球の位置, t) を呼ぶ
+	// onHit が返した値より遠い箱は調べない
+	template<typename OnHit>
+	void Traverse(const Ray& ray, float maxT, OnHit onHit) const;
+
+	std::vector<Node> nodes_;
+	// 葉の順に並べた球と、元の番号
+	std::vector<Sphere> spheres_;
+	std::vector<uint32_t> indices_;
+	uint32_t depth_ = 0;
+};
+
+// 画面上の点 (スクリーン座標) からカメラの向きに伸びる半直線
+// t = 0 が近クリップ面、t = 1 が遠クリップ面
+Ray MakeScreenRay(
+    float screenX, float screenY, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix);
@@ -0,0 +1,30 @@
+﻿#include "CameraRelative.h"
+#include "Profiler.h"
+
+void ToCameraRelativeArray(
+    const Vector3d* positions, Vector3* results, size_t count, const Vector3d& cameraPosition) {
+	PROFILE_SCOPE("ToCameraRelativeArray");
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = ToCameraRelative(positions[i], cameraPosition);
+	}
+}
+
+Matrix4x4 MakeCameraRelativeViewMatrix(const Vector3& cameraRotate) {
+	Matrix4x4 cameraMatrix =
+	    MakeAffineMatrix({1.0f, 1.0f, 1.0f}, cameraRotate, {0.0f, 0.0f, 0.0f});
+	// スケールも平行移動もないので回転の転置で逆行列が求まる
+	return InverseRigid(cameraMatrix);
+}
+
+void MakeCameraRelativeAffineMatrices(
+    const Vector3* scales, const Vector3* rotates, const Vector3d* translates,
+    const Vector3d& cameraPosition, Matrix4x4* results, size_t count) {
+	// 相対位置は区切りごとにスタックに作って MakeAffineMatrices に渡す
+	const size_t kChunkSize = 256;
+	Vector3 relatives[kChunkSize];
+	for (size_t begin = 0; begin < count; begin += kChunkSize) {
+		size_t chunk = count - begin < kChunkSize ? count - begin : kChunkSize;
+		ToCameraRelativeArray(&translates[begin], relatives, chunk, cameraPosition);
+		MakeAffineMatrices(&scales[begin], &rotates[begin], relatives, &results[begin], chunk);
+	}
+}
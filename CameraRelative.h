@@ -0,0 +1,31 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cstddef>
+
+/*---------------------------------
+ カメラ基準の座標 (原点から遠い大きなワールド用)
+ ・位置は double (Vector3d) で持ち、フレームの最初にカメラからの相対位置にして float に落とす
+ ・double のまま引いてから落とすので、カメラの近くの物は原点から遠くても桁が残る
+ ・ビュー行列はカメラを原点に置いた回転だけの行列になり、大きな平行移動どうしを
+   float の行列の積で打ち消すことがなくなる
+ ・落とした後の変換 (MakeAffineMatrices, TransformArray, DrawSpheres など) は今までどおり
+   float の SIMD 版を使う
+------------------------------------*/
+
+// カメラからの相対位置
+constexpr Vector3 ToCameraRelative(const Vector3d& position, const Vector3d& cameraPosition) {
+	return Vec3Cast<float>(Vec3Subtract(position, cameraPosition));
+}
+
+// カメラからの相対位置 (配列の一括変換。results は count 個分確保しておくこと)
+void ToCameraRelativeArray(
+    const Vector3d* positions, Vector3* results, size_t count, const Vector3d& cameraPosition);
+
+// カメラを原点に置いたビュー行列 (回転だけ)
+Matrix4x4 MakeCameraRelativeViewMatrix(const Vector3& cameraRotate);
+
+// アフィン変換 (平行移動を double で受け取り、カメラからの相対位置にして作る)
+// results は count 個分確保しておくこと
+void MakeCameraRelativeAffineMatrices(
+    const Vector3* scales, const Vector3* rotates, const Vector3d* translates,
+    const Vector3d& cameraPosition, Matrix4x4* results, size_t count);
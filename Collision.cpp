@@ -0,0 +1,257 @@
+﻿#include "Collision.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+
+// セル座標 1 軸分のビット数 (番号は z, y, x の順に詰める)
+static const int kCellBits = 21;
+// 負の座標も扱えるように足しておく値
+static const int64_t kCellBias = int64_t(1) << (kCellBits - 1);
+// 隣のセルへの番号の差
+static const int64_t kCellStrideY = int64_t(1) << kCellBits;
+static const int64_t kCellStrideZ = int64_t(1) << (kCellBits * 2);
+// セルに入らない球の番号 (並びの最後に集まる)
+static const uint64_t kOverflowKey = UINT64_MAX;
+// セル座標の範囲 (隣のセル ±1 まで番号が溢れない)
+static const float kCellLimit = float(kCellBias - 2);
+// 並列版で 1 ジョブが受け持つ要素数
+static const size_t kEntriesPerJob = 4096;
+
+bool Intersect(const Ray& ray, const Sphere& sphere, float& t) {
+	// |m + t * diff|^2 = r^2 を解く (m = origin - center)
+	Vector3 m = Vec3Subtract(ray.origin, sphere.center);
+	float c = Dot(m, m) - sphere.radius * sphere.radius;
+	if (c <= 0.0f) {
+		t = 0.0f;
+		return true;
+	}
+	float b = Dot(m, ray.diff);
+	if (b >= 0.0f) {
+		// 外にいて遠ざかる向き
+		return false;
+	}
+	float a = Dot(ray.diff, ray.diff);
+	// 判別式 b^2 - a * c は遠くの球で大きな数どうしの引き算になり桁が落ちるので、
+	// 中心から直線までの距離で a * (r^2 - |m - (b / a) * diff|^2) として求める
+	Vector3 closest = Vec3Subtract(m, Vec3Multiply(b / a, ray.diff));
+	float discriminant = a * (sphere.radius * sphere.radius - Dot(closest, closest));
+	if (discriminant < 0.0f) {
+		return false;
+	}
+	// 近い方の解 (-b - sqrt) / a は c / (-b + sqrt) と同じで、こちらは引き算がない
+	t = c / (-b + std::sqrt(discriminant));
+	return true;
+}
+
+SphereBroadphase::SphereBroadphase(float cellSize)
+    : cellSize_(cellSize), invCellSize_(1.0f / cellSize) {
+	assert(cellSize > 0.0f);
+}
+
+// 切り捨て (std::floor は SSE4.1 がないと関数呼び出しになるので整数変換で求める)
+static int64_t FloorToInt(float value) {
+	int64_t truncated = int64_t(value);
+	return truncated - int64_t(value < float(truncated));
+}
+
+uint64_t SphereBroadphase::ComputeKey(const Sphere& sphere) const {
+	// 直径がセルより大きいと隣のセルだけでは足りない
+	if (!(sphere.radius * 2.0f <= cellSize_)) {
+		return kOverflowKey;
+	}
+	float cellX = sphere.center.x * invCellSize_;
+	float cellY = sphere.center.y * invCellSize_;
+	float cellZ = sphere.center.z * invCellSize_;
+	// 範囲外や NaN は整数にすると壊れるので先に外す
+	if (!(std::fabs(cellX) <= kCellLimit && std::fabs(cellY) <= kCellLimit &&
+	      std::fabs(cellZ) <= kCellLimit)) {
+		return kOverflowKey;
+	}
+	int64_t x = FloorToInt(cellX) + kCellBias;
+	int64_t y = FloorToInt(cellY) + kCellBias;
+	int64_t z = FloorToInt(cellZ) + kCellBias;
+	return uint64_t(x + y * kCellStrideY + z * kCellStrideZ);
+}
+
+void SphereBroadphase::Update(const Sphere* spheres, size_t count) {
+	if (entries_.size() != count) {
+		// 作り直し
+		entries_.resize(count);
+		for (size_t i = 0; i < count; ++i) {
+			entries_[i] = {ComputeKey(spheres[i]), uint32_t(i), spheres[i]};
+		}
+		std::sort(entries_.begin(), entries_.end(), IsOrdered);
+		UpdateOverflowBegin();
+		return;
+	}
+
+	// セルが変わらなかった要素は並びを保ったまま前に詰め、変わった要素は取り出す
+	moved_.clear();
+	size_t kept = 0;
+	for (size_t i = 0; i < count; ++i) {
+		Entry entry = entries_[i];
+		const Sphere& sphere = spheres[entry.index];
+		entry.sphere = sphere;
+		uint64_t key = ComputeKey(sphere);
+		if (key == entry.key) {
+			entries_[kept++] = entry;
+		} else {
+			entry.key = key;
+			moved_.push_back(entry);
+		}
+	}
+	if (moved_.empty()) {
+		UpdateOverflowBegin();
+		return;
+	}
+
+	// 取り出した分だけ並べて、後ろから併合する
+	std::sort(moved_.begin(), moved_.end(), IsOrdered);
+	size_t write = count;
+	size_t keptIndex = kept;
+	size_t movedIndex = moved_.size();
+	while (movedIndex > 0) {
+		if (keptIndex > 0 && IsOrdered(moved_[movedIndex - 1], entries_[keptIndex - 1])) {
+			entries_[--write] = entries_[--keptIndex];
+		} else {
+			entries_[--write] = moved_[--movedIndex];
+		}
+	}
+	UpdateOverflowBegin();
+}
+
+void SphereBroadphase::UpdateOverflowBegin() {
+	overflowBegin_ = entries_.size();
+	while (overflowBegin_ > 0 && entries_[overflowBegin_ - 1].key == kOverflowKey) {
+		--overflowBegin_;
+	}
+}
+
+void SphereBroadphase::FindOverflowPairs(std::vector<CollisionPair>& pairs) const {
+	const size_t count = entries_.size();
+	for (size_t i = overflowBegin_; i < count; ++i) {
+		const Entry& e1 = entries_[i];
+		// セルに入った球すべてと、自分より後ろのセルに入らない球
+		for (size_t j = 0; j < count; ++j) {
+			if (j >= overflowBegin_ && j <= i) {
+				continue;
+			}
+			const Entry& e2 = entries_[j];
+			if (IsCollision(e1.sphere, e2.sphere)) {
+				pairs.push_back(
+				    e1.index < e2.index ? CollisionPair{e1.index, e2.index}
+				                        : CollisionPair{e2.index, e1.index});
+			}
+		}
+	}
+}
+
+void SphereBroadphase::FindPairsInRange(
+    size_t begin, size_t end, std::vector<CollisionPair>& pairs) const {
+	// セルに入らない球は FindOverflowPairs で調べる
+	const size_t count = overflowBegin_;
+	end = std::min(end, count);
+	// 前の範囲から続いているセルは飛ばす
+	while (begin > 0 && begin < end && entries_[begin].key == entries_[begin - 1].key) {
+		++begin;
+	}
+	if (begin >= end) {
+		return;
+	}
+
+	// 重複しないよう、自分のセルと「後ろ側」の隣だけ調べる
+	// ・同じ行 (y, z が同じ) の x + 1
+	// ・(y + 1, z), (y - 1, z + 1), (y, z + 1), (y + 1, z + 1) の行の x - 1 から x + 1
+	const int64_t kRowOffsets[] = {
+	    kCellStrideY,
+	    -kCellStrideY + kCellStrideZ,
+	    kCellStrideZ,
+	    kCellStrideY + kCellStrideZ,
+	};
+	const size_t kRowCount = sizeof(kRowOffsets) / sizeof(kRowOffsets[0]);
+	// 各行の探索位置 (セル番号は増える一方なので後戻りしない)
+	size_t rowCursors[kRowCount] = {};
+	for (size_t row = 0; row < kRowCount; ++row) {
+		const uint64_t first = uint64_t(int64_t(entries_[begin].key) + kRowOffsets[row]) - 1;
+		rowCursors[row] = size_t(
+		    std::lower_bound(
+		        entries_.begin() + begin, entries_.end(), first,
+		        [](const Entry& entry, uint64_t key) { return entry.key < key; }) -
+		    entries_.begin());
+	}
+
+	auto testPair = [&pairs](const Entry& e1, const Entry& e2) {
+		if (IsCollision(e1.sphere, e2.sphere)) {
+			pairs.push_back(
+			    e1.index < e2.index ? CollisionPair{e1.index, e2.index}
+			                        : CollisionPair{e2.index, e1.index});
+		}
+	};
+
+	size_t cellBegin = begin;
+	while (cellBegin < end) {
+		const uint64_t key = entries_[cellBegin].key;
+		size_t cellEnd = cellBegin + 1;
+		while (cellEnd < count && entries_[cellEnd].key == key) {
+			++cellEnd;
+		}
+
+		// 同じセルの中
+		for (size_t i = cellBegin; i < cellEnd; ++i) {
+			for (size_t j = i + 1; j < cellEnd; ++j) {
+				testPair(entries_[i], entries_[j]);
+			}
+		}
+
+		// 同じ行の x + 1 (並びのすぐ後ろにある)
+		for (size_t j = cellEnd; j < count && entries_[j].key == key + 1; ++j) {
+			for (size_t i = cellBegin; i < cellEnd; ++i) {
+				testPair(entries_[i], entries_[j]);
+			}
+		}
+
+		// 後ろ側の 4 行 (x - 1 から x + 1 は番号が連続している)
+		for (size_t row = 0; row < kRowCount; ++row) {
+			const uint64_t first = uint64_t(int64_t(key) + kRowOffsets[row]) - 1;
+			const uint64_t last = first + 2;
+			size_t& cursor = rowCursors[row];
+			while (cursor < count && entries_[cursor].key < first) {
+				++cursor;
+			}
+			for (size_t j = cursor; j < count && entries_[j].key <= last; ++j) {
+				for (size_t i = cellBegin; i < cellEnd; ++i) {
+					testPair(entries_[i], entries_[j]);
+				}
+			}
+		}
+
+		cellBegin = cellEnd;
+	}
+}
+
+void SphereBroadphase::FindPairs(std::vector<CollisionPair>& pairs) const {
+	pairs.clear();
+	FindPairsInRange(0, entries_.size(), pairs);
+	FindOverflowPairs(pairs);
+}
+
+void SphereBroadphase::FindPairs(std::vector<CollisionPair>& pairs, JobSystem& jobSystem) {
+	pairs.clear();
+	const size_t count = entries_.size();
+	const size_t chunkCount = (count + kEntriesPerJob - 1) / kEntriesPerJob;
+	if (chunkPairs_.size() < chunkCount) {
+		chunkPairs_.resize(chunkCount);
+	}
+
+	jobSystem.ParallelFor(count, kEntriesPerJob, [this](size_t begin, size_t end, uint32_t) {
+		std::vector<CollisionPair>& chunk = chunkPairs_[begin / kEntriesPerJob];
+		chunk.clear();
+		FindPairsInRange(begin, end, chunk);
+	});
+
+	// チャンク順につなげば 1 スレッド版と同じ順になる
+	for (size_t i = 0; i < chunkCount; ++i) {
+		pairs.insert(pairs.end(), chunkPairs_[i].begin(), chunkPairs_[i].end());
+	}
+	FindOverflowPairs(pairs);
+}
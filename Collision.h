@@ -0,0 +1,123 @@
+﻿#pragma once
+#include "JobSystem.h"
+#include "Mathfunction.h"
+#include "Shape.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ 衝突判定
+ ・距離は 2 乗のまま比べて sqrt を使わない
+------------------------------------*/
+
+// 球と球
+constexpr bool IsCollision(const Sphere& s1, const Sphere& s2) {
+	Vector3 d = Vec3Subtract(s2.center, s1.center);
+	float radius = s1.radius + s2.radius;
+	return LengthSquared(d) <= radius * radius;
+}
+
+// 球と平面
+constexpr bool IsCollision(const Sphere& sphere, const Plane& plane) {
+	float distance = Dot(plane.normal, sphere.center) - plane.distance;
+	return distance * distance <= sphere.radius * sphere.radius;
+}
+
+// 線分上で point に最も近い点
+constexpr Vector3 ClosestPoint(const Vector3& point, const Segment& segment) {
+	float lengthSquared = LengthSquared(segment.diff);
+	if (lengthSquared == 0.0f) {
+		return segment.origin;
+	}
+	float t = Dot(Vec3Subtract(point, segment.origin), segment.diff) / lengthSquared;
+	t = t < 0.0f ? 0.0f : (t > 1.0f ? 1.0f : t);
+	return Vec3Add(segment.origin, Vec3Multiply(t, segment.diff));
+}
+
+// 球と線分
+constexpr bool IsCollision(const Sphere& sphere, const Segment& segment) {
+	Vector3 d = Vec3Subtract(sphere.center, ClosestPoint(sphere.center, segment));
+	return LengthSquared(d) <= sphere.radius * sphere.radius;
+}
+
+// 箱と球 (箱の中で球の中心に最も近い点までの距離で比べる)
+constexpr bool IsCollision(const AABB& aabb, const Sphere& sphere) {
+	auto clamp = [](float v, float lo, float hi) { return v < lo ? lo : (v > hi ? hi : v); };
+	Vector3 closest{
+	    clamp(sphere.center.x, aabb.min.x, aabb.max.x),
+	    clamp(sphere.center.y, aabb.min.y, aabb.max.y),
+	    clamp(sphere.center.z, aabb.min.z, aabb.max.z),
+	};
+	Vector3 d = Vec3Subtract(sphere.center, closest);
+	return LengthSquared(d) <= sphere.radius * sphere.radius;
+}
+
+// 半直線と球が交わるなら最初に当たる t (origin + t * diff) を返す
+// origin が球の中にあるときは t = 0
+bool Intersect(const Ray& ray, const Sphere& sphere, float& t);
+
+// 衝突している球の組 (a < b。Update に渡した配列の番号)
+struct CollisionPair {
+	uint32_t a;
+	uint32_t b;
+};
+
+/*---------------------------------
+ 球のブロードフェーズ (一様グリッド)
+ ・中心が入るセルの番号順に並べた配列を持ち、毎フレーム差分だけ並べ直す
+ ・セルが変わった球だけを取り出して並べ、残りの並びに併合するので
+   少しずつ動く球なら O(N + 動いた数 log 動いた数)
+ ・隣のセルは番号に一定値を足せば求まるので、配列を前から 1 回なめるだけで組を探せる
+ ・隣のセルまでしか調べないので、直径がセルより大きい球と、中心がセル番号の範囲
+   (原点から各軸 ±約 100 万セル) の外にある球はセルに入れず、全部の球と総当たりで調べる
+   (結果は同じだが遅い。数は GetOverflowCount でわかる)
+------------------------------------*/
+class SphereBroadphase {
+public:
+	explicit SphereBroadphase(float cellSize);
+
+	// 球の位置を反映する (前回と数が違えば作り直す)
+	void Update(const Sphere* spheres, size_t count);
+
+	// 重なっている組を pairs に出す (pairs は一度空にする)
+	// 同じ入力なら毎回同じ順で出る
+	void FindPairs(std::vector<CollisionPair>& pairs) const;
+	// 並列版 (出る順番は 1 スレッド版と同じ)
+	void FindPairs(std::vector<CollisionPair>& pairs, JobSystem& jobSystem);
+
+	float GetCellSize() const { return cellSize_; }
+	size_t GetCount() const { return entries_.size(); }
+	// セルに入らず総当たりで調べている球の数
+	size_t GetOverflowCount() const { return entries_.size() - overflowBegin_; }
+
+private:
+	// セル番号順に並べる要素 (球もコピーしておき、組を探すときに元の配列を引かない)
+	struct Entry {
+		uint64_t key;
+		uint32_t index;
+		Sphere sphere;
+	};
+
+	static bool IsOrdered(const Entry& a, const Entry& b) {
+		return a.key < b.key || (a.key == b.key && a.index < b.index);
+	}
+
+	// セルの番号 (セルに入らない球は kOverflowKey で、並びの最後に集まる)
+	uint64_t ComputeKey(const Sphere& sphere) const;
+	void UpdateOverflowBegin();
+	// [begin, end) の位置から始まるセルを調べる (セルの途中から始まる分は前の範囲が調べる)
+	void FindPairsInRange(size_t begin, size_t end, std::vector<CollisionPair>& pairs) const;
+	// セルに入らない球と、ほかの全部の球
+	void FindOverflowPairs(std::vector<CollisionPair>& pairs) const;
+
+	float cellSize_;
+	float invCellSize_;
+	std::vector<Entry> entries_;
+	// entries_ のうちセルに入らない球の始まり
+	size_t overflowBegin_ = 0;
+	// セルが変わった要素の一時置き場
+	std::vector<Entry> moved_;
+	// 並列版のチャンクごとの出力
+	std::vector<std::vector<CollisionPair>> chunkPairs_;
+};
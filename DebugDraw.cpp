@@ -0,0 +1,536 @@
+﻿#include "DebugDraw.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include "ScreenVertex.h"
+#include "SphereMesh.h"
+#include <cassert>
+#include <cmath>
+
+// 溜めた線を描画先へ出す
+void SubmitLines(const FrameLineBuffer& lines, DrawSink& sink) {
+	PROFILE_SCOPE("SubmitLines");
+	if (!lines.Empty()) {
+		sink.DrawLines(lines.Data(), lines.Size());
+	}
+}
+
+// 折れ線を 1 本ずつの線にして足す
+static void AppendLineStrip(
+    FrameLineBuffer& lines, const ScreenPoint* points, size_t count, uint32_t color) {
+	for (size_t i = 1; i < count; ++i) {
+		lines.PushBack({points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color});
+	}
+}
+
+// 4x4行列表示
+static const int kRowHeight = 20;
+static const int kColumnWidth = 60;
+void MatrixScreenPrintf(int x, int y, const Matrix4x4& matrix, DrawSink& sink) {
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			sink.ScreenPrintf(
+			    x + column * kColumnWidth, y + row * kRowHeight, "%6.02f", matrix.m[row][column]);
+		}
+	}
+}
+
+// 三次元ベクトル表示
+void VectorScreenPrintf(int x, int y, const Vector3& vector, const char* label, DrawSink& sink) {
+	sink.ScreenPrintf(x, y, "%.02f", vector.x);
+	sink.ScreenPrintf(x + kColumnWidth, y, "%.02f", vector.y);
+	sink.ScreenPrintf(x + kColumnWidth * 2, y, "%.02f", vector.z);
+	sink.ScreenPrintf(x + kColumnWidth * 3, y, "%s", label);
+}
+
+// クリップ空間の線分を near 平面で切ってscreenの線にする (見えなければ false)
+static bool ClipLineToScreen(
+    Vector4 start, Vector4 end, const Matrix4x4& viewportMatrix, uint32_t color,
+    ScreenLine& line) {
+	if (!ClipLineNearPlane(start, end)) {
+		return false;
+	}
+	Vector3 sp = ClipToScreen(start, viewportMatrix);
+	Vector3 ep = ClipToScreen(end, viewportMatrix);
+	line = {(int)sp.x, (int)sp.y, (int)ep.x, (int)ep.y, color};
+	return true;
+}
+
+// Grid
+static constexpr float kGridHalfWidth = 2.0f;                          // Grid半分
+static constexpr uint32_t kGridSubdivision = 10;                       // 分割数
+static constexpr uint32_t kGridLineCount = (kGridSubdivision + 1) * 2; // 線の本数
+// 1つ分の長さ
+static constexpr float kGridEvery = (kGridHalfWidth * 2.0f) / float(kGridSubdivision);
+
+// Grid の線の始点と終点を並べた表
+struct GridPoints {
+	Vector3 points[kGridLineCount * 2];
+};
+
+static constexpr GridPoints MakeGridPoints() {
+	GridPoints grid{};
+	for (uint32_t index = 0; index <= kGridSubdivision; ++index) {
+		float st = -kGridHalfWidth + (kGridEvery * index);
+		// 奥から手前への線
+		grid.points[index * 2] = {st, 0.0f, -kGridHalfWidth};
+		grid.points[index * 2 + 1] = {st, 0.0f, kGridHalfWidth};
+		// 左から右への線
+		grid.points[(kGridSubdivision + 1 + index) * 2] = {-kGridHalfWidth, 0.0f, st};
+		grid.points[(kGridSubdivision + 1 + index) * 2 + 1] = {kGridHalfWidth, 0.0f, st};
+	}
+	return grid;
+}
+
+// コンパイル時に作っておく
+static constexpr GridPoints kGridPoints = MakeGridPoints();
+
+// Grid の線を作って emitLine(const ScreenLine&) に渡す
+template<typename EmitLine>
+static void BuildGridLines(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, EmitLine&& emitLine) {
+	PROFILE_SCOPE("DrawGrid");
+	// まとめてクリップ空間まで変換する
+	Vector4 clipPoints[kGridLineCount * 2];
+	TransformArrayHomogeneous(
+	    kGridPoints.points, clipPoints, kGridLineCount * 2, viewProjectionMatrix);
+
+	// カメラの後ろに回り込む線があるので near 平面で切ってから w 除算する
+	for (uint32_t line = 0; line < kGridLineCount; ++line) {
+		ScreenLine screenLine;
+		if (ClipLineToScreen(
+		        clipPoints[line * 2], clipPoints[line * 2 + 1], viewportMatrix, kColorWhite,
+		        screenLine)) {
+			emitLine(screenLine);
+		}
+	}
+}
+
+void DrawGrid(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawSink& sink) {
+	// 全部作ってから 1 回で出す
+	ScreenLine lines[kGridLineCount];
+	size_t count = 0;
+	BuildGridLines(viewProjectionMatrix, viewportMatrix, [&](const ScreenLine& line) {
+		lines[count++] = line;
+	});
+	sink.DrawLines(lines, count);
+}
+
+void DrawGrid(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    FrameLineBuffer& lines) {
+	BuildGridLines(viewProjectionMatrix, viewportMatrix, [&](const ScreenLine& line) {
+		lines.PushBack(line);
+	});
+}
+
+// 球の分割数 (塗りつぶしと、線の最も細かい詳細度)
+static const uint32_t kSphereSubdivision = 16;
+static const uint32_t kSphereVertexCount = (kSphereSubdivision + 1) * kSphereSubdivision;
+static const uint32_t kSphereTriangleCount = kSphereSubdivision * kSphereSubdivision * 2;
+// DrawSpheres で 1 ジョブが受け持つ球の数
+static const size_t kSpheresPerJob = 8;
+
+// 単位球を半径倍して中心へ移動する行列
+static Matrix4x4 MakeSphereWorldMatrix(const Sphere& sphere) {
+	Matrix4x4 worldMatrix = MakeScaleMatrix({sphere.radius, sphere.radius, sphere.radius});
+	worldMatrix.m[3][0] = sphere.center.x;
+	worldMatrix.m[3][1] = sphere.center.y;
+	worldMatrix.m[3][2] = sphere.center.z;
+	return worldMatrix;
+}
+
+// 詳細度ごとの線の分割数
+static const uint32_t kSphereLodSubdivisions[kSphereLodCount] = {kSphereSubdivision, 8, 4};
+// 詳細度を使う画面上の半径 (画素) の下限。最も粗い段の下限未満は描かない
+// 分割数 n の折れ線と円のずれは半径 r 画素で約 π² r / 2n² 画素なので、
+// 1 つ粗い段のずれが 0.5 画素を超えるあたりで細かい段に切り替える
+static const float kSphereLodMinRadii[kSphereLodCount] = {6.0f, 1.5f, 0.5f};
+// 前フレームの段は、段の範囲をこの割合だけ広げた中にいる間は変えない (境目で行き来しないように)
+static const float kSphereLodHysteresis = 0.2f;
+
+// 球の線を描くときにフレームで共通の値
+struct SphereLineContext {
+	Frustum frustum;
+	Matrix4x4 viewProjectionMatrix;
+	Matrix4x4 viewportMatrix;
+	Matrix4x4 viewProjectionViewportMatrix;
+	// viewProjectionViewportMatrix を並べたもの (DrawSpheres の MultiplyArray の右側)
+	Matrix4x4 viewProjectionViewportMatrices[kSpheresPerJob];
+	// 中心の w (カメラからの奥行き) を求める係数 (ビュープロジェクション行列の 4 列目)
+	Vector4 depthCoefficients;
+	// w = 1 の奥行きで 1 単位が何画素か (x, y の大きいほう)
+	float pixelsPerUnit;
+	const UnitSphereMesh* meshes[kSphereLodCount];
+};
+
+static SphereLineContext MakeSphereLineContext(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix) {
+	SphereLineContext context;
+	context.frustum = MakeFrustum(viewProjectionMatrix);
+	context.viewProjectionMatrix = viewProjectionMatrix;
+	context.viewportMatrix = viewportMatrix;
+	context.viewProjectionViewportMatrix = Multiply(viewProjectionMatrix, viewportMatrix);
+	for (Matrix4x4& matrix : context.viewProjectionViewportMatrices) {
+		matrix = context.viewProjectionViewportMatrix;
+	}
+	const Matrix4x4& m = viewProjectionMatrix;
+	context.depthCoefficients = {m.m[0][3], m.m[1][3], m.m[2][3], m.m[3][3]};
+	float scaleX = Length({m.m[0][0], m.m[1][0], m.m[2][0]}) * std::fabs(viewportMatrix.m[0][0]);
+	float scaleY = Length({m.m[0][1], m.m[1][1], m.m[2][1]}) * std::fabs(viewportMatrix.m[1][1]);
+	context.pixelsPerUnit = scaleX > scaleY ? scaleX : scaleY;
+	for (uint32_t lod = 0; lod < kSphereLodCount; ++lod) {
+		context.meshes[lod] = &GetUnitSphereMesh(kSphereLodSubdivisions[lod]);
+	}
+	assert(context.meshes[0]->vertices.size() == kSphereVertexCount);
+	return context;
+}
+
+// 画面上の球の半径 (画素) の見積もり
+// 球の最も手前の奥行きで割るので大きめに出る。カメラが球にかかっていれば inf
+static float EstimateSphereScreenRadius(const SphereLineContext& context, const Sphere& sphere) {
+	const Vector4& d = context.depthCoefficients;
+	float depth = sphere.center.x * d.x + sphere.center.y * d.y + sphere.center.z * d.z + d.w;
+	float nearestDepth = depth - sphere.radius * Length({d.x, d.y, d.z});
+	if (nearestDepth <= 0.0f) {
+		return INFINITY;
+	}
+	return sphere.radius * context.pixelsPerUnit / nearestDepth;
+}
+
+// 画面上の半径から詳細度を選ぶ (previous は前フレームの段)
+static uint8_t SelectSphereLod(float screenRadius, uint8_t previous) {
+	uint8_t lod = kSphereLodCulled;
+	for (uint8_t i = 0; i < kSphereLodCount; ++i) {
+		if (screenRadius >= kSphereLodMinRadii[i]) {
+			lod = i;
+			break;
+		}
+	}
+	if (previous == kSphereLodNone || previous == lod) {
+		return lod;
+	}
+	float lower =
+	    previous < kSphereLodCount ? kSphereLodMinRadii[previous] * (1.0f - kSphereLodHysteresis)
+	                               : 0.0f;
+	float upper =
+	    previous > 0 ? kSphereLodMinRadii[previous - 1] * (1.0f + kSphereLodHysteresis) : INFINITY;
+	return screenRadius >= lower && screenRadius < upper ? previous : lod;
+}
+
+// 緯線と経線を折れ線にして emitStrip(const ScreenPoint* points, size_t count, uint32_t color) に渡す
+// screenPoints は球の頂点をscreenへ変換したもの
+template<typename Point, typename EmitStrip>
+static void EmitSphereStrips(
+    const UnitSphereMesh& mesh, const Point* screenPoints, uint32_t color, EmitStrip& emitStrip) {
+	ScreenPoint points[kSphereSubdivision + 1];
+	assert(mesh.stripLength <= kSphereSubdivision + 1);
+	const uint32_t* index = mesh.strips.data();
+	for (uint32_t strip = 0; strip < mesh.stripCount; ++strip) {
+		for (uint32_t i = 0; i < mesh.stripLength; ++i) {
+			const Point& point = screenPoints[*index++];
+			points[i] = {(int)point.x, (int)point.y};
+		}
+		emitStrip(points, size_t(mesh.stripLength), color);
+	}
+}
+
+// 球を描く詳細度を選ぶ (lod があれば前フレームの段を読み書きする)
+// 視錐台の完全に外か、画素未満なら kSphereLodCulled
+static uint8_t SelectSphereLines(
+    const SphereLineContext& context, const Sphere& sphere, uint8_t* lod) {
+	if (TestSphere(context.frustum, sphere) == FrustumTest::kOutside) {
+		return kSphereLodCulled;
+	}
+	uint8_t selected = SelectSphereLod(
+	    EstimateSphereScreenRadius(context, sphere), lod ? *lod : kSphereLodNone);
+	if (lod) {
+		*lod = selected;
+	}
+	return selected;
+}
+
+// selected の段で球の線を作って emitLine(const ScreenLine&) と emitStrip に渡す
+// worldViewProjectionViewportMatrix は球のワールド行列と viewProjectionViewportMatrix の積
+// ・near 平面より奥なら頂点をscreenまで一度に int16 の画素へ変換し、緯線と経線を折れ線で出す
+//   (画面から大きくはみ出して int16 に収まらなければ float で変換し直す)
+// ・near 平面をまたぐならクリップ空間で線を切ってから w 除算し、1 本ずつの線で出す
+template<typename EmitLine, typename EmitStrip>
+static void BuildSphereLines(
+    const SphereLineContext& context, const Sphere& sphere, uint8_t selected,
+    const Matrix4x4& worldViewProjectionViewportMatrix, uint32_t color, EmitLine&& emitLine,
+    EmitStrip&& emitStrip) {
+	PROFILE_SCOPE("DrawSphere");
+	const UnitSphereMesh& mesh = *context.meshes[selected];
+	uint32_t vertexCount = uint32_t(mesh.vertices.size());
+
+	if (IsSphereInFrontOfNearPlane(context.frustum, sphere)) {
+		// 単位球の頂点からscreenまで一度に変換する
+		ScreenPoint16 screenPoints[kSphereVertexCount];
+		if (TransformArrayToScreen16(
+		        mesh.vertices.data(), screenPoints, nullptr, vertexCount,
+		        worldViewProjectionViewportMatrix)) {
+			EmitSphereStrips(mesh, screenPoints, color, emitStrip);
+			return;
+		}
+		Vector3 screenVertices[kSphereVertexCount];
+		TransformArray(
+		    mesh.vertices.data(), screenVertices, vertexCount, worldViewProjectionViewportMatrix);
+		EmitSphereStrips(mesh, screenVertices, color, emitStrip);
+		return;
+	}
+
+	Vector4 clipVertices[kSphereVertexCount];
+	TransformArrayHomogeneous(
+	    mesh.vertices.data(), clipVertices, vertexCount,
+	    Multiply(MakeSphereWorldMatrix(sphere), context.viewProjectionMatrix));
+	for (size_t edge = 0; edge < mesh.edges.size(); edge += 2) {
+		ScreenLine line;
+		if (ClipLineToScreen(
+		        clipVertices[mesh.edges[edge]], clipVertices[mesh.edges[edge + 1]],
+		        context.viewportMatrix, color, line)) {
+			emitLine(line);
+		}
+	}
+}
+
+// 1 つの球を選んだ段で描く (視錐台の外や画素未満なら何もしない)
+template<typename EmitLine, typename EmitStrip>
+static void BuildSingleSphereLines(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, EmitLine&& emitLine, EmitStrip&& emitStrip) {
+	SphereLineContext context = MakeSphereLineContext(viewProjectionMatrix, viewportMatrix);
+	uint8_t selected = SelectSphereLines(context, sphere, nullptr);
+	if (selected == kSphereLodCulled) {
+		return;
+	}
+	BuildSphereLines(
+	    context, sphere, selected,
+	    Multiply(MakeSphereWorldMatrix(sphere), context.viewProjectionViewportMatrix), color,
+	    emitLine, emitStrip);
+}
+
+// Sphere
+void DrawSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, DrawSink& sink) {
+	BuildSingleSphereLines(
+	    sphere, viewProjectionMatrix, viewportMatrix, color,
+	    [&](const ScreenLine& line) {
+		    sink.DrawLine(line.x1, line.y1, line.x2, line.y2, line.color);
+	    },
+	    [&](const ScreenPoint* points, size_t pointCount, uint32_t stripColor) {
+		    sink.DrawLineStrip(points, pointCount, stripColor);
+	    });
+}
+
+void DrawSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, FrameLineBuffer& lines) {
+	BuildSingleSphereLines(
+	    sphere, viewProjectionMatrix, viewportMatrix, color,
+	    [&](const ScreenLine& line) { lines.PushBack(line); },
+	    [&](const ScreenPoint* points, size_t pointCount, uint32_t stripColor) {
+		    AppendLineStrip(lines, points, pointCount, stripColor);
+	    });
+}
+
+// 光の来る向き (上から手前へ。長さ 1)
+static constexpr Vector3 kLightDirection = {0.0f, 0.6f, -0.8f};
+
+// color の RGB を明るさ倍する (A はそのまま)
+static uint32_t ShadeColor(uint32_t color, float brightness) {
+	uint32_t r = uint32_t(float((color >> 24) & 0xFF) * brightness);
+	uint32_t g = uint32_t(float((color >> 16) & 0xFF) * brightness);
+	uint32_t b = uint32_t(float((color >> 8) & 0xFF) * brightness);
+	return (r << 24) | (g << 16) | (b << 8) | (color & 0xFF);
+}
+
+// 単位球の三角形の明るさ (頂点はそのまま法線なので重心の向きで決める)
+static float ComputeSphereTriangleBrightness(
+    const Vector3& v0, const Vector3& v1, const Vector3& v2) {
+	Vector3 normal = Vec3Add(Vec3Add(v0, v1), v2);
+	float length = Length(normal);
+	float lambert = length > 0.0f ? Dot(normal, kLightDirection) / length : 0.0f;
+	// 影になる側も真っ黒にはしない
+	return 0.25f + 0.75f * (lambert > 0.0f ? lambert : 0.0f);
+}
+
+// クリップ空間の三角形を near 平面 (z = 0) で切って screen の三角形にして積む
+static void ClipTriangleToScreen(
+    const Vector4 (&clip)[3], const Matrix4x4& viewportMatrix, uint32_t color,
+    Rasterizer& rasterizer) {
+	// 切ると四角形になることがあるので扇形に分ける
+	Vector4 polygon[4];
+	int count = 0;
+	for (int i = 0; i < 3; ++i) {
+		const Vector4& from = clip[i];
+		const Vector4& to = clip[(i + 1) % 3];
+		if (from.z >= 0.0f) {
+			polygon[count++] = from;
+		}
+		if ((from.z >= 0.0f) != (to.z >= 0.0f)) {
+			float t = from.z / (from.z - to.z);
+			polygon[count++] = {
+			    from.x + (to.x - from.x) * t, from.y + (to.y - from.y) * t, 0.0f,
+			    from.w + (to.w - from.w) * t};
+		}
+	}
+	if (count < 3) {
+		return;
+	}
+	Vector3 screen[4];
+	for (int i = 0; i < count; ++i) {
+		screen[i] = ClipToScreen(polygon[i], viewportMatrix);
+	}
+	for (int i = 1; i + 1 < count; ++i) {
+		rasterizer.DrawTriangle(screen[0], screen[i], screen[i + 1], color);
+	}
+}
+
+// 塗りつぶしの Sphere
+void DrawSolidSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, Rasterizer& rasterizer) {
+	DrawSolidSpheres(&sphere, 1, viewProjectionMatrix, viewportMatrix, color, rasterizer);
+}
+
+void DrawSolidSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, Rasterizer& rasterizer) {
+	PROFILE_SCOPE("DrawSolidSpheres");
+	const UnitSphereMesh& mesh = GetUnitSphereMesh(kSphereSubdivision);
+	assert(mesh.triangles.size() == kSphereTriangleCount * 3);
+	Frustum frustum = MakeFrustum(viewProjectionMatrix);
+	Matrix4x4 viewProjectionViewportMatrix = Multiply(viewProjectionMatrix, viewportMatrix);
+
+	// 三角形ごとの色は球によらないので先に求めておく
+	uint32_t colors[kSphereTriangleCount];
+	for (uint32_t i = 0; i < kSphereTriangleCount; ++i) {
+		const uint32_t* index = &mesh.triangles[i * 3];
+		colors[i] = ShadeColor(
+		    color, ComputeSphereTriangleBrightness(
+		               mesh.vertices[index[0]], mesh.vertices[index[1]], mesh.vertices[index[2]]));
+	}
+
+	for (size_t s = 0; s < count; ++s) {
+		const Sphere& sphere = spheres[s];
+		if (TestSphere(frustum, sphere) == FrustumTest::kOutside) {
+			continue;
+		}
+		Matrix4x4 worldMatrix = MakeSphereWorldMatrix(sphere);
+
+		if (IsSphereInFrontOfNearPlane(frustum, sphere)) {
+			Vector3 screenVertices[kSphereVertexCount];
+			TransformArray(
+			    mesh.vertices.data(), screenVertices, kSphereVertexCount,
+			    Multiply(worldMatrix, viewProjectionViewportMatrix));
+			for (uint32_t i = 0; i < kSphereTriangleCount; ++i) {
+				const uint32_t* index = &mesh.triangles[i * 3];
+				rasterizer.DrawTriangle(
+				    screenVertices[index[0]], screenVertices[index[1]], screenVertices[index[2]],
+				    colors[i]);
+			}
+			continue;
+		}
+
+		Vector4 clipVertices[kSphereVertexCount];
+		TransformArrayHomogeneous(
+		    mesh.vertices.data(), clipVertices, kSphereVertexCount,
+		    Multiply(worldMatrix, viewProjectionMatrix));
+		for (uint32_t i = 0; i < kSphereTriangleCount; ++i) {
+			const uint32_t* index = &mesh.triangles[i * 3];
+			const Vector4 clip[3] = {
+			    clipVertices[index[0]], clipVertices[index[1]], clipVertices[index[2]]};
+			ClipTriangleToScreen(clip, viewportMatrix, colors[i], rasterizer);
+		}
+	}
+}
+
+// 球ごとのカリング・行列作成・頂点変換・線の作成を並列に行い、各ワーカーのバッファに溜める
+// 描く球の行列の積はジョブごとに MultiplyArray でまとめて求める
+// getSphere(index) は index 番目の球を返す
+template<typename GetSphere>
+static void BuildSpheresParallel(
+    const GetSphere& getSphere, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, JobSystem& jobSystem,
+    ParallelLineBuffer& lineBuffer, uint8_t* lods) {
+	PROFILE_SCOPE("DrawSpheres");
+	SphereLineContext context = MakeSphereLineContext(viewProjectionMatrix, viewportMatrix);
+
+	lineBuffer.Reset(jobSystem.GetWorkerCount());
+	jobSystem.ParallelFor(count, kSpheresPerJob, [&](size_t begin, size_t end, uint32_t worker) {
+		lineBuffer.BeginChunk(worker, begin / kSpheresPerJob);
+		// 描く球を選び、ワールド行列を並べる
+		Sphere spheres[kSpheresPerJob];
+		uint8_t selected[kSpheresPerJob];
+		Matrix4x4 worldMatrices[kSpheresPerJob];
+		size_t drawCount = 0;
+		for (size_t index = begin; index < end; ++index) {
+			Sphere sphere = getSphere(index);
+			uint8_t lod = SelectSphereLines(context, sphere, lods ? &lods[index] : nullptr);
+			if (lod == kSphereLodCulled) {
+				continue;
+			}
+			spheres[drawCount] = sphere;
+			selected[drawCount] = lod;
+			worldMatrices[drawCount] = MakeSphereWorldMatrix(sphere);
+			++drawCount;
+		}
+		Matrix4x4 matrices[kSpheresPerJob];
+		MultiplyArray(
+		    worldMatrices, context.viewProjectionViewportMatrices, matrices, drawCount);
+		for (size_t i = 0; i < drawCount; ++i) {
+			BuildSphereLines(
+			    context, spheres[i], selected[i], matrices[i], color,
+			    [&](const ScreenLine& line) { lineBuffer.AddLine(worker, line); },
+			    [&](const ScreenPoint* points, size_t pointCount, uint32_t stripColor) {
+				    lineBuffer.AddStrip(worker, points, pointCount, stripColor);
+			    });
+		}
+	});
+}
+
+// 複数のSphere
+void DrawSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, JobSystem& jobSystem,
+    ParallelLineBuffer& lineBuffer, DrawSink& sink, uint8_t* lods) {
+	BuildSpheresParallel(
+	    [spheres](size_t index) { return spheres[index]; }, count, viewProjectionMatrix,
+	    viewportMatrix, color, jobSystem, lineBuffer, lods);
+	// spheres の順に描画先へ出す
+	lineBuffer.Submit(sink);
+}
+
+void DrawSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, JobSystem& jobSystem,
+    ParallelLineBuffer& lineBuffer, FrameLineBuffer& lines, uint8_t* lods) {
+	BuildSpheresParallel(
+	    [spheres](size_t index) { return spheres[index]; }, count, viewProjectionMatrix,
+	    viewportMatrix, color, jobSystem, lineBuffer, lods);
+	// spheres の順に lines の末尾へ足す
+	lineBuffer.Submit(lines);
+}
+
+// 中心と半径が別々の配列
+void DrawSpheres(
+    const Vector3* centers, const float* radii, size_t count,
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, uint32_t color,
+    JobSystem& jobSystem, ParallelLineBuffer& lineBuffer, DrawSink& sink, uint8_t* lods) {
+	BuildSpheresParallel(
+	    [centers, radii](size_t index) { return Sphere{centers[index], radii[index]}; }, count,
+	    viewProjectionMatrix, viewportMatrix, color, jobSystem, lineBuffer, lods);
+	lineBuffer.Submit(sink);
+}
+
+void DrawSpheres(
+    const Vector3* centers, const float* radii, size_t count,
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, uint32_t color,
+    JobSystem& jobSystem, ParallelLineBuffer& lineBuffer, FrameLineBuffer& lines, uint8_t* lods) {
+	BuildSpheresParallel(
+	    [centers, radii](size_t index) { return Sphere{centers[index], radii[index]}; }, count,
+	    viewProjectionMatrix, viewportMatrix, color, jobSystem, lineBuffer, lods);
+	lineBuffer.Submit(lines);
+}
@@ -0,0 +1,83 @@
+﻿#pragma once
+#include "DrawSink.h"
+#include "FrameArena.h"
+#include "JobSystem.h"
+#include "Mathfunction.h"
+#include "ParallelLineBuffer.h"
+#include "Rasterizer.h"
+#include "Shape.h"
+
+/*---------------------------------
+ デバッグ表示
+ ・描画先 (DrawSink) を差し替えれば画面なしでも動く
+ ・Grid と Sphere は視錐台の外を描かず、カメラの後ろに回る線は near 平面で切る
+ ・FrameLineBuffer を受け取る版は線を溜めるだけで、SubmitLines でまとめて描画先へ出す
+ ・Rasterizer を受け取る版は塗りつぶしの三角形を積む (描くのは Rasterizer::Flush)
+------------------------------------*/
+
+// フレームアリーナに溜める線 (フレームの終わりに SubmitLines で出す)
+using FrameLineBuffer = FrameVector<ScreenLine>;
+
+// 溜めた線を描画先へ出す
+void SubmitLines(const FrameLineBuffer& lines, DrawSink& sink);
+
+// 4x4行列表示
+void MatrixScreenPrintf(int x, int y, const Matrix4x4& matrix, DrawSink& sink);
+
+// 三次元ベクトル表示
+void VectorScreenPrintf(int x, int y, const Vector3& vector, const char* label, DrawSink& sink);
+
+// Grid (一辺 4、10 分割で固定。毎回作り直す。広さを変えたり線を覚えておくなら Grid.h の Grid)
+void DrawGrid(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawSink& sink);
+void DrawGrid(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    FrameLineBuffer& lines);
+
+// Sphere の線の詳細度
+// ・画面上の半径で分割数を選び (0 が最も細かい)、半径が画素未満の球は描かない
+// ・DrawSpheres に球ごとの段を覚えておく配列を渡すと、境目の付近で段が行き来しない
+const uint8_t kSphereLodCount = 3;
+// 画素未満で描かなかった
+const uint8_t kSphereLodCulled = kSphereLodCount;
+// 前フレームの段がない (配列はこれで埋めてから渡す)
+const uint8_t kSphereLodNone = 0xFF;
+
+// Sphere
+void DrawSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, DrawSink& sink);
+void DrawSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, FrameLineBuffer& lines);
+
+// 塗りつぶしの Sphere (上から照らした陰影を付ける)
+void DrawSolidSphere(
+    const Sphere& sphere, const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    uint32_t color, Rasterizer& rasterizer);
+void DrawSolidSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, Rasterizer& rasterizer);
+
+// 複数のSphere
+// 球ごとの行列作成と頂点変換を jobSystem で並列に行い、線は spheres の順に sink へ出す
+// lineBuffer はフレームをまたいで使い回すと確保が減る
+// lods は球ごとの前フレームの詳細度 (count 個。nullptr なら毎フレーム選び直す)
+void DrawSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, JobSystem& jobSystem,
+    ParallelLineBuffer& lineBuffer, DrawSink& sink, uint8_t* lods = nullptr);
+void DrawSpheres(
+    const Sphere* spheres, size_t count, const Matrix4x4& viewProjectionMatrix,
+    const Matrix4x4& viewportMatrix, uint32_t color, JobSystem& jobSystem,
+    ParallelLineBuffer& lineBuffer, FrameLineBuffer& lines, uint8_t* lods = nullptr);
+// 中心と半径を別々の配列で渡す版 (SceneFile の配列をコピーせずに描く)
+void DrawSpheres(
+    const Vector3* centers, const float* radii, size_t count,
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, uint32_t color,
+    JobSystem& jobSystem, ParallelLineBuffer& lineBuffer, DrawSink& sink, uint8_t* lods = nullptr);
+void DrawSpheres(
+    const Vector3* centers, const float* radii, size_t count,
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, uint32_t color,
+    JobSystem& jobSystem, ParallelLineBuffer& lineBuffer, FrameLineBuffer& lines,
+    uint8_t* lods = nullptr);
@@ -0,0 +1,26 @@
+﻿#include "DrawSink.h"
+#include <cstdarg>
+#include <cstdio>
+
+void DrawSink::DrawLines(const ScreenLine* lines, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		const ScreenLine& line = lines[i];
+		DrawLine(line.x1, line.y1, line.x2, line.y2, line.color);
+	}
+}
+
+void DrawSink::DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) {
+	for (size_t i = 1; i < count; ++i) {
+		DrawLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color);
+	}
+}
+
+// 書式付きで文字を表示する
+void DrawSink::ScreenPrintf(int x, int y, const char* format, ...) {
+	char text[256];
+	va_list args;
+	va_start(args, format);
+	vsnprintf(text, sizeof(text), format, args);
+	va_end(args);
+	PrintText(x, y, text);
+}
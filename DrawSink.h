@@ -0,0 +1,48 @@
+﻿#pragma once
+#include <cstddef>
+#include <cstdint>
+
+// 色 (Novice と同じ RGBA)
+const uint32_t kColorWhite = 0xFFFFFFFF;
+const uint32_t kColorBlack = 0x000000FF;
+
+// screen 座標の線分
+struct ScreenLine {
+	int x1;
+	int y1;
+	int x2;
+	int y2;
+	uint32_t color;
+};
+
+// screen 座標の点 (折れ線の頂点)
+struct ScreenPoint {
+	int x;
+	int y;
+};
+
+/*---------------------------------
+ 描画先
+ ・DrawGrid などの描画関数はここに線と文字を出す
+ ・Novice に出す NoviceDrawSink と、画面なしで動く HeadlessDrawSink がある
+ ・線がたくさんあるときは DrawLines / DrawLineStrip でまとめて渡す (1 本ずつの仮想呼び出しを減らす)
+------------------------------------*/
+class DrawSink {
+public:
+	virtual ~DrawSink() = default;
+
+	// 線を引く
+	virtual void DrawLine(int x1, int y1, int x2, int y2, uint32_t color) = 0;
+
+	// 線をまとめて引く (既定は DrawLine を順に呼ぶ)
+	virtual void DrawLines(const ScreenLine* lines, size_t count);
+
+	// 折れ線 (points を順につないだ count - 1 本) を引く (既定は DrawLine を順に呼ぶ)
+	virtual void DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color);
+
+	// 文字を表示する (DrawText は Windows.h がマクロにしているので使わない)
+	virtual void PrintText(int x, int y, const char* text) = 0;
+
+	// 書式付きで文字を表示する (Novice::ScreenPrintf と同じ使い方)
+	void ScreenPrintf(int x, int y, const char* format, ...);
+};
@@ -0,0 +1,79 @@
+﻿#include "FastMath.h"
+#include "MathSimd.h"
+#include "Profiler.h"
+#include <immintrin.h>
+
+namespace {
+
+using namespace FastMathDetail;
+
+void SinCosArrayFastScalar(const float* radians, float* sines, float* cosines, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		SinCos<MathPrecision::kFast>(radians[i], sines[i], cosines[i]);
+	}
+}
+
+// 8 個ずつ計算する (計算の手順は SinCosPolynomial と同じ)
+MATH_TARGET_AVX2 void SinCosArrayFastAvx2(
+    const float* radians, float* sines, float* cosines, size_t count) {
+	const __m256 absMask = _mm256_castsi256_ps(_mm256_set1_epi32(0x7FFFFFFF));
+	const __m256 maxInput = _mm256_set1_ps(kMaxReducedInput);
+	const __m256 one = _mm256_set1_ps(1.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256i oddBit = _mm256_set1_epi32(1);
+	const __m256i signBit = _mm256_set1_epi32(2);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x = _mm256_loadu_ps(radians + i);
+		__m256i quadrant = _mm256_cvtps_epi32(_mm256_mul_ps(x, _mm256_set1_ps(kTwoOverPi)));
+		__m256 j = _mm256_cvtepi32_ps(quadrant);
+		__m256 r = _mm256_sub_ps(x, _mm256_mul_ps(j, _mm256_set1_ps(kHalfPi1)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(kHalfPi2)));
+		r = _mm256_sub_ps(r, _mm256_mul_ps(j, _mm256_set1_ps(kHalfPi3)));
+		__m256 r2 = _mm256_mul_ps(r, r);
+
+		__m256 s = _mm256_add_ps(
+		    _mm256_set1_ps(kSin2), _mm256_mul_ps(r2, _mm256_set1_ps(kSin3)));
+		s = _mm256_add_ps(_mm256_set1_ps(kSin1), _mm256_mul_ps(r2, s));
+		s = _mm256_add_ps(r, _mm256_mul_ps(_mm256_mul_ps(r, r2), s));
+		__m256 c = _mm256_add_ps(
+		    _mm256_set1_ps(kCos2), _mm256_mul_ps(r2, _mm256_set1_ps(kCos3)));
+		c = _mm256_add_ps(_mm256_set1_ps(kCos1), _mm256_mul_ps(r2, c));
+		c = _mm256_add_ps(
+		    _mm256_sub_ps(one, _mm256_mul_ps(half, r2)),
+		    _mm256_mul_ps(_mm256_mul_ps(r2, r2), c));
+
+		// 象限が奇数なら入れ替え、符号は象限の 2bit 目で反転する
+		__m256 swap = _mm256_castsi256_ps(
+		    _mm256_cmpeq_epi32(_mm256_and_si256(quadrant, oddBit), oddBit));
+		__m256 sinSign = _mm256_castsi256_ps(
+		    _mm256_slli_epi32(_mm256_and_si256(quadrant, signBit), 30));
+		__m256 cosSign = _mm256_castsi256_ps(_mm256_slli_epi32(
+		    _mm256_and_si256(_mm256_add_epi32(quadrant, oddBit), signBit), 30));
+		_mm256_storeu_ps(sines + i, _mm256_xor_ps(_mm256_blendv_ps(s, c, swap), sinSign));
+		_mm256_storeu_ps(cosines + i, _mm256_xor_ps(_mm256_blendv_ps(c, s, swap), cosSign));
+
+		// 範囲外 (と NaN) は標準ライブラリで求め直す
+		int outside = _mm256_movemask_ps(
+		    _mm256_cmp_ps(_mm256_and_ps(x, absMask), maxInput, _CMP_NLE_UQ));
+		while (outside != 0) {
+			int lane = std::countr_zero(unsigned(outside));
+			SinCos<MathPrecision::kPrecise>(radians[i + lane], sines[i + lane], cosines[i + lane]);
+			outside &= outside - 1;
+		}
+	}
+	SinCosArrayFastScalar(radians + i, sines + i, cosines + i, count - i);
+}
+
+} // namespace
+
+// sin と cos の一括計算
+void SinCosArrayFast(const float* radians, float* sines, float* cosines, size_t count) {
+	PROFILE_SCOPE("SinCosArrayFast");
+	if (HasAvx2Kernels()) {
+		SinCosArrayFastAvx2(radians, sines, cosines, count);
+		return;
+	}
+	SinCosArrayFastScalar(radians, sines, cosines, count);
+}
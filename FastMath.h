@@ -0,0 +1,151 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <bit>
+#include <cmath>
+#include <cstddef>
+#include <cstdint>
+#include <xmmintrin.h>
+
+/*---------------------------------
+ 速さと精度を選べる数学関数
+ ・MathPrecision で段を選ぶ。呼び出しごとにテンプレート引数で選ぶか、
+   引数を省いてプロジェクト全体の既定 (MATH_PRECISION) に従わせる
+ ・誤差は float の ULP (正しい値との差が、その値の float の間隔何個分か)
+   スカラー関数は範囲内の float を総当たり、ベクトルは乱数の点で測った最大値
+------------------------------------*/
+enum class MathPrecision {
+	kPrecise, // 標準ライブラリ (sinf, cosf, sqrtf と除算)
+	kFast,    // 多項式・rsqrt + ニュートン法 1 回 (誤差は数 ULP)
+	kCoarse,  // 次数を落とした多項式・rsqrt のみ (表示用。相対誤差 4e-4 程度)
+};
+
+// 既定の段 (プリプロセッサ定義で MATH_PRECISION=kFast などとすると全体が切り替わる。
+// 翻訳単位ごとに変えないこと)
+#ifndef MATH_PRECISION
+#define MATH_PRECISION kPrecise
+#endif
+constexpr MathPrecision kMathPrecision = MathPrecision::MATH_PRECISION;
+
+/*---------------------------------
+ 1 / sqrt(x)
+ ・kPrecise : 1.0f / sqrtf(x) (最大 1 ULP)
+ ・kFast    : rsqrtss + ニュートン法 1 回 (最大 5 ULP)
+ ・kCoarse  : rsqrtss のみ (相対誤差 1.5 * 2^-12 以内)
+ ・x は正の正規化数 (0 なら kPrecise, kCoarse は inf、kFast は NaN)
+------------------------------------*/
+template<MathPrecision precision = kMathPrecision>
+inline float ReciprocalSqrt(float x) {
+	if constexpr (precision == MathPrecision::kPrecise) {
+		return 1.0f / std::sqrt(x);
+	} else {
+		float estimate = _mm_cvtss_f32(_mm_rsqrt_ss(_mm_set_ss(x)));
+		if constexpr (precision == MathPrecision::kCoarse) {
+			return estimate;
+		} else {
+			return estimate * (1.5f - 0.5f * x * estimate * estimate);
+		}
+	}
+}
+
+// ノルム (rsqrt を使う。誤差は 5 ULP 程度)
+inline float LengthFast(const Vector3& v) {
+	float lengthSquared = LengthSquared(v);
+	if (lengthSquared == 0.0f) {
+		return 0.0f;
+	}
+	return lengthSquared * ReciprocalSqrt<MathPrecision::kFast>(lengthSquared);
+}
+
+// 正規化 (rsqrt + ニュートン法 1 回で除算なし。各成分の誤差は 5 ULP 程度)
+// 長さ 0 のベクトルは 0 ベクトルを返す
+inline Vector3 NormalizeFast(const Vector3& v) {
+	float lengthSquared = LengthSquared(v);
+	if (lengthSquared == 0.0f) {
+		return {0.0f, 0.0f, 0.0f};
+	}
+	return Vec3Multiply(ReciprocalSqrt<MathPrecision::kFast>(lengthSquared), v);
+}
+
+/*---------------------------------
+ sin と cos を同時に求める
+ ・kPrecise : sinf, cosf (同じ角度なのでコンパイラが 1 回の sincos にまとめられる)
+ ・kFast    : π/2 ごとに区切り [-π/4, π/4] の多項式 (7 次と 8 次)
+              |x| <= 8192 で、値の絶対値が 1e-3 以上なら最大 1.6 ULP
+              0 に近い値は ULP では大きく出るが、絶対誤差は 1e-7 以内
+ ・kCoarse  : 同じ区切りで 5 次と 6 次 (絶対誤差 4e-5 以内)
+ ・kFast, kCoarse でも |x| > 8192 は標準ライブラリに任せる
+------------------------------------*/
+namespace FastMathDetail {
+
+// π/2 を 3 つに分けた値 (上位 2 つは j 倍しても丸めが出ない桁数)
+constexpr float kHalfPi1 = 1.5703125f;
+constexpr float kHalfPi2 = 4.837512969970703125e-4f;
+constexpr float kHalfPi3 = 7.54978995489188216e-8f;
+constexpr float kTwoOverPi = 0.636619772367581343f;
+// 区切りの誤差が増えないうちに標準ライブラリへ切り替える大きさ
+constexpr float kMaxReducedInput = 8192.0f;
+// [-π/4, π/4] の sin(r) = r + r^3 (s1 + r^2 (s2 + r^2 s3))
+constexpr float kSin1 = -1.6666654611e-1f;
+constexpr float kSin2 = 8.3321608736e-3f;
+constexpr float kSin3 = -1.9515295891e-4f;
+// [-π/4, π/4] の cos(r) = 1 - r^2 / 2 + r^4 (c1 + r^2 (c2 + r^2 c3))
+constexpr float kCos1 = 4.166664568298827e-2f;
+constexpr float kCos2 = -1.388731625493765e-3f;
+constexpr float kCos3 = 2.443315711809948e-5f;
+
+template<MathPrecision precision>
+inline void SinCosPolynomial(float radian, float& sin, float& cos) {
+	// 最も近い π/2 の倍数 j を引いて [-π/4, π/4] に収める (cvtss2si は最近接に丸める)
+	int quadrant = _mm_cvtss_si32(_mm_set_ss(radian * kTwoOverPi));
+	float j = float(quadrant);
+	float r = ((radian - j * kHalfPi1) - j * kHalfPi2) - j * kHalfPi3;
+	float r2 = r * r;
+	float s;
+	float c;
+	if constexpr (precision == MathPrecision::kFast) {
+		s = r + r * r2 * (kSin1 + r2 * (kSin2 + r2 * kSin3));
+		c = 1.0f - 0.5f * r2 + r2 * r2 * (kCos1 + r2 * (kCos2 + r2 * kCos3));
+	} else {
+		s = r + r * r2 * (kSin1 + r2 * kSin2);
+		c = 1.0f - 0.5f * r2 + r2 * r2 * (kCos1 + r2 * kCos2);
+	}
+	// j の下位 2bit が象限 1: (c, -s)  2: (-s, -c)  3: (-c, s)
+	// 象限はばらばらで分岐が外れやすいので、入れ替えと符号反転をビット演算で行う
+	uint32_t sBits = std::bit_cast<uint32_t>(s);
+	uint32_t cBits = std::bit_cast<uint32_t>(c);
+	uint32_t swapMask = 0u - uint32_t(quadrant & 1);
+	uint32_t sinBits = (sBits & ~swapMask) | (cBits & swapMask);
+	uint32_t cosBits = (cBits & ~swapMask) | (sBits & swapMask);
+	sinBits ^= uint32_t(quadrant & 2) << 30;
+	cosBits ^= uint32_t((quadrant + 1) & 2) << 30;
+	sin = std::bit_cast<float>(sinBits);
+	cos = std::bit_cast<float>(cosBits);
+}
+
+} // namespace FastMathDetail
+
+template<MathPrecision precision = kMathPrecision>
+inline void SinCos(float radian, float& sin, float& cos) {
+	if constexpr (precision != MathPrecision::kPrecise) {
+		if (std::fabs(radian) <= FastMathDetail::kMaxReducedInput) {
+			FastMathDetail::SinCosPolynomial<precision>(radian, sin, cos);
+			return;
+		}
+	}
+	sin = std::sin(radian);
+	cos = std::cos(radian);
+}
+
+// sin と cos の一括計算 (kFast は AVX2 で 8 個ずつ計算する)
+void SinCosArrayFast(const float* radians, float* sines, float* cosines, size_t count);
+
+template<MathPrecision precision = kMathPrecision>
+inline void SinCosArray(const float* radians, float* sines, float* cosines, size_t count) {
+	if constexpr (precision == MathPrecision::kFast) {
+		SinCosArrayFast(radians, sines, cosines, count);
+	} else {
+		for (size_t i = 0; i < count; ++i) {
+			SinCos<precision>(radians[i], sines[i], cosines[i]);
+		}
+	}
+}
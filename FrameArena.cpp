@@ -0,0 +1,59 @@
+﻿#include "FrameArena.h"
+
+FrameArena::FrameArena(size_t initialCapacity) {
+	if (initialCapacity > 0) {
+		AddBlock(initialCapacity);
+	}
+}
+
+void FrameArena::AddBlock(size_t size) {
+	Block block{std::make_unique<std::byte[]>(size), size};
+	// make_unique で 0 を書いているので、ここでページが割り当てられる
+	blocks_.push_back(std::move(block));
+}
+
+void* FrameArena::Allocate(size_t size, size_t alignment) {
+	assert(alignment > 0 && (alignment & (alignment - 1)) == 0);
+	if (!blocks_.empty()) {
+		Block& block = blocks_.back();
+		uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+		size_t aligned = ((base + offset_ + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+		if (aligned + size <= block.size) {
+			offset_ = aligned + size;
+			return block.memory.get() + aligned;
+		}
+		usedBytes_ += offset_;
+	}
+
+	// 足りないので、倍の大きさ (要求が大きければそれ以上) のブロックを足す
+	size_t blockSize = blocks_.empty() ? 0 : blocks_.back().size * 2;
+	if (blockSize < size + alignment) {
+		blockSize = size + alignment;
+	}
+	AddBlock(blockSize);
+	Block& block = blocks_.back();
+	uintptr_t base = reinterpret_cast<uintptr_t>(block.memory.get());
+	size_t aligned = ((base + alignment - 1) & ~uintptr_t(alignment - 1)) - base;
+	offset_ = aligned + size;
+	return block.memory.get() + aligned;
+}
+
+void FrameArena::Reset() {
+	if (blocks_.size() > 1) {
+		// 前のフレームで足したブロックを 1 つにまとめる
+		size_t capacity = GetCapacity();
+		blocks_.clear();
+		AddBlock(capacity);
+	}
+	offset_ = 0;
+	usedBytes_ = 0;
+	++generation_;
+}
+
+size_t FrameArena::GetCapacity() const {
+	size_t capacity = 0;
+	for (const Block& block : blocks_) {
+		capacity += block.size;
+	}
+	return capacity;
+}
@@ -0,0 +1,140 @@
+﻿#pragma once
+#include <cassert>
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <memory>
+#include <type_traits>
+#include <vector>
+
+/*---------------------------------
+ フレームアリーナ
+ ・1 フレームの間だけ使うメモリを先頭から順に切り出す (個別の解放はない)
+ ・フレームの始め (Novice::BeginFrame の直後) に Reset してまとめて捨てる
+ ・足りなければブロックを足し、次の Reset で合計サイズの 1 ブロックにまとめ直す
+   (使う量が落ち着けば、以降のフレームはヒープを確保しない)
+ ・ブロックは確保したときに一度書いておき、フレームの途中でページフォールトが起きないようにする
+ ・複数スレッドから同時に使ってはいけない
+------------------------------------*/
+class FrameArena {
+public:
+	explicit FrameArena(size_t initialCapacity = 64 * 1024);
+	FrameArena(const FrameArena&) = delete;
+	FrameArena& operator=(const FrameArena&) = delete;
+
+	// size バイトを alignment 境界で切り出す
+	void* Allocate(size_t size, size_t alignment);
+
+	// T を count 個分切り出す (コンストラクタは呼ばない)
+	template<typename T>
+	T* AllocateArray(size_t count) {
+		static_assert(std::is_trivially_destructible_v<T>, "デストラクタは呼ばれない");
+		return static_cast<T*>(Allocate(sizeof(T) * count, alignof(T)));
+	}
+
+	// 切り出したメモリをすべて捨てる (以前に返したポインタは使えなくなる)
+	void Reset();
+
+	// 今のフレームで切り出したバイト数
+	size_t GetUsedBytes() const { return usedBytes_ + offset_; }
+	// 確保済みの合計バイト数
+	size_t GetCapacity() const;
+	// Reset のたびに増える (FrameVector が古いフレームのメモリを使っていないか調べる)
+	uint32_t GetGeneration() const { return generation_; }
+
+private:
+	struct Block {
+		std::unique_ptr<std::byte[]> memory;
+		size_t size;
+	};
+
+	void AddBlock(size_t size);
+
+	std::vector<Block> blocks_;
+	// 今使っているブロックの中の位置
+	size_t offset_ = 0;
+	// 使い終わった (前の) ブロックで切り出したバイト数
+	size_t usedBytes_ = 0;
+	uint32_t generation_ = 0;
+};
+
+/*---------------------------------
+ フレームアリーナから確保する可変長配列
+ ・足りなくなったら倍の大きさをアリーナから切り出してコピーする (古い領域は Reset まで残る)
+ ・アリーナを Reset したら作り直すこと
+------------------------------------*/
+template<typename T>
+class FrameVector {
+	static_assert(std::is_trivially_copyable_v<T>, "memcpy で移すので単純な型だけ");
+
+public:
+	explicit FrameVector(FrameArena& arena, size_t capacity = 0)
+	    : arena_(&arena), generation_(arena.GetGeneration()) {
+		if (capacity > 0) {
+			Reserve(capacity);
+		}
+	}
+
+	void PushBack(const T& value) {
+		if (size_ == capacity_) {
+			Reserve(size_ + 1);
+		}
+		data_[size_++] = value;
+	}
+
+	// values から count 個を末尾に足す (count が 0 なら values は nullptr でもよい)
+	void Append(const T* values, size_t count) {
+		if (count == 0) {
+			return;
+		}
+		Reserve(size_ + count);
+		std::memcpy(data_ + size_, values, sizeof(T) * count);
+		size_ += count;
+	}
+
+	// 少なくとも capacity 個入るようにする
+	void Reserve(size_t capacity) {
+		assert(generation_ == arena_->GetGeneration() && "アリーナが Reset された");
+		if (capacity <= capacity_) {
+			return;
+		}
+		size_t newCapacity = capacity_ < 16 ? 16 : capacity_ * 2;
+		if (newCapacity < capacity) {
+			newCapacity = capacity;
+		}
+		T* data = arena_->AllocateArray<T>(newCapacity);
+		if (size_ > 0) {
+			std::memcpy(data, data_, sizeof(T) * size_);
+		}
+		data_ = data;
+		capacity_ = newCapacity;
+	}
+
+	void Clear() { size_ = 0; }
+
+	T* Data() { return data_; }
+	const T* Data() const { return data_; }
+	size_t Size() const { return size_; }
+	bool Empty() const { return size_ == 0; }
+
+	T& operator[](size_t index) {
+		assert(index < size_);
+		return data_[index];
+	}
+	const T& operator[](size_t index) const {
+		assert(index < size_);
+		return data_[index];
+	}
+
+	T* begin() { return data_; }
+	T* end() { return data_ + size_; }
+	const T* begin() const { return data_; }
+	const T* end() const { return data_ + size_; }
+
+private:
+	FrameArena* arena_;
+	T* data_ = nullptr;
+	size_t size_ = 0;
+	size_t capacity_ = 0;
+	uint32_t generation_;
+};
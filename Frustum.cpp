@@ -0,0 +1,110 @@
+﻿#include "Frustum.h"
+#include <cassert>
+#include <cmath>
+
+// 平面の式 ax + by + cz + d >= 0 (内側) を正規化して Plane にする
+static Plane MakePlane(float a, float b, float c, float d) {
+	float length = std::sqrt(a * a + b * b + c * c);
+	assert(length != 0.0f);
+	float invLength = 1.0f / length;
+	return {{a * invLength, b * invLength, c * invLength}, -d * invLength};
+}
+
+Frustum MakeFrustum(const Matrix4x4& viewProjectionMatrix) {
+	// クリップ座標の各成分は行列の列との内積 (行ベクトル × 行列なので)
+	const Matrix4x4& m = viewProjectionMatrix;
+	Vector4 columns[4];
+	for (int i = 0; i < 4; ++i) {
+		columns[i] = {m.m[0][i], m.m[1][i], m.m[2][i], m.m[3][i]};
+	}
+	const Vector4& cx = columns[0];
+	const Vector4& cy = columns[1];
+	const Vector4& cz = columns[2];
+	const Vector4& cw = columns[3];
+
+	Frustum frustum;
+	// -w <= x <= w
+	frustum.planes[kFrustumLeft] = MakePlane(cw.x + cx.x, cw.y + cx.y, cw.z + cx.z, cw.w + cx.w);
+	frustum.planes[kFrustumRight] = MakePlane(cw.x - cx.x, cw.y - cx.y, cw.z - cx.z, cw.w - cx.w);
+	// -w <= y <= w
+	frustum.planes[kFrustumBottom] = MakePlane(cw.x + cy.x, cw.y + cy.y, cw.z + cy.z, cw.w + cy.w);
+	frustum.planes[kFrustumTop] = MakePlane(cw.x - cy.x, cw.y - cy.y, cw.z - cy.z, cw.w - cy.w);
+	// 0 <= z <= w
+	frustum.planes[kFrustumNear] = MakePlane(cz.x, cz.y, cz.z, cz.w);
+	frustum.planes[kFrustumFar] = MakePlane(cw.x - cz.x, cw.y - cz.y, cw.z - cz.z, cw.w - cz.w);
+	return frustum;
+}
+
+float GetSignedDistance(const Plane& plane, const Vector3& point) {
+	return Dot(plane.normal, point) - plane.distance;
+}
+
+FrustumTest TestSphere(const Frustum& frustum, const Sphere& sphere) {
+	FrustumTest result = FrustumTest::kInside;
+	for (const Plane& plane : frustum.planes) {
+		float distance = GetSignedDistance(plane, sphere.center);
+		if (distance < -sphere.radius) {
+			return FrustumTest::kOutside;
+		}
+		if (distance < sphere.radius) {
+			result = FrustumTest::kIntersecting;
+		}
+	}
+	return result;
+}
+
+bool IsSphereInFrontOfNearPlane(const Frustum& frustum, const Sphere& sphere) {
+	return GetSignedDistance(frustum.planes[kFrustumNear], sphere.center) > sphere.radius;
+}
+
+uint32_t ComputeOutcode(const Vector4& clip) {
+	uint32_t code = 0;
+	if (clip.x < -clip.w) {
+		code |= 1u << kFrustumLeft;
+	}
+	if (clip.x > clip.w) {
+		code |= 1u << kFrustumRight;
+	}
+	if (clip.y < -clip.w) {
+		code |= 1u << kFrustumBottom;
+	}
+	if (clip.y > clip.w) {
+		code |= 1u << kFrustumTop;
+	}
+	if (clip.z < 0.0f) {
+		code |= 1u << kFrustumNear;
+	}
+	if (clip.z > clip.w) {
+		code |= 1u << kFrustumFar;
+	}
+	return code;
+}
+
+bool ClipLineNearPlane(Vector4& start, Vector4& end) {
+	uint32_t startCode = ComputeOutcode(start);
+	uint32_t endCode = ComputeOutcode(end);
+	// 両端が同じ平面の外
+	if ((startCode & endCode) != 0) {
+		return false;
+	}
+
+	// 片方だけ near の外なら z = 0 の点まで縮める
+	const uint32_t kNearBit = 1u << kFrustumNear;
+	if ((startCode | endCode) & kNearBit) {
+		float t = start.z / (start.z - end.z);
+		Vector4 point = {
+		    start.x + (end.x - start.x) * t, start.y + (end.y - start.y) * t, 0.0f,
+		    start.w + (end.w - start.w) * t};
+		if (startCode & kNearBit) {
+			start = point;
+		} else {
+			end = point;
+		}
+	}
+	return true;
+}
+
+Vector3 ClipToScreen(const Vector4& clip, const Matrix4x4& viewportMatrix) {
+	float invW = 1.0f / clip.w;
+	return Transform({clip.x * invW, clip.y * invW, clip.z * invW}, viewportMatrix);
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include "Shape.h"
+#include <cstdint>
+
+/*---------------------------------
+ 視錐台
+ ・ビュープロジェクション行列 (MakePerspectiveFovMatrix など) から 6 平面を取り出す
+ ・平面の法線は内側向き。点 p の符号付き距離 Dot(normal, p) - distance が負なら外
+ ・クリップ空間は DirectX と同じ (-w <= x, y <= w, 0 <= z <= w)
+------------------------------------*/
+
+// 平面の番号
+enum FrustumPlane {
+	kFrustumLeft,
+	kFrustumRight,
+	kFrustumBottom,
+	kFrustumTop,
+	kFrustumNear,
+	kFrustumFar,
+	kFrustumPlaneCount,
+};
+
+struct Frustum {
+	Plane planes[kFrustumPlaneCount];
+};
+
+// 球と視錐台の位置関係
+enum class FrustumTest {
+	kOutside,      // 完全に外 (描かなくてよい)
+	kInside,       // 完全に中 (クリップ不要)
+	kIntersecting, // 境界をまたぐ
+};
+
+// ビュープロジェクション行列 (world→クリップ空間) から視錐台を作る
+// ワールド行列を含めて渡せばローカル座標の視錐台になる
+Frustum MakeFrustum(const Matrix4x4& viewProjectionMatrix);
+
+// 点と平面の符号付き距離 (法線側が正)
+float GetSignedDistance(const Plane& plane, const Vector3& point);
+
+// 球と視錐台の判定
+FrustumTest TestSphere(const Frustum& frustum, const Sphere& sphere);
+
+// 球が near 平面より完全に奥にあるか
+// true なら全頂点の w が正なので、クリップなしで w 除算してよい
+bool IsSphereInFrontOfNearPlane(const Frustum& frustum, const Sphere& sphere);
+
+// クリップ空間の点がどの平面の外にあるか (FrustumPlane 番目のビットが立つ)
+uint32_t ComputeOutcode(const Vector4& clip);
+
+// クリップ空間の線分を near 平面 (z = 0) で切る
+// 両端が同じ平面の外なら描く必要がないので false を返す
+// near 以外の平面では切らない (はみ出た分は描画先の 2D クリップに任せる)
+bool ClipLineNearPlane(Vector4& start, Vector4& end);
+
+// クリップ空間の点をscreenへ (w 除算してからビューポート変換)
+Vector3 ClipToScreen(const Vector4& clip, const Matrix4x4& viewportMatrix);
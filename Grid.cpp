@@ -0,0 +1,166 @@
+﻿#include "Grid.h"
+#include "Frustum.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// fadeStart から fadeEnd までを何段階で薄くするか
+const uint32_t kFadeSteps = 8;
+
+// クリップ空間の 2 点の間 (t = 0 で a、1 で b。同次座標のままなら線形に補間してよい)
+Vector4 Lerp(const Vector4& a, const Vector4& b, float t) {
+	return {a.x + (b.x - a.x) * t, a.y + (b.y - a.y) * t, a.z + (b.z - a.z) * t,
+	        a.w + (b.w - a.w) * t};
+}
+
+// 奥行き (w) が depth になる点
+Vector4 LerpToDepth(const Vector4& a, const Vector4& b, float depth) {
+	return Lerp(a, b, (depth - a.w) / (b.w - a.w));
+}
+
+bool IsSameMatrix(const Matrix4x4& m1, const Matrix4x4& m2) {
+	return std::memcmp(&m1, &m2, sizeof(Matrix4x4)) == 0;
+}
+
+} // namespace
+
+Grid::Grid(const GridSettings& settings) { SetSettings(settings); }
+
+void Grid::SetSettings(const GridSettings& settings) {
+	assert(settings.subdivision >= 1 && settings.halfWidth > 0.0f);
+	settings_ = settings;
+	BuildWorldPoints();
+	screenLinesValid_ = false;
+}
+
+void Grid::BuildWorldPoints() {
+	const float halfWidth = settings_.halfWidth;
+	const uint32_t subdivision = settings_.subdivision;
+	// 1つ分の長さ
+	const float every = (halfWidth * 2.0f) / float(subdivision);
+
+	uint32_t lineCount = (subdivision + 1) * 2;
+	worldPoints_.resize(size_t(lineCount) * 2);
+	lineColors_.resize(lineCount);
+	for (uint32_t index = 0; index <= subdivision; ++index) {
+		float st = -halfWidth + (every * index);
+		// 奥から手前への線
+		worldPoints_[index * 2] = {st, 0.0f, -halfWidth};
+		worldPoints_[index * 2 + 1] = {st, 0.0f, halfWidth};
+		// 左から右への線
+		worldPoints_[(subdivision + 1 + index) * 2] = {-halfWidth, 0.0f, st};
+		worldPoints_[(subdivision + 1 + index) * 2 + 1] = {halfWidth, 0.0f, st};
+
+		// 中心の線からの本数で主線か決める
+		int64_t fromCenter = int64_t(index) - int64_t(subdivision / 2);
+		bool major = settings_.majorEvery > 0 && fromCenter % settings_.majorEvery == 0;
+		uint32_t color = major ? settings_.majorColor : settings_.minorColor;
+		lineColors_[index] = color;
+		lineColors_[subdivision + 1 + index] = color;
+	}
+}
+
+void Grid::Update(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix) {
+	if (screenLinesValid_ && IsSameMatrix(viewProjectionMatrix, viewProjectionMatrix_) &&
+	    IsSameMatrix(viewportMatrix, viewportMatrix_)) {
+		return;
+	}
+	BuildScreenLines(viewProjectionMatrix, viewportMatrix);
+	viewProjectionMatrix_ = viewProjectionMatrix;
+	viewportMatrix_ = viewportMatrix;
+	screenLinesValid_ = true;
+	++rebuildCount_;
+}
+
+void Grid::BuildScreenLines(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix) {
+	PROFILE_SCOPE("Grid::Build");
+	// まとめてクリップ空間まで変換する
+	clipPoints_.resize(worldPoints_.size());
+	TransformArrayHomogeneous(
+	    worldPoints_.data(), clipPoints_.data(), worldPoints_.size(), viewProjectionMatrix);
+
+	const bool fade = settings_.fadeEnd > settings_.fadeStart;
+	const float fadeStart = settings_.fadeStart;
+	const float fadeEnd = settings_.fadeEnd;
+	const float fadeStep = (fadeEnd - fadeStart) / float(kFadeSteps);
+	screenLines_.clear();
+	auto emitLine = [&](const Vector4& start, const Vector4& end, uint32_t color) {
+		// fadeEnd で切って短くなった線は、丸ごと視錐台の横や上下に外れることがある
+		if (ComputeOutcode(start) & ComputeOutcode(end)) {
+			return;
+		}
+		Vector3 sp = ClipToScreen(start, viewportMatrix);
+		Vector3 ep = ClipToScreen(end, viewportMatrix);
+		screenLines_.push_back({(int)sp.x, (int)sp.y, (int)ep.x, (int)ep.y, color});
+	};
+
+	for (size_t line = 0; line < lineColors_.size(); ++line) {
+		// カメラの後ろに回り込む線があるので near 平面で切ってから w 除算する
+		Vector4 start = clipPoints_[line * 2];
+		Vector4 end = clipPoints_[line * 2 + 1];
+		if (!ClipLineNearPlane(start, end)) {
+			continue;
+		}
+		uint32_t color = lineColors_[line];
+		if (!fade) {
+			emitLine(start, end, color);
+			continue;
+		}
+
+		// w は線の上で線形なので、手前を start にして fadeEnd より奥を切り捨てる
+		if (start.w > end.w) {
+			std::swap(start, end);
+		}
+		if (start.w >= fadeEnd) {
+			continue;
+		}
+		if (end.w > fadeEnd) {
+			end = LerpToDepth(start, end, fadeEnd);
+		}
+		// fadeStart より手前はそのままの色で 1 本
+		if (start.w < fadeStart) {
+			if (end.w <= fadeStart) {
+				emitLine(start, end, color);
+				continue;
+			}
+			Vector4 middle = LerpToDepth(start, end, fadeStart);
+			emitLine(start, middle, color);
+			start = middle;
+		}
+		// 残りは fadeStep ごとに分け、分けた線の中点の奥行きで透明度を決める
+		uint32_t alpha = color & 0xFF;
+		for (uint32_t step = 0; step < kFadeSteps; ++step) {
+			float nearDepth = std::max(fadeStart + fadeStep * float(step), start.w);
+			float farDepth = std::min(fadeStart + fadeStep * float(step + 1), end.w);
+			if (nearDepth >= farDepth) {
+				continue;
+			}
+			Vector4 stepStart = nearDepth == start.w ? start : LerpToDepth(start, end, nearDepth);
+			Vector4 stepEnd = farDepth == end.w ? end : LerpToDepth(start, end, farDepth);
+			float t = (fadeEnd - (nearDepth + farDepth) * 0.5f) / (fadeEnd - fadeStart);
+			emitLine(stepStart, stepEnd, (color & 0xFFFFFF00) | uint32_t(float(alpha) * t));
+		}
+	}
+}
+
+void Grid::Draw(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawSink& sink) {
+	Update(viewProjectionMatrix, viewportMatrix);
+	if (!screenLines_.empty()) {
+		sink.DrawLines(screenLines_.data(), screenLines_.size());
+	}
+}
+
+void Grid::Draw(
+    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+    FrameLineBuffer& lines) {
+	Update(viewProjectionMatrix, viewportMatrix);
+	if (!screenLines_.empty()) {
+		lines.Append(screenLines_.data(), screenLines_.size());
+	}
+}
@@ -0,0 +1,70 @@
+﻿#pragma once
+#include "DebugDraw.h"
+#include "DrawSink.h"
+#include "Mathfunction.h"
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ Grid (xz 平面の格子)
+ ・広さ・分割数・主線の間隔・遠くを薄くする奥行きを GridSettings で決める
+ ・ワールド座標の線は設定したときに一度だけ作る
+ ・画面の線はビュープロジェクション行列とビューポート行列ごとに覚えておき、
+   どちらも前回と同じなら作り直さずに出す (カメラが止まっていれば変換も near クリップもしない)
+ ・薄くするときは線を fadeEnd の奥行きで切り、fadeStart から先をいくつかに分けて
+   分けた線ごとに奥行きで透明度を決める (大きな Grid でも遠くの線は作らない)
+------------------------------------*/
+struct GridSettings {
+	// 中心から端までの長さ
+	float halfWidth = 2.0f;
+	// 一辺の分割数 (線は各向きに subdivision + 1 本)
+	uint32_t subdivision = 10;
+	// 中心の線から数えて majorEvery 本ごとを主線にする (0 なら全部副線)
+	uint32_t majorEvery = 0;
+	uint32_t majorColor = kColorWhite;
+	uint32_t minorColor = kColorWhite;
+	// カメラからの奥行き (クリップ空間の w) が fadeStart から fadeEnd の間で透明にしていき、
+	// fadeEnd より奥は描かない (fadeEnd が fadeStart 以下なら薄くしない)
+	float fadeStart = 0.0f;
+	float fadeEnd = 0.0f;
+};
+
+class Grid {
+public:
+	explicit Grid(const GridSettings& settings = GridSettings());
+
+	// 設定を変える (ワールド座標の線を作り直す)
+	void SetSettings(const GridSettings& settings);
+	const GridSettings& GetSettings() const { return settings_; }
+
+	// 線を出す (行列が前回と同じなら前回の線をそのまま出す)
+	void Draw(
+	    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix, DrawSink& sink);
+	void Draw(
+	    const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix,
+	    FrameLineBuffer& lines);
+
+	// 前回の Draw で出した線
+	const std::vector<ScreenLine>& GetScreenLines() const { return screenLines_; }
+	// 画面の線を作り直した回数 (キャッシュが効いているかを見る)
+	uint64_t GetRebuildCount() const { return rebuildCount_; }
+
+private:
+	// 行列が前回と違えば画面の線を作り直す
+	void Update(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix);
+	void BuildWorldPoints();
+	void BuildScreenLines(const Matrix4x4& viewProjectionMatrix, const Matrix4x4& viewportMatrix);
+
+	GridSettings settings_;
+	// ワールド座標の線の始点と終点、線ごとの色
+	std::vector<Vector3> worldPoints_;
+	std::vector<uint32_t> lineColors_;
+	// クリップ空間の点 (作り直すときの作業用。容量を使い回す)
+	std::vector<Vector4> clipPoints_;
+	std::vector<ScreenLine> screenLines_;
+	// screenLines_ を作ったときの行列
+	Matrix4x4 viewProjectionMatrix_{};
+	Matrix4x4 viewportMatrix_{};
+	bool screenLinesValid_ = false;
+	uint64_t rebuildCount_ = 0;
+};
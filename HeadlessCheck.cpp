@@ -0,0 +1,909 @@
+﻿#include "Bvh.h"
+#include "CameraRelative.h"
+#include "Collision.h"
+#include "DebugDraw.h"
+#include "Grid.h"
+#include "HeadlessDrawSink.h"
+#include "JobSystem.h"
+#include "MathSimd.h"
+#include "ParallelLineBuffer.h"
+#include "Quaternion.h"
+#include "Rasterizer.h"
+#include "ScreenVertex.h"
+#include "TransformHierarchy.h"
+#include "Vector3Soa.h"
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <immintrin.h>
+#include <vector>
+
+/*---------------------------------
+ 画面なしの回帰チェック
+ ・速い経路 (並列・SIMD・グリッド) が基準の経路と同じ結果になるかを確かめる
+ ・使い方: HeadlessCheck (失敗があれば 1 を返す)
+ ・フレームの線のハッシュは、決まったシーンを描いた線 (長さ 0 の線を除いた集合) と画素の値
+   点の変換に FMA を使う AVX2 / AVX-512 とそれ以外で丸めが違うので基準値は 2 組ある
+   描画を意図して変えたときは、表示された値で基準値を書き換える
+------------------------------------*/
+
+namespace {
+
+int failureCount = 0;
+
+void Report(bool ok, const char* name) {
+	std::printf("%s  %s\n", ok ? "ok  " : "FAIL", name);
+	if (!ok) {
+		++failureCount;
+	}
+}
+
+// 標準ライブラリの分布は処理系で値が変わるので、シーンは自前の乱数で作る
+class Random {
+public:
+	explicit Random(uint32_t seed) : state_(seed) {}
+	// [minimum, maximum)
+	float Next(float minimum, float maximum) {
+		state_ ^= state_ << 13;
+		state_ ^= state_ >> 17;
+		state_ ^= state_ << 5;
+		return minimum + (maximum - minimum) * float(state_ >> 8) * (1.0f / 16777216.0f);
+	}
+
+private:
+	uint32_t state_;
+};
+
+// FNV-1a
+class Hash {
+public:
+	void Add(uint32_t value) {
+		for (int i = 0; i < 4; ++i) {
+			value_ ^= (value >> (i * 8)) & 0xFF;
+			value_ *= 1099511628211ull;
+		}
+	}
+	uint64_t Get() const { return value_; }
+
+private:
+	uint64_t value_ = 14695981039346656037ull;
+};
+
+// 相対誤差で比較 (FMA の有無で丸めが違う計算に使う)
+bool IsNearlyEqual(float a, float b, float tolerance) {
+	float scale = std::fmax(1.0f, std::fmax(std::fabs(a), std::fabs(b)));
+	return std::fabs(a - b) <= tolerance * scale;
+}
+
+bool IsNearlyEqual(const Vector3& a, const Vector3& b, float tolerance) {
+	return IsNearlyEqual(a.x, b.x, tolerance) && IsNearlyEqual(a.y, b.y, tolerance) &&
+	       IsNearlyEqual(a.z, b.z, tolerance);
+}
+
+bool IsSameLine(const ScreenLine& a, const ScreenLine& b) {
+	return a.x1 == b.x1 && a.y1 == b.y1 && a.x2 == b.x2 && a.y2 == b.y2 && a.color == b.color;
+}
+
+bool IsSameLines(const std::vector<ScreenLine>& a, const std::vector<ScreenLine>& b) {
+	return a.size() == b.size() && std::equal(a.begin(), a.end(), b.begin(), IsSameLine);
+}
+
+bool IsSamePair(const CollisionPair& a, const CollisionPair& b) {
+	return a.a == b.a && a.b == b.b;
+}
+
+bool IsPairOrdered(const CollisionPair& a, const CollisionPair& b) {
+	return a.a < b.a || (a.a == b.a && a.b < b.b);
+}
+
+/*---------------------------------
+ 行列のカーネル
+------------------------------------*/
+
+// 今のカーネルがスカラー版と誤差の範囲で一致するか (VerifyMathKernels)
+void CheckMathKernels() {
+	const MathIsa isa = GetMathKernels().isa;
+	char name[128];
+	std::snprintf(
+	    name, sizeof(name), "math kernels: VerifyMathKernels (%s)", GetMathIsaName(isa));
+	Report(VerifyMathKernels(isa, 1.0e-4f), name);
+}
+
+/*---------------------------------
+ SoA
+------------------------------------*/
+
+// 今のカーネルの SoA の一括計算を Vector3 の関数と比べる
+// 要素数は 0 から 33 (AVX-512 の 16 要素を 2 回と端数、AVX2 の 8 要素の端数をすべて通る)
+// 長さ 0 のベクトルを混ぜて Normalize の 0 の扱いも見る
+void CheckVector3Soa() {
+	const float kTolerance = 1.0e-5f;
+	const Matrix4x4 matrix = MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f);
+	Random random(13);
+	bool copies = true;
+	bool matches = true;
+	for (size_t size = 0; size <= 33; ++size) {
+		std::vector<Vector3> a(size);
+		std::vector<Vector3> b(size);
+		for (size_t i = 0; i < size; ++i) {
+			// 透視投影の w は z なので z は正にしておく
+			a[i] = {random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f),
+			        random.Next(1.0f, 10.0f)};
+			b[i] = {random.Next(-10.0f, 10.0f), random.Next(-10.0f, 10.0f),
+			        random.Next(1.0f, 10.0f)};
+			if (i % 5 == 3) {
+				b[i] = {0.0f, 0.0f, 0.0f};
+			}
+		}
+		const Vector3Soa soaA(a.data(), size);
+		const Vector3Soa soaB(b.data(), size);
+
+		// コピー (空の配列のコピーも含む)
+		Vector3Soa copied(soaA);
+		Vector3Soa assigned;
+		assigned = soaB;
+		copies = copies && copied.Size() == size && assigned.Size() == size;
+		for (size_t i = 0; copies && i < size; ++i) {
+			const Vector3 x = copied.Get(i);
+			const Vector3 y = assigned.Get(i);
+			copies = x.x == a[i].x && x.y == a[i].y && x.z == a[i].z && y.x == b[i].x &&
+			         y.y == b[i].y && y.z == b[i].z;
+		}
+
+		Vector3Soa sum, difference, scaled, cross, normalized, transformed;
+		std::vector<float> dots(size), lengths(size);
+		Vec3Add(soaA, soaB, sum);
+		Vec3Subtract(soaA, soaB, difference);
+		Vec3Multiply(-1.5f, soaA, scaled);
+		Dot(soaA, soaB, dots.data());
+		Cross(soaA, soaB, cross);
+		Length(soaB, lengths.data());
+		Normalize(soaB, normalized);
+		TransformArray(soaA, transformed, matrix);
+		matches = matches && sum.Size() == size && difference.Size() == size &&
+		          scaled.Size() == size && cross.Size() == size && normalized.Size() == size &&
+		          transformed.Size() == size;
+		for (size_t i = 0; matches && i < size; ++i) {
+			matches =
+			    IsNearlyEqual(sum.Get(i), Vec3Add(a[i], b[i]), kTolerance) &&
+			    IsNearlyEqual(difference.Get(i), Vec3Subtract(a[i], b[i]), kTolerance) &&
+			    IsNearlyEqual(scaled.Get(i), Vec3Multiply(-1.5f, a[i]), kTolerance) &&
+			    IsNearlyEqual(dots[i], Dot(a[i], b[i]), kTolerance) &&
+			    IsNearlyEqual(cross.Get(i), Cross(a[i], b[i]), kTolerance) &&
+			    IsNearlyEqual(lengths[i], Length(b[i]), kTolerance) &&
+			    IsNearlyEqual(normalized.Get(i), Normalize(b[i]), kTolerance) &&
+			    IsNearlyEqual(transformed.Get(i), TransformScalar(a[i], matrix), kTolerance);
+		}
+	}
+	char name[128];
+	std::snprintf(
+	    name, sizeof(name), "soa: copy / assignment (%s)", GetMathIsaName(GetMathKernels().isa));
+	Report(copies, name);
+	std::snprintf(
+	    name, sizeof(name), "soa: bulk ops == Vector3 functions (%s)",
+	    GetMathIsaName(GetMathKernels().isa));
+	Report(matches, name);
+}
+
+/*---------------------------------
+ クォータニオン
+------------------------------------*/
+
+// 単位クォータニオン (球の中から選んで正規化すると向きが偏らない)
+Quaternion NextUnitQuaternion(Random& random) {
+	Quaternion q;
+	float normSquared;
+	do {
+		q = {random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f),
+		     random.Next(-1.0f, 1.0f)};
+		normSquared = Dot(q, q);
+	} while (normSquared < 0.01f || normSquared > 1.0f);
+	return Normalize(q);
+}
+
+// 2 つの回転の角度の差 (rad)
+// acos(|Dot|) は差が小さいと float の丸めだけで 1e-3 rad ほどずれるので、差の長さから求める
+double AngleBetween(const Quaternion& a, const Quaternion& b) {
+	double sign = Dot(a, b) < 0.0f ? -1.0 : 1.0;
+	double x = double(a.x) - sign * b.x;
+	double y = double(a.y) - sign * b.y;
+	double z = double(a.z) - sign * b.z;
+	double w = double(a.w) - sign * b.w;
+	return 4.0 * std::asin(std::sqrt(x * x + y * y + z * z + w * w) * 0.5);
+}
+
+// 今のカーネルの SlerpFastArray を SlerpFast と Slerp に比べる
+// 要素数は 8 の倍数でない 1003 (AVX2 の 8 要素ずつとスカラーの端数を両方通る)
+// results に q0s / q1s と同じ配列を渡す呼び方は、別の配列に出したものとビット単位で一致すること
+void CheckSlerpFast() {
+	const size_t kCount = 1003;
+	const float kTolerance = 1.0e-5f;
+	const double kMaxAngle = 1.0e-3; // Quaternion.h に書いた Slerp との差
+	Random random(17);
+	std::vector<Quaternion> q0s(kCount), q1s(kCount);
+	std::vector<float> ts(kCount);
+	for (size_t i = 0; i < kCount; ++i) {
+		q0s[i] = NextUnitQuaternion(random);
+		q1s[i] = NextUnitQuaternion(random);
+		ts[i] = random.Next(0.0f, 1.0f);
+	}
+	// t の端と、角度の差が最も大きくなる内積 0 付近を入れておく
+	// (ちょうど 0 だとどちらの経路も最短なので、丸めで符号が変わらないよう少し正にする)
+	ts[0] = 0.0f;
+	ts[1] = 1.0f;
+	const Quaternion& q = q0s[2];
+	q1s[2] = Normalize(
+	    {-q.y + 0.02f * q.x, q.x + 0.02f * q.y, -q.w + 0.02f * q.z, q.z + 0.02f * q.w});
+
+	std::vector<Quaternion> results(kCount);
+	SlerpFastArray(q0s.data(), q1s.data(), ts.data(), results.data(), kCount);
+
+	bool matches = true;
+	double maxAngle = 0.0;
+	for (size_t i = 0; i < kCount; ++i) {
+		const Quaternion expected = SlerpFast(q0s[i], q1s[i], ts[i]);
+		matches = matches && IsNearlyEqual(results[i].x, expected.x, kTolerance) &&
+		          IsNearlyEqual(results[i].y, expected.y, kTolerance) &&
+		          IsNearlyEqual(results[i].z, expected.z, kTolerance) &&
+		          IsNearlyEqual(results[i].w, expected.w, kTolerance);
+		maxAngle = std::max(maxAngle, AngleBetween(results[i], Slerp(q0s[i], q1s[i], ts[i])));
+	}
+
+	std::vector<Quaternion> aliasedQ0s = q0s;
+	std::vector<Quaternion> aliasedQ1s = q1s;
+	SlerpFastArray(aliasedQ0s.data(), q1s.data(), ts.data(), aliasedQ0s.data(), kCount);
+	SlerpFastArray(q0s.data(), aliasedQ1s.data(), ts.data(), aliasedQ1s.data(), kCount);
+	const bool aliased =
+	    std::memcmp(aliasedQ0s.data(), results.data(), kCount * sizeof(Quaternion)) == 0 &&
+	    std::memcmp(aliasedQ1s.data(), results.data(), kCount * sizeof(Quaternion)) == 0;
+
+	const char* isaName = GetMathIsaName(GetMathKernels().isa);
+	char name[128];
+	std::snprintf(name, sizeof(name), "quaternion: SlerpFastArray == SlerpFast (%s)", isaName);
+	Report(matches, name);
+	std::snprintf(
+	    name, sizeof(name), "quaternion: SlerpFastArray results aliasing q0s / q1s (%s)", isaName);
+	Report(aliased, name);
+	std::snprintf(
+	    name, sizeof(name), "quaternion: SlerpFastArray vs Slerp max %.2e rad (%s)", maxAngle,
+	    isaName);
+	Report(maxAngle <= kMaxAngle, name);
+}
+
+/*---------------------------------
+ カメラ基準の座標
+------------------------------------*/
+
+Matrix4x4d ToMatrix4x4d(const Matrix4x4& m) {
+	Matrix4x4d result;
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			result.m[row][column] = m.m[row][column];
+		}
+	}
+	return result;
+}
+
+// 原点から 1e6 離れた物とカメラを、カメラ基準の行列 (float) と double の行列で画面に写して比べる
+// 同じ場面を float のワールド行列とビュー行列で写すと桁が落ちて基準を超えることも確かめる
+// (場面が原点に近すぎて差が出ない、という見落としを防ぐ)
+void CheckCameraRelative() {
+	const size_t kCount = 64;
+	const double kMaxPixelError = 0.01;
+	const float kWidth = 1280.0f;
+	const float kHeight = 720.0f;
+	const Vector3d cameraPosition = {1.0e6 + 0.37, 12.5, -1.0e6 + 0.71};
+	const Vector3 cameraRotate = {0.3f, 0.5f, 0.0f};
+	const Matrix4x4 projectionMatrix =
+	    MakePerspectiveFovMatrix(0.45f, kWidth / kHeight, 0.1f, 100.0f);
+	const Matrix4x4 viewportMatrix = MakeViewportMatrix(0.0f, 0.0f, kWidth, kHeight, 0.0f, 1.0f);
+	const Matrix4x4 cameraRotateMatrix =
+	    MakeAffineMatrix({1.0f, 1.0f, 1.0f}, cameraRotate, {0.0f, 0.0f, 0.0f});
+
+	// 物はカメラの前 5 から 50 の範囲に置く
+	Random random(23);
+	std::vector<Vector3> scales(kCount), rotates(kCount), points(kCount);
+	std::vector<Vector3d> translates(kCount);
+	for (size_t i = 0; i < kCount; ++i) {
+		scales[i] = {random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f)};
+		rotates[i] = {random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f), random.Next(-3.0f, 3.0f)};
+		points[i] = {random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f), random.Next(-1.0f, 1.0f)};
+		const float depth = random.Next(5.0f, 50.0f);
+		const Vector3 offset = TransformScalar(
+		    Vector3{random.Next(-0.3f, 0.3f) * depth, random.Next(-0.2f, 0.2f) * depth, depth},
+		    cameraRotateMatrix);
+		translates[i] = Vec3Add(cameraPosition, Vec3Cast<double>(offset));
+	}
+
+	// カメラ基準 (float)
+	std::vector<Matrix4x4> worldMatrices(kCount);
+	MakeCameraRelativeAffineMatrices(
+	    scales.data(), rotates.data(), translates.data(), cameraPosition, worldMatrices.data(),
+	    kCount);
+	const Matrix4x4 viewProjectionViewportMatrix = Multiply(
+	    Multiply(MakeCameraRelativeViewMatrix(cameraRotate), projectionMatrix), viewportMatrix);
+
+	// 基準 (double)。回転の部分は float の行列をそのまま使い、平行移動だけ double で入れる
+	Matrix4x4d cameraMatrixd = ToMatrix4x4d(cameraRotateMatrix);
+	cameraMatrixd.m[3][0] = cameraPosition.x;
+	cameraMatrixd.m[3][1] = cameraPosition.y;
+	cameraMatrixd.m[3][2] = cameraPosition.z;
+	const Matrix4x4d viewProjectionViewportMatrixd = MultiplyScalar(
+	    MultiplyScalar(InverseRigidScalar(cameraMatrixd), ToMatrix4x4d(projectionMatrix)),
+	    ToMatrix4x4d(viewportMatrix));
+
+	// float のワールド行列とビュー行列 (カメラ基準にしない場合)
+	const Matrix4x4 naiveViewProjectionViewportMatrix = Multiply(
+	    Multiply(
+	        InverseRigid(MakeAffineMatrix(
+	            {1.0f, 1.0f, 1.0f}, cameraRotate, Vec3Cast<float>(cameraPosition))),
+	        projectionMatrix),
+	    viewportMatrix);
+
+	double maxError = 0.0;
+	double maxNaiveError = 0.0;
+	for (size_t i = 0; i < kCount; ++i) {
+		Matrix4x4d worldMatrixd =
+		    ToMatrix4x4d(MakeAffineMatrix(scales[i], rotates[i], {0.0f, 0.0f, 0.0f}));
+		worldMatrixd.m[3][0] = translates[i].x;
+		worldMatrixd.m[3][1] = translates[i].y;
+		worldMatrixd.m[3][2] = translates[i].z;
+		const Vector3d expected = TransformScalar(
+		    Vec3Cast<double>(points[i]),
+		    MultiplyScalar(worldMatrixd, viewProjectionViewportMatrixd));
+
+		const Vector3 relative =
+		    Transform(points[i], Multiply(worldMatrices[i], viewProjectionViewportMatrix));
+		const Vector3 naive = Transform(
+		    points[i],
+		    Multiply(
+		        MakeAffineMatrix(scales[i], rotates[i], Vec3Cast<float>(translates[i])),
+		        naiveViewProjectionViewportMatrix));
+		maxError = std::max(
+		    maxError,
+		    std::max(std::fabs(relative.x - expected.x), std::fabs(relative.y - expected.y)));
+		maxNaiveError = std::max(
+		    maxNaiveError,
+		    std::max(std::fabs(naive.x - expected.x), std::fabs(naive.y - expected.y)));
+	}
+
+	const char* isaName = GetMathIsaName(GetMathKernels().isa);
+	char name[128];
+	std::snprintf(
+	    name, sizeof(name), "camera relative: screen error %.3g px at 1e6 (%s)", maxError,
+	    isaName);
+	Report(maxError <= kMaxPixelError, name);
+	std::snprintf(
+	    name, sizeof(name), "camera relative: float world/view error %.3g px exceeds bound (%s)",
+	    maxNaiveError, isaName);
+	Report(maxNaiveError > kMaxPixelError, name);
+}
+
+/*---------------------------------
+ フレームの線
+------------------------------------*/
+
+// 決まったシーン (乱数の球と、近クリップ面をまたぐ球)
+std::vector<Sphere> MakeFrameSpheres() {
+	Random random(3);
+	std::vector<Sphere> spheres(2000);
+	for (Sphere& sphere : spheres) {
+		sphere.center = {random.Next(-15.0f, 15.0f), random.Next(-15.0f, 15.0f),
+		                 random.Next(-15.0f, 15.0f)};
+		sphere.radius = random.Next(0.2f, 2.0f);
+	}
+	spheres.push_back({{0.0f, 1.9f, -9.5f}, 1.0f});
+	return spheres;
+}
+
+// 長さ 0 の線を除き、向きをそろえて並べた線の集合のハッシュ
+uint64_t HashLineSet(const std::vector<ScreenLine>& lines) {
+	std::vector<ScreenLine> sorted;
+	sorted.reserve(lines.size());
+	for (ScreenLine line : lines) {
+		if (line.x1 == line.x2 && line.y1 == line.y2) {
+			continue;
+		}
+		if (line.x2 < line.x1 || (line.x2 == line.x1 && line.y2 < line.y1)) {
+			std::swap(line.x1, line.x2);
+			std::swap(line.y1, line.y2);
+		}
+		sorted.push_back(line);
+	}
+	std::sort(sorted.begin(), sorted.end(), [](const ScreenLine& a, const ScreenLine& b) {
+		if (a.x1 != b.x1) {
+			return a.x1 < b.x1;
+		}
+		if (a.y1 != b.y1) {
+			return a.y1 < b.y1;
+		}
+		if (a.x2 != b.x2) {
+			return a.x2 < b.x2;
+		}
+		return a.y2 < b.y2;
+	});
+	Hash hash;
+	for (const ScreenLine& line : sorted) {
+		hash.Add(uint32_t(line.x1));
+		hash.Add(uint32_t(line.y1));
+		hash.Add(uint32_t(line.x2));
+		hash.Add(uint32_t(line.y2));
+	}
+	return hash.Get();
+}
+
+uint64_t HashPixels(const std::vector<uint32_t>& pixels) {
+	Hash hash;
+	for (uint32_t pixel : pixels) {
+		hash.Add(pixel);
+	}
+	return hash.Get();
+}
+
+// 今のカーネルでフレームを描き、1 球ずつ描いたものと基準値に比べる
+void CheckFrameLines(uint64_t expectedLineSet, uint64_t expectedPixels) {
+	const int kWidth = 1280;
+	const int kHeight = 720;
+	const std::vector<Sphere> spheres = MakeFrameSpheres();
+	const Matrix4x4 viewProjectionMatrix = Multiply(
+	    Inverse(MakeAffineMatrix({1.0f, 1.0f, 1.0f}, {0.26f, 0.0f, 0.0f}, {0.0f, 1.9f, -10.0f})),
+	    MakePerspectiveFovMatrix(0.45f, float(kWidth) / float(kHeight), 0.1f, 100.0f));
+	const Matrix4x4 viewportMatrix =
+	    MakeViewportMatrix(0.0f, 0.0f, float(kWidth), float(kHeight), 0.0f, 1.0f);
+
+	JobSystem jobSystem(4);
+	ParallelLineBuffer lineBuffer;
+	HeadlessDrawSink parallelSink(kWidth, kHeight);
+	DrawSpheres(
+	    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorWhite,
+	    jobSystem, lineBuffer, parallelSink);
+
+	HeadlessDrawSink serialSink(kWidth, kHeight);
+	for (const Sphere& sphere : spheres) {
+		DrawSphere(sphere, viewProjectionMatrix, viewportMatrix, kColorWhite, serialSink);
+	}
+
+	char name[128];
+	std::snprintf(
+	    name, sizeof(name), "frame lines: DrawSpheres == DrawSphere (%s)",
+	    GetMathIsaName(GetMathKernels().isa));
+	Report(
+	    IsSameLines(parallelSink.GetLines(), serialSink.GetLines()) &&
+	        parallelSink.GetPixels() == serialSink.GetPixels(),
+	    name);
+
+	uint64_t lineSet = HashLineSet(parallelSink.GetLines());
+	uint64_t pixels = HashPixels(parallelSink.GetPixels());
+	std::snprintf(
+	    name, sizeof(name), "frame lines: golden hash (%s)", GetMathIsaName(GetMathKernels().isa));
+	Report(lineSet == expectedLineSet && pixels == expectedPixels, name);
+	if (lineSet != expectedLineSet || pixels != expectedPixels) {
+		std::printf("      line set %016" PRIx64 " pixels %016" PRIx64 "\n", lineSet, pixels);
+	}
+
+	// 線が 1 本も出ない DrawSpheres (すべてカメラの後ろ、0 個) をフレームアリーナに溜める
+	// 空の FrameLineBuffer に足すときと、線の溜まった FrameLineBuffer に足すときの両方
+	std::vector<Sphere> culled(64);
+	std::vector<Vector3> culledCenters(culled.size());
+	std::vector<float> culledRadii(culled.size());
+	for (size_t i = 0; i < culled.size(); ++i) {
+		culled[i] = {{float(i % 8) - 4.0f, float(i / 8) - 4.0f, -40.0f}, 1.0f};
+		culledCenters[i] = culled[i].center;
+		culledRadii[i] = culled[i].radius;
+	}
+	FrameArena arena;
+	FrameLineBuffer emptyLines(arena);
+	DrawSpheres(
+	    culled.data(), culled.size(), viewProjectionMatrix, viewportMatrix, kColorWhite,
+	    jobSystem, lineBuffer, emptyLines);
+	DrawSpheres(
+	    culledCenters.data(), culledRadii.data(), culled.size(), viewProjectionMatrix,
+	    viewportMatrix, kColorWhite, jobSystem, lineBuffer, emptyLines);
+	DrawSpheres(
+	    culledCenters.data(), culledRadii.data(), 0, viewProjectionMatrix, viewportMatrix,
+	    kColorWhite, jobSystem, lineBuffer, emptyLines);
+
+	FrameLineBuffer lines(arena);
+	DrawSphere(spheres.back(), viewProjectionMatrix, viewportMatrix, kColorWhite, lines);
+	const std::vector<ScreenLine> sphereLines(lines.Data(), lines.Data() + lines.Size());
+	DrawSpheres(
+	    culled.data(), culled.size(), viewProjectionMatrix, viewportMatrix, kColorWhite,
+	    jobSystem, lineBuffer, lines);
+	DrawSpheres(
+	    culledCenters.data(), culledRadii.data(), 0, viewProjectionMatrix, viewportMatrix,
+	    kColorWhite, jobSystem, lineBuffer, lines);
+	HeadlessDrawSink emptySink(kWidth, kHeight);
+	SubmitLines(emptyLines, emptySink);
+	HeadlessDrawSink linesSink(kWidth, kHeight);
+	SubmitLines(lines, linesSink);
+
+	std::snprintf(
+	    name, sizeof(name), "frame lines: all-culled / zero-count DrawSpheres add no lines (%s)",
+	    GetMathIsaName(GetMathKernels().isa));
+	Report(
+	    emptyLines.Empty() && emptySink.GetLines().empty() && !sphereLines.empty() &&
+	        IsSameLines(linesSink.GetLines(), sphereLines),
+	    name);
+}
+
+// 既定の設定の Grid は DrawGrid と同じ線を出す
+void CheckGrid() {
+	const Matrix4x4 viewProjectionMatrix = Multiply(
+	    Inverse(MakeAffineMatrix({1.0f, 1.0f, 1.0f}, {0.26f, 0.0f, 0.0f}, {0.0f, 1.9f, -6.49f})),
+	    MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f));
+	const Matrix4x4 viewportMatrix = MakeViewportMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f);
+	HeadlessDrawSink expected;
+	DrawGrid(viewProjectionMatrix, viewportMatrix, expected);
+	HeadlessDrawSink actual;
+	Grid grid;
+	grid.Draw(viewProjectionMatrix, viewportMatrix, actual);
+	// 2 回目は覚えておいた線をそのまま出す
+	grid.Draw(viewProjectionMatrix, viewportMatrix, actual);
+	std::vector<ScreenLine> twice = expected.GetLines();
+	twice.insert(twice.end(), expected.GetLines().begin(), expected.GetLines().end());
+	Report(IsSameLines(actual.GetLines(), twice), "grid: Grid == DrawGrid");
+}
+
+/*---------------------------------
+ 衝突判定
+------------------------------------*/
+
+// ふつうの球に、セルより大きい球と遠くの球を混ぜる
+std::vector<Sphere> MakeCollisionSpheres(Random& random) {
+	std::vector<Sphere> spheres(3000);
+	for (Sphere& sphere : spheres) {
+		sphere.center = {random.Next(-50.0f, 50.0f), random.Next(-50.0f, 50.0f),
+		                 random.Next(-50.0f, 50.0f)};
+		sphere.radius = 0.5f;
+	}
+	spheres[5].radius = 20.0f;
+	spheres[77].radius = 9.0f;
+	spheres[100].center = {3.0e7f, 0.0f, 0.0f};
+	spheres[101].center = {3.0e7f, 0.5f, 0.0f};
+	spheres[200].center = {-1.0e9f, 0.0f, 0.0f};
+	return spheres;
+}
+
+void CheckBroadphase() {
+	Random random(7);
+	std::vector<Sphere> spheres = MakeCollisionSpheres(random);
+	SphereBroadphase broadphase(2.0f);
+	JobSystem jobSystem(4);
+	bool matches = true;
+	bool sameOrder = true;
+	std::vector<CollisionPair> expected;
+	std::vector<CollisionPair> serial;
+	std::vector<CollisionPair> parallel;
+	// 少しずつ動かして差分の並べ直しも通す
+	for (int frame = 0; frame < 4; ++frame) {
+		for (Sphere& sphere : spheres) {
+			sphere.center.x += random.Next(-1.0f, 1.0f);
+		}
+		spheres[300].radius = float(frame) * 4.0f;
+		broadphase.Update(spheres.data(), spheres.size());
+
+		expected.clear();
+		for (uint32_t i = 0; i < spheres.size(); ++i) {
+			for (uint32_t j = i + 1; j < spheres.size(); ++j) {
+				if (IsCollision(spheres[i], spheres[j])) {
+					expected.push_back({i, j});
+				}
+			}
+		}
+		broadphase.FindPairs(serial);
+		broadphase.FindPairs(parallel, jobSystem);
+		sameOrder = sameOrder && serial.size() == parallel.size() &&
+		            std::equal(serial.begin(), serial.end(), parallel.begin(), IsSamePair);
+		std::sort(serial.begin(), serial.end(), IsPairOrdered);
+		matches = matches && serial.size() == expected.size() &&
+		          std::equal(serial.begin(), serial.end(), expected.begin(), IsSamePair);
+	}
+	Report(matches, "broadphase: FindPairs == brute force");
+	Report(sameOrder, "broadphase: serial == parallel");
+}
+
+// spheres で作った BVH の問い合わせを総当たりと比べる
+// 問い合わせは球の近くに作るので、どんな配置でも当たるものと外れるものが混ざる
+void CheckBvhQueries(const char* name, std::vector<Sphere> spheres, Random& random) {
+	SphereBvh bvh;
+	bvh.Build(spheres.data(), spheres.size());
+
+	auto pickCenter = [&]() {
+		size_t index = std::min(
+		    spheres.size() - 1, size_t(random.Next(0.0f, 1.0f) * float(spheres.size())));
+		return spheres[index].center;
+	};
+	auto jitter = [&](float amount) {
+		return Vector3{random.Next(-amount, amount), random.Next(-amount, amount),
+		               random.Next(-amount, amount)};
+	};
+
+	bool overlapMatches = true;
+	bool raycastMatches = true;
+	std::vector<uint32_t> indices;
+	std::vector<uint32_t> expectedIndices;
+	std::vector<RayHit> hits;
+	for (int pass = 0; pass < 2; ++pass) {
+		if (pass == 1) {
+			// 動かして箱だけ直す
+			for (Sphere& sphere : spheres) {
+				sphere.center.y += random.Next(-2.0f, 2.0f);
+			}
+			bvh.Refit(spheres.data(), spheres.size());
+		}
+		for (int query = 0; query < 200; ++query) {
+			Sphere probe{Vec3Add(pickCenter(), jitter(3.0f)), random.Next(0.5f, 5.0f)};
+			bvh.QueryOverlap(probe, indices);
+			expectedIndices.clear();
+			for (uint32_t i = 0; i < spheres.size(); ++i) {
+				if (IsCollision(probe, spheres[i])) {
+					expectedIndices.push_back(i);
+				}
+			}
+			std::sort(indices.begin(), indices.end());
+			overlapMatches = overlapMatches && indices == expectedIndices;
+
+			// ある球の手前から別の球の向こうまで
+			Vector3 origin = Vec3Add(pickCenter(), Vector3{0.0f, 0.0f, -40.0f});
+			Vector3 target = Vec3Add(pickCenter(), jitter(2.0f));
+			Ray ray{origin, Vec3Multiply(2.0f, Vec3Subtract(target, origin))};
+			size_t expectedCount = 0;
+			float nearestT = INFINITY;
+			for (const Sphere& sphere : spheres) {
+				float t;
+				if (Intersect(ray, sphere, t)) {
+					++expectedCount;
+					nearestT = std::min(nearestT, t);
+				}
+			}
+			RayHit hit;
+			bool found = bvh.Raycast(ray, hit);
+			bvh.RaycastAll(ray, hits);
+			bool sorted = std::is_sorted(
+			    hits.begin(), hits.end(),
+			    [](const RayHit& a, const RayHit& b) { return a.t < b.t; });
+			raycastMatches = raycastMatches && found == (expectedCount > 0) &&
+			                 (!found || hit.t == nearestT) && hits.size() == expectedCount &&
+			                 sorted;
+		}
+	}
+	char message[128];
+	std::snprintf(message, sizeof(message), "bvh: QueryOverlap == brute force (%s)", name);
+	Report(overlapMatches, message);
+	std::snprintf(
+	    message, sizeof(message), "bvh: Raycast / RaycastAll == brute force (%s)", name);
+	Report(raycastMatches, message);
+}
+
+void CheckBvh() {
+	Random random(11);
+	std::vector<Sphere> spheres(2000);
+	for (Sphere& sphere : spheres) {
+		sphere.center = {random.Next(-30.0f, 30.0f), random.Next(-30.0f, 30.0f),
+		                 random.Next(-30.0f, 30.0f)};
+		sphere.radius = random.Next(0.1f, 1.5f);
+	}
+	CheckBvhQueries("random", spheres, random);
+
+	// 等比に並べると SAH は端の数個ずつしか分けないので木が深くなる
+	spheres.resize(3000);
+	for (size_t i = 0; i < spheres.size(); ++i) {
+		spheres[i] = {{std::pow(1.003f, float(i)), 0.0f, 0.0f}, 0.1f};
+	}
+	CheckBvhQueries("geometric", spheres, random);
+
+	// 点をもっと細かく等比に並べると、SAH だけではスタックに収まらない深さになる
+	spheres.resize(200000);
+	for (size_t i = 0; i < spheres.size(); ++i) {
+		spheres[i] = {{std::pow(1.00008f, float(i)), 0.0f, 0.0f}, 0.0f};
+	}
+	CheckBvhQueries("deep", spheres, random);
+}
+
+/*---------------------------------
+ ラスタライザ
+------------------------------------*/
+
+void CheckRasterizer() {
+	const int kWidth = 640;
+	const int kHeight = 360;
+	Random random(5);
+	std::vector<Sphere> spheres(300);
+	for (Sphere& sphere : spheres) {
+		sphere.center = {random.Next(-10.0f, 10.0f), random.Next(-6.0f, 6.0f),
+		                 random.Next(-10.0f, 10.0f)};
+		sphere.radius = random.Next(0.3f, 2.0f);
+	}
+	const Matrix4x4 viewProjectionMatrix = Multiply(
+	    Inverse(MakeAffineMatrix({1.0f, 1.0f, 1.0f}, {0.2f, 0.0f, 0.0f}, {0.0f, 3.0f, -25.0f})),
+	    MakePerspectiveFovMatrix(0.6f, float(kWidth) / float(kHeight), 0.1f, 100.0f));
+	const Matrix4x4 viewportMatrix =
+	    MakeViewportMatrix(0.0f, 0.0f, float(kWidth), float(kHeight), 0.0f, 1.0f);
+
+	Rasterizer serial(kWidth, kHeight);
+	Rasterizer parallel(kWidth, kHeight);
+	serial.Clear(kColorBlack);
+	parallel.Clear(kColorBlack);
+	DrawSolidSpheres(
+	    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorWhite, serial);
+	DrawSolidSpheres(
+	    spheres.data(), spheres.size(), viewProjectionMatrix, viewportMatrix, kColorWhite,
+	    parallel);
+	serial.Flush();
+	JobSystem jobSystem(4);
+	parallel.Flush(jobSystem);
+
+	// 深度は NaN がないので値の比較でビットまで同じになる
+	Report(
+	    serial.GetPixels() == parallel.GetPixels() && serial.GetDepths() == parallel.GetDepths(),
+	    "rasterizer: Flush == Flush(JobSystem)");
+}
+
+/*---------------------------------
+ fp16
+------------------------------------*/
+
+MATH_TARGET_AVX2 bool CheckHalfF16c() {
+	// fp16 -> float はすべての値
+	for (uint32_t value = 0; value < 0x10000; value += 8) {
+		alignas(16) uint16_t halves[8];
+		for (uint32_t i = 0; i < 8; ++i) {
+			halves[i] = uint16_t(value + i);
+		}
+		alignas(32) float expected[8];
+		_mm256_store_ps(
+		    expected, _mm256_cvtph_ps(_mm_load_si128(reinterpret_cast<const __m128i*>(halves))));
+		for (uint32_t i = 0; i < 8; ++i) {
+			float actual = HalfToFloat(halves[i]);
+			if (std::memcmp(&actual, &expected[i], sizeof(float)) != 0) {
+				std::printf("      HalfToFloat(0x%04x)\n", unsigned(halves[i]));
+				return false;
+			}
+		}
+	}
+	// float -> fp16 は 8 個ずつ飛ばしながら (37 * 8 ずつ進むので、丸めに効く下位 13bit は
+	// すべての並びを通る。全部調べると 20 秒以上かかる)
+	for (uint64_t bits = 0; bits < (uint64_t(1) << 32); bits += 37 * 8) {
+		alignas(32) uint32_t floats[8];
+		for (uint32_t i = 0; i < 8; ++i) {
+			floats[i] = uint32_t(bits + i);
+		}
+		alignas(16) uint16_t expected[8];
+		_mm_store_si128(
+		    reinterpret_cast<__m128i*>(expected),
+		    _mm256_cvtps_ph(
+		        _mm256_load_ps(reinterpret_cast<const float*>(floats)),
+		        _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC));
+		for (uint32_t i = 0; i < 8; ++i) {
+			float value;
+			std::memcpy(&value, &floats[i], sizeof(value));
+			if (FloatToHalf(value) != expected[i]) {
+				std::printf("      FloatToHalf(0x%08x)\n", unsigned(floats[i]));
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+void CheckHalf() {
+	if (GetCpuMathIsa() < MathIsa::kAvx2) {
+		std::printf("skip  fp16: F16C is not available\n");
+		return;
+	}
+	Report(CheckHalfF16c(), "fp16: FloatToHalf / HalfToFloat == F16C");
+}
+
+/*---------------------------------
+ トランスフォームの階層
+------------------------------------*/
+
+// 同じ親とローカルの値で、新しく作った階層のワールド行列 (全部作り直した結果)
+std::vector<Matrix4x4> RebuildWorldMatrices(const TransformHierarchy& source) {
+	TransformHierarchy rebuilt;
+	for (uint32_t i = 0; i < source.GetCount(); ++i) {
+		rebuilt.AddNode(
+		    source.GetParent(i), source.GetScale(i), source.GetRotate(i),
+		    source.GetTranslate(i));
+	}
+	rebuilt.UpdateWorldMatrices();
+	return {rebuilt.GetWorldMatrices(), rebuilt.GetWorldMatrices() + rebuilt.GetCount()};
+}
+
+// 途中のノードの親やローカルを変えたあとの UpdateWorldMatrices (変えたところだけ作り直す) が
+// 全部作り直した結果とビット単位で一致するか
+void CheckTransformHierarchy() {
+	const uint32_t kCount = 300;
+	Random random(19);
+	auto nextLocal = [&random](Vector3& scale, Quaternion& rotate, Vector3& translate) {
+		scale = {random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f), random.Next(0.5f, 2.0f)};
+		rotate = NextUnitQuaternion(random);
+		translate = {random.Next(-5.0f, 5.0f), random.Next(-5.0f, 5.0f), random.Next(-5.0f, 5.0f)};
+	};
+
+	// 16 個おきに根を置き、ほかは少し前のノードを親にする (深さはいろいろになる)
+	TransformHierarchy hierarchy;
+	std::vector<uint8_t> hasChild(kCount, 0);
+	for (uint32_t i = 0; i < kCount; ++i) {
+		uint32_t parent = TransformHierarchy::kNoParent;
+		if (i % 16 != 0) {
+			parent = i - 1 - uint32_t(random.Next(0.0f, float(std::min(i, 8u))));
+			hasChild[parent] = 1;
+		}
+		Vector3 scale, translate;
+		Quaternion rotate;
+		nextLocal(scale, rotate, translate);
+		hierarchy.AddNode(parent, scale, rotate, translate);
+	}
+	hierarchy.UpdateWorldMatrices();
+
+	bool matches = true;
+	bool partial = true;
+	for (int round = 0; round < 4; ++round) {
+		// 子のあるノードだけを選んで、親の付け替え (根にする・別の枝に移す) とローカルの変更をする
+		for (int change = 0; change < 6; ++change) {
+			uint32_t index;
+			do {
+				index = 1 + uint32_t(random.Next(0.0f, float(kCount - 1)));
+			} while (!hasChild[index]);
+			if (change % 3 == 0) {
+				uint32_t parent = change == 0 ? TransformHierarchy::kNoParent
+				                              : uint32_t(random.Next(0.0f, float(index)));
+				hierarchy.SetParent(index, parent);
+			} else {
+				Vector3 scale, translate;
+				Quaternion rotate;
+				nextLocal(scale, rotate, translate);
+				hierarchy.SetLocal(index, scale, rotate, translate);
+			}
+		}
+		size_t updatedCount = hierarchy.UpdateWorldMatrices();
+		partial = partial && updatedCount > 0 && updatedCount < kCount;
+
+		std::vector<Matrix4x4> expected = RebuildWorldMatrices(hierarchy);
+		matches = matches && std::memcmp(
+		                         hierarchy.GetWorldMatrices(), expected.data(),
+		                         kCount * sizeof(Matrix4x4)) == 0;
+	}
+	Report(matches, "transform hierarchy: dirty update == full rebuild");
+	Report(partial, "transform hierarchy: dirty update rebuilds only changed subtrees");
+}
+
+} // namespace
+
+int main() {
+	// 基準値 (FMA なしと FMA あり)
+	const uint64_t kFrameLineSet = 0x90f00f0ca34b86acull;
+	const uint64_t kFramePixels = 0x3565a8ae854ba0f6ull;
+	const uint64_t kFrameLineSetFma = 0x1b2aab12253eaf98ull;
+	const uint64_t kFramePixelsFma = 0x1ab7f6c176da1c45ull;
+
+	const MathIsa cpuIsa = GetCpuMathIsa();
+	for (int isa = int(MathIsa::kScalar); isa <= int(cpuIsa); ++isa) {
+		SelectMathKernels(MathIsa(isa));
+		CheckMathKernels();
+		CheckVector3Soa();
+		CheckSlerpFast();
+		CheckCameraRelative();
+		bool fma = MathIsa(isa) >= MathIsa::kAvx2;
+		CheckFrameLines(
+		    fma ? kFrameLineSetFma : kFrameLineSet, fma ? kFramePixelsFma : kFramePixels);
+	}
+	SelectMathKernels(cpuIsa);
+
+	CheckGrid();
+	CheckBroadphase();
+	CheckBvh();
+	CheckRasterizer();
+	CheckHalf();
+	CheckTransformHierarchy();
+
+	if (failureCount > 0) {
+		std::printf("%d check(s) failed\n", failureCount);
+		return 1;
+	}
+	std::printf("all checks passed\n");
+	return 0;
+}
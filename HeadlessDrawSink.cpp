@@ -0,0 +1,122 @@
+﻿#include "HeadlessDrawSink.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+HeadlessDrawSink::HeadlessDrawSink(int width, int height)
+    : width_(width), height_(height), pixels_(size_t(width) * height, kColorBlack) {}
+
+void HeadlessDrawSink::DrawLine(int x1, int y1, int x2, int y2, uint32_t color) {
+	if (recordLines_) {
+		lines_.push_back({x1, y1, x2, y2, color});
+	}
+	if (!pixels_.empty()) {
+		RasterizeLine(x1, y1, x2, y2, color);
+	}
+}
+
+void HeadlessDrawSink::DrawLines(const ScreenLine* lines, size_t count) {
+	if (recordLines_) {
+		lines_.insert(lines_.end(), lines, lines + count);
+	}
+	if (!pixels_.empty()) {
+		for (size_t i = 0; i < count; ++i) {
+			const ScreenLine& line = lines[i];
+			RasterizeLine(line.x1, line.y1, line.x2, line.y2, line.color);
+		}
+	}
+}
+
+void HeadlessDrawSink::DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) {
+	for (size_t i = 1; i < count; ++i) {
+		if (recordLines_) {
+			lines_.push_back({points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color});
+		}
+		if (!pixels_.empty()) {
+			RasterizeLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color);
+		}
+	}
+}
+
+void HeadlessDrawSink::PrintText(int x, int y, const char* text) { texts_.push_back({x, y, text}); }
+
+void HeadlessDrawSink::Clear() {
+	lines_.clear();
+	texts_.clear();
+}
+
+void HeadlessDrawSink::ClearFramebuffer(uint32_t color) {
+	std::fill(pixels_.begin(), pixels_.end(), color);
+}
+
+namespace {
+
+// 線分を [0, maxX] x [0, maxY] に切り詰める (Liang-Barsky)。全部外なら false
+bool ClipLine(int& x1, int& y1, int& x2, int& y2, int maxX, int maxY) {
+	double dx = double(x2) - x1;
+	double dy = double(y2) - y1;
+	double t0 = 0.0;
+	double t1 = 1.0;
+	const double p[4] = {-dx, dx, -dy, dy};
+	const double q[4] = {double(x1), double(maxX) - x1, double(y1), double(maxY) - y1};
+	for (int i = 0; i < 4; ++i) {
+		if (p[i] == 0.0) {
+			if (q[i] < 0.0) {
+				return false;
+			}
+			continue;
+		}
+		double t = q[i] / p[i];
+		if (p[i] < 0.0) {
+			t0 = std::max(t0, t);
+		} else {
+			t1 = std::min(t1, t);
+		}
+		if (t0 > t1) {
+			return false;
+		}
+	}
+	int clippedX1 = int(std::lround(x1 + t0 * dx));
+	int clippedY1 = int(std::lround(y1 + t0 * dy));
+	int clippedX2 = int(std::lround(x1 + t1 * dx));
+	int clippedY2 = int(std::lround(y1 + t1 * dy));
+	x1 = clippedX1;
+	y1 = clippedY1;
+	x2 = clippedX2;
+	y2 = clippedY2;
+	return true;
+}
+
+} // namespace
+
+void HeadlessDrawSink::RasterizeLine(int x1, int y1, int x2, int y2, uint32_t color) {
+	// 画面内に切り詰めてから描く
+	if (!ClipLine(x1, y1, x2, y2, width_ - 1, height_ - 1)) {
+		return;
+	}
+
+	int dx = std::abs(x2 - x1);
+	int dy = -std::abs(y2 - y1);
+	int stepX = x1 < x2 ? 1 : -1;
+	int stepY = y1 < y2 ? 1 : -1;
+	int error = dx + dy;
+	int x = x1;
+	int y = y1;
+	while (true) {
+		if (x >= 0 && x < width_ && y >= 0 && y < height_) {
+			pixels_[size_t(y) * width_ + x] = color;
+		}
+		if (x == x2 && y == y2) {
+			break;
+		}
+		int error2 = error * 2;
+		if (error2 >= dy) {
+			error += dy;
+			x += stepX;
+		}
+		if (error2 <= dx) {
+			error += dx;
+			y += stepY;
+		}
+	}
+}
@@ -0,0 +1,58 @@
+﻿#pragma once
+#include "DrawSink.h"
+#include <string>
+#include <vector>
+
+/*---------------------------------
+ 画面なしで描画を受け取る
+ ・線と文字をバッファに溜める (回帰テスト・計測用)
+ ・フレームバッファを有効にすると線をメモリ上の画像に描く
+------------------------------------*/
+class HeadlessDrawSink : public DrawSink {
+public:
+	// 溜めた文字
+	struct Text {
+		int x;
+		int y;
+		std::string text;
+	};
+
+	HeadlessDrawSink() = default;
+	// width x height のフレームバッファにも線を描く
+	HeadlessDrawSink(int width, int height);
+
+	void DrawLine(int x1, int y1, int x2, int y2, uint32_t color) override;
+	void DrawLines(const ScreenLine* lines, size_t count) override;
+	// 折れ線も 1 本ずつの線として溜める
+	void DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) override;
+	void PrintText(int x, int y, const char* text) override;
+
+	// 溜めた線と文字を捨てる (容量は残す)
+	void Clear();
+	// フレームバッファを color で塗りつぶす
+	void ClearFramebuffer(uint32_t color);
+
+	// 線を溜めるかどうか (フレームバッファだけ使うときは切ると速い)
+	void SetRecordLines(bool recordLines) { recordLines_ = recordLines; }
+
+	const std::vector<ScreenLine>& GetLines() const { return lines_; }
+	const std::vector<Text>& GetTexts() const { return texts_; }
+
+	int GetWidth() const { return width_; }
+	int GetHeight() const { return height_; }
+	// フレームバッファ (width x height、1 画素 RGBA)。無効なら空
+	const std::vector<uint32_t>& GetPixels() const { return pixels_; }
+	uint32_t GetPixel(int x, int y) const { return pixels_[y * width_ + x]; }
+
+private:
+	// Bresenham で線をフレームバッファに描く (画面外は切り詰める)
+	void RasterizeLine(int x1, int y1, int x2, int y2, uint32_t color);
+
+	std::vector<ScreenLine> lines_;
+	std::vector<Text> texts_;
+	bool recordLines_ = true;
+
+	int width_ = 0;
+	int height_ = 0;
+	std::vector<uint32_t> pixels_;
+};
@@ -0,0 +1,135 @@
+﻿#include "JobSystem.h"
+#include "Profiler.h"
+#include <cassert>
+
+JobSystem::JobSystem(uint32_t workerCount) {
+	if (workerCount == 0) {
+		workerCount = std::thread::hardware_concurrency();
+		if (workerCount == 0) {
+			workerCount = 1;
+		}
+	}
+	for (uint32_t i = 0; i < workerCount; ++i) {
+		workers_.push_back(std::make_unique<Worker>());
+	}
+	// ワーカー 0 は ParallelFor を呼んだスレッドが担当する
+	for (uint32_t i = 1; i < workerCount; ++i) {
+		threads_.emplace_back(&JobSystem::WorkerMain, this, i);
+	}
+}
+
+JobSystem::~JobSystem() {
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+		quit_ = true;
+	}
+	wakeCondition_.notify_all();
+	for (std::thread& thread : threads_) {
+		thread.join();
+	}
+}
+
+void JobSystem::ParallelFor(size_t count, size_t grainSize, RangeFunction function) {
+	assert(grainSize > 0);
+	if (count == 0) {
+		return;
+	}
+	size_t jobCount = (count + grainSize - 1) / grainSize;
+
+	// 1 チャンクしかなければその場で処理する
+	if (jobCount == 1 || workers_.size() == 1) {
+		for (size_t begin = 0; begin < count; begin += grainSize) {
+			function(begin, begin + grainSize < count ? begin + grainSize : count, 0);
+		}
+		return;
+	}
+
+	assert(remainingJobs_.load() == 0);
+	remainingJobs_.store(jobCount);
+
+	// 各ワーカーのキューに連続したチャンクをまとめて積む
+	size_t workerCount = workers_.size();
+	for (size_t worker = 0; worker < workerCount; ++worker) {
+		size_t first = jobCount * worker / workerCount;
+		size_t last = jobCount * (worker + 1) / workerCount;
+		Worker& queue = *workers_[worker];
+		std::lock_guard<std::mutex> lock(queue.mutex);
+		// 前回の ParallelFor で空になっているので、先頭から積み直す (容量は残る)
+		assert(queue.head == queue.tail);
+		queue.jobs.clear();
+		for (size_t job = first; job < last; ++job) {
+			size_t begin = job * grainSize;
+			size_t end = begin + grainSize < count ? begin + grainSize : count;
+			queue.jobs.push_back({&function, begin, end});
+		}
+		queue.head = 0;
+		queue.tail = queue.jobs.size();
+	}
+	{
+		std::lock_guard<std::mutex> lock(wakeMutex_);
+		queuedJobs_.fetch_add(jobCount);
+	}
+	wakeCondition_.notify_all();
+
+	// 呼び出し側もワーカー 0 として処理し、全部終わるまで待つ
+	Job job;
+	while (remainingJobs_.load(std::memory_order_acquire) != 0) {
+		if (PopJob(0, job)) {
+			RunJob(job, 0);
+		} else {
+			std::this_thread::yield();
+		}
+	}
+}
+
+bool JobSystem::PopJob(uint32_t workerIndex, Job& job) {
+	if (queuedJobs_.load(std::memory_order_acquire) == 0) {
+		return false;
+	}
+	// 自分のキュー (後ろから取ると直前に積んだ範囲が続くのでキャッシュに載っている)
+	{
+		Worker& own = *workers_[workerIndex];
+		std::lock_guard<std::mutex> lock(own.mutex);
+		if (own.head != own.tail) {
+			job = own.jobs[--own.tail];
+			queuedJobs_.fetch_sub(1);
+			return true;
+		}
+	}
+	// 他のワーカーから盗む (前から取る)
+	size_t workerCount = workers_.size();
+	for (size_t offset = 1; offset < workerCount; ++offset) {
+		Worker& victim = *workers_[(workerIndex + offset) % workerCount];
+		std::lock_guard<std::mutex> lock(victim.mutex);
+		if (victim.head != victim.tail) {
+			job = victim.jobs[victim.head++];
+			queuedJobs_.fetch_sub(1);
+			return true;
+		}
+	}
+	return false;
+}
+
+void JobSystem::RunJob(const Job& job, uint32_t workerIndex) {
+	{
+		// 終わったことを知らせる前に記録を閉じる (フレームの区切りで読まれるため)
+		PROFILE_SCOPE("Job");
+		(*job.function)(job.begin, job.end, workerIndex);
+	}
+	remainingJobs_.fetch_sub(1, std::memory_order_release);
+}
+
+void JobSystem::WorkerMain(uint32_t workerIndex) {
+	Job job;
+	while (true) {
+		if (PopJob(workerIndex, job)) {
+			RunJob(job, workerIndex);
+			continue;
+		}
+		std::unique_lock<std::mutex> lock(wakeMutex_);
+		wakeCondition_.wait(lock, [this] { return quit_ || queuedJobs_.load() != 0; });
+		if (quit_) {
+			return;
+		}
+	}
+}
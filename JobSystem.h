@@ -0,0 +1,94 @@
+﻿#pragma once
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+/*---------------------------------
+ ジョブシステム
+ ・ワーカーごとにジョブの両端キューを持ち、自分のキューは後ろから、
+   空になったら他のワーカーのキューの前から盗んで処理する
+ ・ParallelFor を呼んだスレッドもワーカー 0 として処理に加わる
+ ・ParallelFor は 1 つのスレッド (メインループ) から呼ぶこと。ジョブの中から呼んではいけない
+ ・キューの容量は使い回すので、ジョブ数が前と同じくらいなら ParallelFor はヒープを確保しない
+------------------------------------*/
+class JobSystem {
+public:
+	// [begin, end) を処理する関数 f(begin, end, workerIndex) を指す (workerIndex は 0 から)
+	// std::function と違ってラムダをコピーせず確保もしない。ParallelFor の間だけ参照する
+	class RangeFunction {
+	public:
+		template<typename Function>
+		RangeFunction(const Function& function) : object_(&function), invoke_(&Invoke<Function>) {}
+
+		void operator()(size_t begin, size_t end, uint32_t workerIndex) const {
+			invoke_(object_, begin, end, workerIndex);
+		}
+
+	private:
+		template<typename Function>
+		static void Invoke(const void* object, size_t begin, size_t end, uint32_t workerIndex) {
+			(*static_cast<const Function*>(object))(begin, end, workerIndex);
+		}
+
+		const void* object_;
+		void (*invoke_)(const void* object, size_t begin, size_t end, uint32_t workerIndex);
+	};
+
+	// workerCount は呼び出し側を含めたスレッド数 (0 ならハードウェアのスレッド数)
+	explicit JobSystem(uint32_t workerCount = 0);
+	~JobSystem();
+	JobSystem(const JobSystem&) = delete;
+	JobSystem& operator=(const JobSystem&) = delete;
+
+	uint32_t GetWorkerCount() const { return uint32_t(workers_.size()); }
+
+	// [0, count) を grainSize 個ずつのチャンクに分けて並列に処理し、すべて終わるまで待つ
+	// チャンク番号は begin / grainSize で求められる
+	void ParallelFor(size_t count, size_t grainSize, RangeFunction function);
+
+private:
+	struct Job {
+		const RangeFunction* function;
+		size_t begin;
+		size_t end;
+	};
+
+	// 隣のワーカーとキャッシュラインを共有しないようにする
+	// ParallelFor ごとに空の状態から積むので、両端キューは配列と先頭・末尾の位置で足りる
+	// (持ち主は末尾から、盗む側は先頭から取る)
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4324) // alignas で後ろを詰めたという警告 (詰めるのが目的)
+#endif
+	struct alignas(64) Worker {
+		std::mutex mutex;
+		std::vector<Job> jobs;
+		size_t head = 0;
+		size_t tail = 0;
+	};
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+	// 自分のキューの後ろから取り出し、なければ他のワーカーから盗む
+	bool PopJob(uint32_t workerIndex, Job& job);
+	void RunJob(const Job& job, uint32_t workerIndex);
+	void WorkerMain(uint32_t workerIndex);
+
+	std::vector<std::unique_ptr<Worker>> workers_;
+	std::vector<std::thread> threads_;
+
+	// 待機中のワーカーを起こす
+	std::mutex wakeMutex_;
+	std::condition_variable wakeCondition_;
+	// キューに積まれてまだ取り出されていないジョブ数
+	std::atomic<size_t> queuedJobs_ = 0;
+	// 今回の ParallelFor で終わっていないジョブ数
+	std::atomic<size_t> remainingJobs_ = 0;
+	bool quit_ = false;
+};
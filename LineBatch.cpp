@@ -0,0 +1,91 @@
+﻿#include "LineBatch.h"
+#include "Profiler.h"
+
+LineBatch::Bucket& LineBatch::GetBucket(uint32_t color) {
+	if (lastBucket_ < bucketCount_ && buckets_[lastBucket_].color == color) {
+		return buckets_[lastBucket_];
+	}
+	// 色は数種類しかないので順に探す
+	for (size_t i = 0; i < bucketCount_; ++i) {
+		if (buckets_[i].color == color) {
+			lastBucket_ = i;
+			return buckets_[i];
+		}
+	}
+	if (bucketCount_ == buckets_.size()) {
+		buckets_.emplace_back();
+	}
+	lastBucket_ = bucketCount_++;
+	Bucket& bucket = buckets_[lastBucket_];
+	bucket.color = color;
+	return bucket;
+}
+
+void LineBatch::DrawLine(int x1, int y1, int x2, int y2, uint32_t color) {
+	GetBucket(color).lines.push_back({x1, y1, x2, y2, color});
+}
+
+void LineBatch::DrawLines(const ScreenLine* lines, size_t count) {
+	// 同じ色が続く区間ごとにまとめて足す
+	size_t begin = 0;
+	while (begin < count) {
+		uint32_t color = lines[begin].color;
+		size_t end = begin + 1;
+		while (end < count && lines[end].color == color) {
+			++end;
+		}
+		std::vector<ScreenLine>& bucketLines = GetBucket(color).lines;
+		bucketLines.insert(bucketLines.end(), lines + begin, lines + end);
+		begin = end;
+	}
+}
+
+void LineBatch::DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) {
+	if (count < 2) {
+		return;
+	}
+	Bucket& bucket = GetBucket(color);
+	bucket.stripPoints.insert(bucket.stripPoints.end(), points, points + count);
+	bucket.stripEnds.push_back(uint32_t(bucket.stripPoints.size()));
+}
+
+void LineBatch::PrintText(int x, int y, const char* text) { texts_.push_back({x, y, text}); }
+
+void LineBatch::Flush(DrawSink& sink) {
+	PROFILE_SCOPE("LineBatch::Flush");
+	for (size_t i = 0; i < bucketCount_; ++i) {
+		const Bucket& bucket = buckets_[i];
+		if (!bucket.lines.empty()) {
+			sink.DrawLines(bucket.lines.data(), bucket.lines.size());
+		}
+		uint32_t begin = 0;
+		for (uint32_t end : bucket.stripEnds) {
+			sink.DrawLineStrip(&bucket.stripPoints[begin], end - begin, bucket.color);
+			begin = end;
+		}
+	}
+	for (const Text& text : texts_) {
+		sink.PrintText(text.x, text.y, text.text.c_str());
+	}
+	Clear();
+}
+
+void LineBatch::Clear() {
+	for (size_t i = 0; i < bucketCount_; ++i) {
+		buckets_[i].lines.clear();
+		buckets_[i].stripPoints.clear();
+		buckets_[i].stripEnds.clear();
+	}
+	bucketCount_ = 0;
+	lastBucket_ = 0;
+	texts_.clear();
+}
+
+size_t LineBatch::GetLineCount() const {
+	size_t count = 0;
+	for (size_t i = 0; i < bucketCount_; ++i) {
+		const Bucket& bucket = buckets_[i];
+		count += bucket.lines.size() + bucket.stripPoints.size() - bucket.stripEnds.size();
+	}
+	return count;
+}
@@ -0,0 +1,61 @@
+﻿#pragma once
+#include "DrawSink.h"
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*---------------------------------
+ 線のバッチ
+ ・描画先として渡すと、線分と折れ線を色ごとの箱に溜める (描画関数はそのまま使える)
+ ・Flush で色ごとに DrawLines 1 回と折れ線の数だけ DrawLineStrip を呼んで本当の描画先へ出す
+ ・折れ線は頂点を共有して持つので、線分で持つより小さい (球の緯線・経線など)
+ ・色の箱は最初に使った順に出す。違う色の線どうしの重なり順は積んだ順と変わることがある
+ ・Flush しても容量は残すので、線の数が落ち着けば以降のフレームはヒープを確保しない
+ ・まとめる分 1 回コピーが増える。呼び出しごとに色などの状態を切り替える描画先向けで、
+   1 本ずつしか引けない Novice には使わない (アプリは FrameLineBuffer と SubmitLines で出す)
+------------------------------------*/
+class LineBatch : public DrawSink {
+public:
+	void DrawLine(int x1, int y1, int x2, int y2, uint32_t color) override;
+	void DrawLines(const ScreenLine* lines, size_t count) override;
+	void DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) override;
+	// 文字は線の後に積んだ順で出す
+	void PrintText(int x, int y, const char* text) override;
+
+	// 溜めた線と文字を sink へ出して空にする
+	void Flush(DrawSink& sink);
+	// 出さずに空にする
+	void Clear();
+
+	// 溜めた線の数 (折れ線は 1 本ずつ数える)
+	size_t GetLineCount() const;
+	// 使っている色の数
+	size_t GetColorCount() const { return bucketCount_; }
+
+private:
+	// 1 色分
+	struct Bucket {
+		uint32_t color;
+		std::vector<ScreenLine> lines;
+		std::vector<ScreenPoint> stripPoints;
+		// 折れ線ごとの stripPoints の終わり
+		std::vector<uint32_t> stripEnds;
+	};
+
+	struct Text {
+		int x;
+		int y;
+		std::string text;
+	};
+
+	// color の箱 (なければ足す)
+	Bucket& GetBucket(uint32_t color);
+
+	// [0, bucketCount_) が使っている箱。後ろの箱は容量を残したまま空にしてある
+	std::vector<Bucket> buckets_;
+	size_t bucketCount_ = 0;
+	// 最後に使った箱 (同じ色が続くときは探さない)
+	size_t lastBucket_ = 0;
+	std::vector<Text> texts_;
+};
@@ -0,0 +1,794 @@
+﻿#include "MathSimd.h"
+#include <cassert>
+#include <cmath>
+#include <cstdint>
+#include <immintrin.h>
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <cpuid.h>
+#endif
+
+/*---------------------------------
+ CPU 判定
+------------------------------------*/
+
+namespace {
+
+void CpuId(int leaf, int subLeaf, int regs[4]) {
+#if defined(_MSC_VER)
+	__cpuidex(regs, leaf, subLeaf);
+#else
+	unsigned int a = 0, b = 0, c = 0, d = 0;
+	__cpuid_count(leaf, subLeaf, a, b, c, d);
+	regs[0] = (int)a;
+	regs[1] = (int)b;
+	regs[2] = (int)c;
+	regs[3] = (int)d;
+#endif
+}
+
+// OS が保存する拡張レジスタ (XCR0)
+uint64_t ReadXcr0() {
+#if defined(_MSC_VER)
+	return _xgetbv(0);
+#else
+	uint32_t eax = 0, edx = 0;
+	__asm__ volatile("xgetbv" : "=a"(eax), "=d"(edx) : "c"(0));
+	return ((uint64_t)edx << 32) | eax;
+#endif
+}
+
+MathIsa DetectCpuMathIsa() {
+	int regs[4];
+	CpuId(0, 0, regs);
+	int maxLeaf = regs[0];
+	if (maxLeaf < 7) {
+		return MathIsa::kSse;
+	}
+
+	CpuId(1, 0, regs);
+	bool fma = (regs[2] & (1 << 12)) != 0;
+	bool osxsave = (regs[2] & (1 << 27)) != 0;
+	bool avx = (regs[2] & (1 << 28)) != 0;
+	bool f16c = (regs[2] & (1 << 29)) != 0;
+	if (!osxsave || !avx || !fma || !f16c) {
+		return MathIsa::kSse;
+	}
+
+	// YMM (bit1,2) を OS が保存しているか
+	uint64_t xcr0 = ReadXcr0();
+	if ((xcr0 & 0x6) != 0x6) {
+		return MathIsa::kSse;
+	}
+
+	CpuId(7, 0, regs);
+	bool avx2 = (regs[1] & (1 << 5)) != 0;
+	bool avx512f = (regs[1] & (1 << 16)) != 0;
+	if (!avx2) {
+		return MathIsa::kSse;
+	}
+	// opmask, ZMM 上位 (bit5,6,7) も保存しているか
+	if (avx512f && (xcr0 & 0xE6) == 0xE6) {
+		return MathIsa::kAvx512;
+	}
+	return MathIsa::kAvx2;
+}
+
+/*---------------------------------
+ SSE
+------------------------------------*/
+
+// 積は Mathfunction.h の MultiplySse (Multiply から展開して使う)
+
+// 配列の積 (ループの中で MultiplySse を展開させ、1 組ごとの関数呼び出しをなくす)
+void MultiplyArraySse(
+    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = MultiplySse(m1[i], m2[i]);
+	}
+}
+
+Vector3 TransformSse(const Vector3& vector, const Matrix4x4& matrix) {
+	__m128 r = _mm_mul_ps(_mm_set1_ps(vector.x), _mm_loadu_ps(matrix.m[0]));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(vector.y), _mm_loadu_ps(matrix.m[1])));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_set1_ps(vector.z), _mm_loadu_ps(matrix.m[2])));
+	r = _mm_add_ps(r, _mm_loadu_ps(matrix.m[3]));
+	__m128 w = _mm_shuffle_ps(r, r, _MM_SHUFFLE(3, 3, 3, 3));
+	assert(_mm_cvtss_f32(w) != 0.0f);
+	r = _mm_div_ps(r, w);
+
+	alignas(16) float out[4];
+	_mm_store_ps(out, r);
+	return {out[0], out[1], out[2]};
+}
+
+// AoS の Vector3 4 個 (12 float) を x, y, z それぞれ 4 要素に並べ替える
+// a = (x0 y0 z0 x1), b = (y1 z1 x2 y2), c = (z2 x3 y3 z3)
+inline void Deinterleave3(__m128 a, __m128 b, __m128 c, __m128& x, __m128& y, __m128& z) {
+	x = _mm_shuffle_ps(a, _mm_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm_shuffle_ps(
+	    _mm_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)), _mm_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)),
+	    _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm_shuffle_ps(
+	    _mm_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)), _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)),
+	    _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// Deinterleave3 の逆
+inline void Interleave3(__m128 x, __m128 y, __m128 z, __m128& a, __m128& b, __m128& c) {
+	a = _mm_shuffle_ps(
+	    _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)), _mm_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)),
+	    _MM_SHUFFLE(2, 0, 2, 0));
+	b = _mm_shuffle_ps(
+	    _mm_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)), _mm_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)),
+	    _MM_SHUFFLE(2, 0, 2, 0));
+	c = _mm_shuffle_ps(
+	    _mm_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)), _mm_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)),
+	    _MM_SHUFFLE(2, 0, 2, 0));
+}
+
+// 4 点ずつ変換する
+void TransformArraySse(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix) {
+	__m128 m[4][4];
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			m[row][column] = _mm_set1_ps(matrix.m[row][column]);
+		}
+	}
+
+	size_t i = 0;
+	for (; i + 4 <= count; i += 4) {
+		const float* src = &vectors[i].x;
+		__m128 x, y, z;
+		Deinterleave3(_mm_loadu_ps(src), _mm_loadu_ps(src + 4), _mm_loadu_ps(src + 8), x, y, z);
+
+		__m128 out[4];
+		for (int column = 0; column < 4; ++column) {
+			__m128 r = _mm_add_ps(_mm_mul_ps(x, m[0][column]), _mm_mul_ps(y, m[1][column]));
+			r = _mm_add_ps(r, _mm_mul_ps(z, m[2][column]));
+			out[column] = _mm_add_ps(r, m[3][column]);
+		}
+		__m128 invW = _mm_div_ps(_mm_set1_ps(1.0f), out[3]);
+
+		__m128 a, b, c;
+		Interleave3(
+		    _mm_mul_ps(out[0], invW), _mm_mul_ps(out[1], invW), _mm_mul_ps(out[2], invW), a, b, c);
+		float* dst = &results[i].x;
+		_mm_storeu_ps(dst, a);
+		_mm_storeu_ps(dst + 4, b);
+		_mm_storeu_ps(dst + 8, c);
+	}
+	TransformArrayScalar(vectors + i, results + i, count - i, matrix);
+}
+
+// 2x2 行列 (xyzw = 00,01,10,11) の積 A*B
+inline __m128 Mat2Mul(__m128 a, __m128 b) {
+	return _mm_add_ps(
+	    _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 3, 0))),
+	    _mm_mul_ps(
+	        _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+	        _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// 2x2 行列の余因子行列との積 adj(A)*B
+inline __m128 Mat2AdjMul(__m128 a, __m128 b) {
+	return _mm_sub_ps(
+	    _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 3, 3)), b),
+	    _mm_mul_ps(
+	        _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 1, 1)),
+	        _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 0, 3, 2))));
+}
+
+// 2x2 行列と余因子行列の積 A*adj(B)
+inline __m128 Mat2MulAdj(__m128 a, __m128 b) {
+	return _mm_sub_ps(
+	    _mm_mul_ps(a, _mm_shuffle_ps(b, b, _MM_SHUFFLE(0, 3, 0, 3))),
+	    _mm_mul_ps(
+	        _mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 3, 0, 1)),
+	        _mm_shuffle_ps(b, b, _MM_SHUFFLE(1, 2, 1, 2))));
+}
+
+// GetDeterminantScale の SSE 版
+// 上 2 行の積 top[i] * bottom[j] を 3 通りに並べ、下 2 行の残りの列の 2x2 永久式と掛けて足す
+inline float GetDeterminantScaleSse(__m128 row0, __m128 row1, __m128 row2, __m128 row3) {
+	const __m128 signMask = _mm_set1_ps(-0.0f);
+	row0 = _mm_andnot_ps(signMask, row0);
+	row1 = _mm_andnot_ps(signMask, row1);
+	row2 = _mm_andnot_ps(signMask, row2);
+	row3 = _mm_andnot_ps(signMask, row3);
+	// 列の組 (01 10 23 32) (02 13 20 31) (03 12 21 30)
+	__m128 top1 = _mm_mul_ps(row0, _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m128 top2 = _mm_mul_ps(row0, _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 top3 = _mm_mul_ps(row0, _mm_shuffle_ps(row1, row1, _MM_SHUFFLE(0, 1, 2, 3)));
+	__m128 bottom1 = _mm_mul_ps(row2, _mm_shuffle_ps(row3, row3, _MM_SHUFFLE(2, 3, 0, 1)));
+	__m128 bottom2 = _mm_mul_ps(row2, _mm_shuffle_ps(row3, row3, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 bottom3 = _mm_mul_ps(row2, _mm_shuffle_ps(row3, row3, _MM_SHUFFLE(0, 1, 2, 3)));
+	// 残りの列の永久式 (23 23 01 01) (13 02 13 02) (12 03 03 12)
+	__m128 rest1 = _mm_add_ps(
+	    _mm_shuffle_ps(bottom1, bottom1, _MM_SHUFFLE(1, 0, 3, 2)),
+	    _mm_shuffle_ps(bottom1, bottom1, _MM_SHUFFLE(0, 1, 2, 3)));
+	__m128 rest2 = _mm_add_ps(
+	    _mm_shuffle_ps(bottom2, bottom2, _MM_SHUFFLE(2, 3, 0, 1)),
+	    _mm_shuffle_ps(bottom2, bottom2, _MM_SHUFFLE(0, 1, 2, 3)));
+	__m128 rest3 = _mm_add_ps(
+	    _mm_shuffle_ps(bottom3, bottom3, _MM_SHUFFLE(2, 3, 0, 1)),
+	    _mm_shuffle_ps(bottom3, bottom3, _MM_SHUFFLE(1, 0, 3, 2)));
+	__m128 sum = _mm_mul_ps(top1, rest1);
+	sum = _mm_add_ps(sum, _mm_mul_ps(top2, rest2));
+	sum = _mm_add_ps(sum, _mm_mul_ps(top3, rest3));
+	sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(2, 3, 0, 1)));
+	sum = _mm_add_ps(sum, _mm_shuffle_ps(sum, sum, _MM_SHUFFLE(1, 0, 3, 2)));
+	return _mm_cvtss_f32(sum);
+}
+
+// 2x2 ブロックに分けて逆行列を求める
+// M = | A B |  iM = 1/|M| * | X Y |
+//     | C D |               | Z W |
+// 特異なら result を変えずに false
+bool TryInverseSse(const Matrix4x4& m, Matrix4x4& result) {
+	__m128 row0 = _mm_loadu_ps(m.m[0]);
+	__m128 row1 = _mm_loadu_ps(m.m[1]);
+	__m128 row2 = _mm_loadu_ps(m.m[2]);
+	__m128 row3 = _mm_loadu_ps(m.m[3]);
+
+	__m128 a = _mm_movelh_ps(row0, row1);
+	__m128 b = _mm_movehl_ps(row1, row0);
+	__m128 c = _mm_movelh_ps(row2, row3);
+	__m128 d = _mm_movehl_ps(row3, row2);
+
+	// 各ブロックの行列式 (|A| |B| |C| |D|)
+	__m128 detSub = _mm_sub_ps(
+	    _mm_mul_ps(
+	        _mm_shuffle_ps(row0, row2, _MM_SHUFFLE(2, 0, 2, 0)),
+	        _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(3, 1, 3, 1))),
+	    _mm_mul_ps(
+	        _mm_shuffle_ps(row0, row2, _MM_SHUFFLE(3, 1, 3, 1)),
+	        _mm_shuffle_ps(row1, row3, _MM_SHUFFLE(2, 0, 2, 0))));
+	__m128 detA = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(0, 0, 0, 0));
+	__m128 detB = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(1, 1, 1, 1));
+	__m128 detC = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(2, 2, 2, 2));
+	__m128 detD = _mm_shuffle_ps(detSub, detSub, _MM_SHUFFLE(3, 3, 3, 3));
+
+	__m128 dc = Mat2AdjMul(d, c);
+	__m128 ab = Mat2AdjMul(a, b);
+	// adj(X) = |D|A - B(adj(D)C)
+	__m128 x = _mm_sub_ps(_mm_mul_ps(detD, a), Mat2Mul(b, dc));
+	// adj(W) = |A|D - C(adj(A)B)
+	__m128 w = _mm_sub_ps(_mm_mul_ps(detA, d), Mat2Mul(c, ab));
+	// adj(Y) = |B|C - D adj(adj(A)B)
+	__m128 y = _mm_sub_ps(_mm_mul_ps(detB, c), Mat2MulAdj(d, ab));
+	// adj(Z) = |C|B - A adj(adj(D)C)
+	__m128 z = _mm_sub_ps(_mm_mul_ps(detC, b), Mat2MulAdj(a, dc));
+
+	// |M| = |A||D| + |B||C| - tr((adj(A)B)(adj(D)C))
+	__m128 detM = _mm_add_ps(_mm_mul_ps(detA, detD), _mm_mul_ps(detB, detC));
+	__m128 tr = _mm_mul_ps(ab, _mm_shuffle_ps(dc, dc, _MM_SHUFFLE(3, 1, 2, 0)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(2, 3, 0, 1)));
+	tr = _mm_add_ps(tr, _mm_shuffle_ps(tr, tr, _MM_SHUFFLE(1, 0, 3, 2)));
+	detM = _mm_sub_ps(detM, tr);
+	float determinant = _mm_cvtss_f32(detM);
+	if (!IsInvertibleDeterminant(determinant, GetDeterminantScaleSse(row0, row1, row2, row3))) {
+		return false;
+	}
+
+	// (1/|M|, -1/|M|, -1/|M|, 1/|M|)
+	__m128 rDetM = _mm_div_ps(_mm_setr_ps(1.0f, -1.0f, -1.0f, 1.0f), detM);
+	x = _mm_mul_ps(x, rDetM);
+	y = _mm_mul_ps(y, rDetM);
+	z = _mm_mul_ps(z, rDetM);
+	w = _mm_mul_ps(w, rDetM);
+
+	// 余因子行列の並べ替えと格納
+	_mm_storeu_ps(result.m[0], _mm_shuffle_ps(x, y, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(result.m[1], _mm_shuffle_ps(x, y, _MM_SHUFFLE(0, 2, 0, 2)));
+	_mm_storeu_ps(result.m[2], _mm_shuffle_ps(z, w, _MM_SHUFFLE(1, 3, 1, 3)));
+	_mm_storeu_ps(result.m[3], _mm_shuffle_ps(z, w, _MM_SHUFFLE(0, 2, 0, 2)));
+	return true;
+}
+
+Matrix4x4 InverseSse(const Matrix4x4& m) {
+	Matrix4x4 result;
+	[[maybe_unused]] bool invertible = TryInverseSse(m, result);
+	assert(invertible);
+	return result;
+}
+
+// 3 要素のクロス積 (w は 0 になる)
+inline __m128 Cross3(__m128 a, __m128 b) {
+	__m128 aYzx = _mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 bYzx = _mm_shuffle_ps(b, b, _MM_SHUFFLE(3, 0, 2, 1));
+	__m128 c = _mm_sub_ps(_mm_mul_ps(a, bYzx), _mm_mul_ps(aYzx, b));
+	return _mm_shuffle_ps(c, c, _MM_SHUFFLE(3, 0, 2, 1));
+}
+
+// 3x3 部分の逆行列 (row0 から row2。4 列目は 0) と元の平行移動から逆行列を組み立てて格納する
+inline void StoreAffineInverse(
+    __m128 row0, __m128 row1, __m128 row2, __m128 translate, Matrix4x4& result) {
+	// -t * (3x3 の逆行列)
+	__m128 t = _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+	t = _mm_add_ps(
+	    t, _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+	t = _mm_add_ps(
+	    t, _mm_mul_ps(_mm_shuffle_ps(translate, translate, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+	t = _mm_sub_ps(_mm_setr_ps(0.0f, 0.0f, 0.0f, 1.0f), t);
+
+	_mm_storeu_ps(result.m[0], row0);
+	_mm_storeu_ps(result.m[1], row1);
+	_mm_storeu_ps(result.m[2], row2);
+	_mm_storeu_ps(result.m[3], t);
+}
+
+// 3x3 部分を余因子 (クロス積) で求める
+Matrix4x4 InverseAffineSse(const Matrix4x4& m) {
+	// 4 列目は無視して 0 として扱う
+	const __m128 mask = _mm_castsi128_ps(_mm_setr_epi32(-1, -1, -1, 0));
+	__m128 row0 = _mm_and_ps(_mm_loadu_ps(m.m[0]), mask);
+	__m128 row1 = _mm_and_ps(_mm_loadu_ps(m.m[1]), mask);
+	__m128 row2 = _mm_and_ps(_mm_loadu_ps(m.m[2]), mask);
+
+	__m128 column0 = Cross3(row1, row2);
+	__m128 column1 = Cross3(row2, row0);
+	__m128 column2 = Cross3(row0, row1);
+
+	__m128 det = _mm_mul_ps(row0, column0);
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(2, 3, 0, 1)));
+	det = _mm_add_ps(det, _mm_shuffle_ps(det, det, _MM_SHUFFLE(1, 0, 3, 2)));
+	assert(_mm_cvtss_f32(det) != 0.0f);
+	__m128 rDet = _mm_div_ps(_mm_set1_ps(1.0f), det);
+
+	// 逆行列の各行 = 各クロス積の同じ成分
+	__m128 zero = _mm_setzero_ps();
+	_MM_TRANSPOSE4_PS(column0, column1, column2, zero);
+	Matrix4x4 result;
+	StoreAffineInverse(
+	    _mm_mul_ps(column0, rDet), _mm_mul_ps(column1, rDet), _mm_mul_ps(column2, rDet),
+	    _mm_loadu_ps(m.m[3]), result);
+	return result;
+}
+
+// 3x3 部分は転置
+Matrix4x4 InverseRigidSse(const Matrix4x4& m) {
+	__m128 row0 = _mm_loadu_ps(m.m[0]);
+	__m128 row1 = _mm_loadu_ps(m.m[1]);
+	__m128 row2 = _mm_loadu_ps(m.m[2]);
+	__m128 zero = _mm_setzero_ps();
+	// 4 行目を 0 にして転置すれば 4 列目も 0 になる
+	_MM_TRANSPOSE4_PS(row0, row1, row2, zero);
+	Matrix4x4 result;
+	StoreAffineInverse(row0, row1, row2, _mm_loadu_ps(m.m[3]), result);
+	return result;
+}
+
+/*---------------------------------
+ AVX2
+------------------------------------*/
+
+// 掛け算と足し算を FMA にまとめさせない (GCC は FMA の使える関数では既定でまとめる)
+// 行列の積を MultiplySse とビットまで同じにするため
+#if defined(_MSC_VER)
+#define MATH_NO_FP_CONTRACT
+#else
+#define MATH_NO_FP_CONTRACT __attribute__((optimize("fp-contract=off")))
+#endif
+
+// 2 行ずつ 256bit で計算する (MultiplySse と結果が同じになるよう FMA は使わない)
+MATH_TARGET_AVX2 MATH_NO_FP_CONTRACT Matrix4x4 MultiplyAvx2(const Matrix4x4& m1, const Matrix4x4& m2) {
+	Matrix4x4 result;
+	__m256 row0 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[0]));
+	__m256 row1 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[1]));
+	__m256 row2 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[2]));
+	__m256 row3 = _mm256_broadcast_ps(reinterpret_cast<const __m128*>(m2.m[3]));
+	for (int i = 0; i < 4; i += 2) {
+		__m256 a = _mm256_loadu_ps(m1.m[i]);
+		__m256 r = _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+		r = _mm256_add_ps(r, _mm256_mul_ps(_mm256_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+		_mm256_storeu_ps(result.m[i], r);
+	}
+	return result;
+}
+
+MATH_TARGET_AVX2 MATH_NO_FP_CONTRACT void MultiplyArrayAvx2(
+    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = MultiplyAvx2(m1[i], m2[i]);
+	}
+}
+
+MATH_TARGET_AVX2 Vector3 TransformAvx2(const Vector3& vector, const Matrix4x4& matrix) {
+	__m128 r = _mm_fmadd_ps(
+	    _mm_set1_ps(vector.x), _mm_loadu_ps(matrix.m[0]), _mm_loadu_ps(matrix.m[3]));
+	r = _mm_fmadd_ps(_mm_set1_ps(vector.y), _mm_loadu_ps(matrix.m[1]), r);
+	r = _mm_fmadd_ps(_mm_set1_ps(vector.z), _mm_loadu_ps(matrix.m[2]), r);
+	__m128 w = _mm_permute_ps(r, _MM_SHUFFLE(3, 3, 3, 3));
+	assert(_mm_cvtss_f32(w) != 0.0f);
+	r = _mm_div_ps(r, w);
+
+	alignas(16) float out[4];
+	_mm_store_ps(out, r);
+	return {out[0], out[1], out[2]};
+}
+
+// 8 点ずつ変換する (128bit 単位の並べ替えは SSE 版と同じ)
+MATH_TARGET_AVX2 void TransformArrayAvx2(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix) {
+	__m256 m[4][4];
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			m[row][column] = _mm256_set1_ps(matrix.m[row][column]);
+		}
+	}
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		const float* src = &vectors[i].x;
+		__m256 m0 = _mm256_loadu_ps(src);
+		__m256 m1 = _mm256_loadu_ps(src + 8);
+		__m256 m2 = _mm256_loadu_ps(src + 16);
+		// 下位 128bit に 0〜3 番、上位 128bit に 4〜7 番の点が来るように組み替える
+		__m256 a = _mm256_permute2f128_ps(m0, m1, 0x30);
+		__m256 b = _mm256_permute2f128_ps(m0, m2, 0x21);
+		__m256 c = _mm256_permute2f128_ps(m1, m2, 0x30);
+
+		__m256 x = _mm256_shuffle_ps(
+		    a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+		__m256 y = _mm256_shuffle_ps(
+		    _mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+		    _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		__m256 z = _mm256_shuffle_ps(
+		    _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+		    _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+		__m256 out[4];
+		for (int column = 0; column < 4; ++column) {
+			__m256 r = _mm256_fmadd_ps(x, m[0][column], m[3][column]);
+			r = _mm256_fmadd_ps(y, m[1][column], r);
+			out[column] = _mm256_fmadd_ps(z, m[2][column], r);
+		}
+		__m256 invW = _mm256_div_ps(_mm256_set1_ps(1.0f), out[3]);
+		x = _mm256_mul_ps(out[0], invW);
+		y = _mm256_mul_ps(out[1], invW);
+		z = _mm256_mul_ps(out[2], invW);
+
+		a = _mm256_shuffle_ps(
+		    _mm256_shuffle_ps(x, y, _MM_SHUFFLE(0, 0, 0, 0)),
+		    _mm256_shuffle_ps(z, x, _MM_SHUFFLE(1, 1, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+		b = _mm256_shuffle_ps(
+		    _mm256_shuffle_ps(y, z, _MM_SHUFFLE(1, 1, 1, 1)),
+		    _mm256_shuffle_ps(x, y, _MM_SHUFFLE(2, 2, 2, 2)), _MM_SHUFFLE(2, 0, 2, 0));
+		c = _mm256_shuffle_ps(
+		    _mm256_shuffle_ps(z, x, _MM_SHUFFLE(3, 3, 2, 2)),
+		    _mm256_shuffle_ps(y, z, _MM_SHUFFLE(3, 3, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+		float* dst = &results[i].x;
+		_mm256_storeu_ps(dst, _mm256_permute2f128_ps(a, b, 0x20));
+		_mm256_storeu_ps(dst + 8, _mm256_permute2f128_ps(c, a, 0x30));
+		_mm256_storeu_ps(dst + 16, _mm256_permute2f128_ps(b, c, 0x31));
+	}
+	TransformArraySse(vectors + i, results + i, count - i, matrix);
+}
+
+/*---------------------------------
+ AVX-512
+------------------------------------*/
+
+// 16 要素を 1 レジスタにまとめて 4 行同時に計算する (FMA を使わないのは AVX2 版と同じ)
+MATH_TARGET_AVX512 MATH_NO_FP_CONTRACT Matrix4x4 MultiplyAvx512(const Matrix4x4& m1, const Matrix4x4& m2) {
+	Matrix4x4 result;
+	__m512 a = _mm512_loadu_ps(&m1.m[0][0]);
+	__m512 row0 = _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[0]));
+	__m512 row1 = _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[1]));
+	__m512 row2 = _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[2]));
+	__m512 row3 = _mm512_broadcast_f32x4(_mm_loadu_ps(m2.m[3]));
+	__m512 r = _mm512_mul_ps(_mm512_permute_ps(a, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+	r = _mm512_add_ps(r, _mm512_mul_ps(_mm512_permute_ps(a, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+	r = _mm512_add_ps(r, _mm512_mul_ps(_mm512_permute_ps(a, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+	r = _mm512_add_ps(r, _mm512_mul_ps(_mm512_permute_ps(a, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+	_mm512_storeu_ps(&result.m[0][0], r);
+	return result;
+}
+
+MATH_TARGET_AVX512 MATH_NO_FP_CONTRACT void MultiplyArrayAvx512(
+    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = MultiplyAvx512(m1[i], m2[i]);
+	}
+}
+
+// AoS の 16 点 (48 float、3 レジスタ) と x, y, z の 16 要素ずつを並べ替える添字
+// 2 つのレジスタから選ぶ vpermt2ps を 2 回重ねる (1 回目で前の 2 つ、2 回目で残りの 1 つから)
+struct Interleave3Indices {
+	int32_t load[3][2][16];
+	int32_t store[3][2][16];
+};
+
+constexpr Interleave3Indices MakeInterleave3Indices() {
+	Interleave3Indices indices{};
+	for (int component = 0; component < 3; ++component) {
+		for (int lane = 0; lane < 16; ++lane) {
+			int flat = lane * 3 + component;
+			indices.load[component][0][lane] = flat < 32 ? flat : 0;
+			indices.load[component][1][lane] = flat < 32 ? lane : 16 + flat - 32;
+		}
+	}
+	for (int block = 0; block < 3; ++block) {
+		for (int lane = 0; lane < 16; ++lane) {
+			int flat = block * 16 + lane;
+			int point = flat / 3;
+			int component = flat % 3;
+			// 1 回目は x, y、2 回目は z を入れる
+			indices.store[block][0][lane] =
+			    component == 0 ? point : (component == 1 ? 16 + point : 0);
+			indices.store[block][1][lane] = component == 2 ? 16 + point : lane;
+		}
+	}
+	return indices;
+}
+
+constexpr Interleave3Indices kInterleave3Indices = MakeInterleave3Indices();
+
+// 16 点ずつ変換する (計算の順番は AVX2 版と同じなので結果も同じ)
+MATH_TARGET_AVX512 void TransformArrayAvx512(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix) {
+	__m512 m[4][4];
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			m[row][column] = _mm512_set1_ps(matrix.m[row][column]);
+		}
+	}
+	__m512i load[3][2];
+	__m512i store[3][2];
+	for (int i = 0; i < 3; ++i) {
+		for (int stage = 0; stage < 2; ++stage) {
+			load[i][stage] = _mm512_loadu_si512(kInterleave3Indices.load[i][stage]);
+			store[i][stage] = _mm512_loadu_si512(kInterleave3Indices.store[i][stage]);
+		}
+	}
+
+	size_t i = 0;
+	for (; i + 16 <= count; i += 16) {
+		const float* src = &vectors[i].x;
+		__m512 m0 = _mm512_loadu_ps(src);
+		__m512 m1 = _mm512_loadu_ps(src + 16);
+		__m512 m2 = _mm512_loadu_ps(src + 32);
+		__m512 xyz[3];
+		for (int component = 0; component < 3; ++component) {
+			__m512 front = _mm512_permutex2var_ps(m0, load[component][0], m1);
+			xyz[component] = _mm512_permutex2var_ps(front, load[component][1], m2);
+		}
+
+		__m512 out[4];
+		for (int column = 0; column < 4; ++column) {
+			__m512 r = _mm512_fmadd_ps(xyz[0], m[0][column], m[3][column]);
+			r = _mm512_fmadd_ps(xyz[1], m[1][column], r);
+			out[column] = _mm512_fmadd_ps(xyz[2], m[2][column], r);
+		}
+		__m512 invW = _mm512_div_ps(_mm512_set1_ps(1.0f), out[3]);
+		__m512 x = _mm512_mul_ps(out[0], invW);
+		__m512 y = _mm512_mul_ps(out[1], invW);
+		__m512 z = _mm512_mul_ps(out[2], invW);
+
+		float* dst = &results[i].x;
+		for (int block = 0; block < 3; ++block) {
+			__m512 xy = _mm512_permutex2var_ps(x, store[block][0], y);
+			_mm512_storeu_ps(dst + block * 16, _mm512_permutex2var_ps(xy, store[block][1], z));
+		}
+	}
+	TransformArrayAvx2(vectors + i, results + i, count - i, matrix);
+}
+
+/*---------------------------------
+ カーネル選択
+------------------------------------*/
+
+const MathKernels kScalarKernels = {
+    MathIsa::kScalar,    MultiplyScalar,     MultiplyArrayScalar, InverseScalar,
+    TryInverseScalar,    InverseAffineScalar, InverseRigidScalar, TransformScalar,
+    TransformArrayScalar};
+const MathKernels kSseKernels = {
+    MathIsa::kSse,    MultiplySse,     MultiplyArraySse, InverseSse,   TryInverseSse,
+    InverseAffineSse, InverseRigidSse, TransformSse,     TransformArraySse};
+const MathKernels kAvx2Kernels = {
+    MathIsa::kAvx2,   MultiplyAvx2,    MultiplyArrayAvx2, InverseSse,   TryInverseSse,
+    InverseAffineSse, InverseRigidSse, TransformAvx2,     TransformArrayAvx2};
+// 1 点の変換と逆行列は 128bit で収まるので AVX2 版と SSE 版を使う
+const MathKernels kAvx512Kernels = {
+    MathIsa::kAvx512, MultiplyAvx512,  MultiplyArrayAvx512, InverseSse,   TryInverseSse,
+    InverseAffineSse, InverseRigidSse, TransformAvx2,       TransformArrayAvx512};
+
+const MathKernels& FindKernels(MathIsa isa) {
+	if (isa > GetCpuMathIsa()) {
+		isa = GetCpuMathIsa();
+	}
+	switch (isa) {
+	case MathIsa::kAvx512:
+		return kAvx512Kernels;
+	case MathIsa::kAvx2:
+		return kAvx2Kernels;
+	case MathIsa::kSse:
+		return kSseKernels;
+	default:
+		return kScalarKernels;
+	}
+}
+
+
+// 相対誤差で比較
+bool NearlyEqual(float a, float b, float tolerance) {
+	float scale = std::fmax(1.0f, std::fmax(std::fabs(a), std::fabs(b)));
+	return std::fabs(a - b) <= tolerance * scale;
+}
+
+bool NearlyEqual(const Matrix4x4& a, const Matrix4x4& b, float tolerance) {
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			if (!NearlyEqual(a.m[row][column], b.m[row][column], tolerance)) {
+				return false;
+			}
+		}
+	}
+	return true;
+}
+
+} // namespace
+
+// main より前に呼ばれる静的初期化の中でも使えるよう、CPU 判定までは SSE 版にしておく
+constinit const MathKernels* gMathKernels = &kSseKernels;
+constinit bool gMultiplySimd = true;
+
+MathIsa GetCpuMathIsa() {
+	static const MathIsa isa = DetectCpuMathIsa();
+	return isa;
+}
+
+void SelectMathKernels(MathIsa isa) {
+	gMathKernels = &FindKernels(isa);
+	gMultiplySimd = gMathKernels->isa != MathIsa::kScalar;
+}
+
+namespace {
+
+// 起動時に CPU に合わせたカーネルを選ぶ
+bool SelectDefaultKernels() {
+	SelectMathKernels(GetCpuMathIsa());
+#ifdef _DEBUG
+	// デバッグビルドでは起動時にスカラー版との一致を確認する
+	assert(VerifyMathKernels(gMathKernels->isa, 1.0e-4f));
+#endif
+	return true;
+}
+
+[[maybe_unused]] const bool kDefaultKernelsSelected = SelectDefaultKernels();
+
+} // namespace
+
+bool VerifyMathKernels(MathIsa isa, float tolerance) {
+	const MathKernels& kernels = FindKernels(isa);
+
+	// 検証用の行列 (回転・拡縮・平行移動・透視投影の組み合わせ)
+	// 比べる相手なので、選ばれているカーネルを使わずスカラー版で合成する
+	const Matrix4x4 samples[] = {
+	    MakeIdentityMatrix(),
+	    MultiplyScalar(
+	        MultiplyScalar(MakeScaleMatrix({1.0f, 2.0f, 0.5f}), MakeRotateXMatrix(0.3f)),
+	        MakeTranslateMatrix({10.0f, -4.0f, 3.5f})),
+	    MultiplyScalar(
+	        MultiplyScalar(MakeRotateYMatrix(-1.2f), MakeRotateZMatrix(2.1f)),
+	        MakeTranslateMatrix({-100.0f, 25.0f, 0.0f})),
+	    MakePerspectiveFovMatrix(0.45f, 1280.0f / 720.0f, 0.1f, 100.0f),
+	    MakeViewportMatrix(0.0f, 0.0f, 1280.0f, 720.0f, 0.0f, 1.0f),
+	    MakeOrthographicMatrix(-160.0f, 160.0f, 200.0f, 300.0f, 0.0f, 1000.0f),
+	    {3.2f, 0.7f, 0.4f, 0.0f, 2.1f, -5.5f, 1.0f, 0.3f,
+	     0.0f, 1.5f, 2.0f, -0.7f, 1.2f, 0.0f, -3.3f, 1.9f},
+	};
+	// どの行列でも w が 0 にならない点
+	const Vector3 points[] = {
+	    {0.5f, 0.25f, 1.0f}, {1.0f, -2.0f, 3.0f}, {-0.25f, 4.5f, 12.0f}, {100.0f, 0.5f, -7.0f}};
+
+	// 配列の積 (全部の組み合わせを並べて 1 回で求める)
+	const size_t kSampleCount = sizeof(samples) / sizeof(samples[0]);
+	Matrix4x4 lefts[kSampleCount * kSampleCount];
+	Matrix4x4 rights[kSampleCount * kSampleCount];
+	Matrix4x4 products[kSampleCount * kSampleCount];
+	for (size_t i = 0; i < kSampleCount * kSampleCount; ++i) {
+		lefts[i] = samples[i / kSampleCount];
+		rights[i] = samples[i % kSampleCount];
+	}
+	kernels.multiplyArray(lefts, rights, products, kSampleCount * kSampleCount);
+	for (size_t i = 0; i < kSampleCount * kSampleCount; ++i) {
+		if (!NearlyEqual(products[i], MultiplyScalar(lefts[i], rights[i]), tolerance)) {
+			return false;
+		}
+	}
+
+	for (const Matrix4x4& m1 : samples) {
+		for (const Matrix4x4& m2 : samples) {
+			if (!NearlyEqual(kernels.multiply(m1, m2), MultiplyScalar(m1, m2), tolerance)) {
+				return false;
+			}
+		}
+		if (!NearlyEqual(kernels.inverse(m1), InverseScalar(m1), tolerance)) {
+			return false;
+		}
+		// アフィン変換の行列ならアフィン用の逆行列とも一致すること
+		if (m1.m[0][3] == 0.0f && m1.m[1][3] == 0.0f && m1.m[2][3] == 0.0f && m1.m[3][3] == 1.0f &&
+		    !NearlyEqual(kernels.inverseAffine(m1), InverseScalar(m1), tolerance)) {
+			return false;
+		}
+		// 点ごとに値を変えて並べる (並べ替えで点を取り違えたら分かるように)
+		// 倍率は 1 から 1.625 なので、どの行列でも w は 0 にならない
+		const size_t kMaxPointCount = 40;
+		Vector3 batch[kMaxPointCount];
+		Vector3 expected[kMaxPointCount];
+		for (size_t i = 0; i < kMaxPointCount; ++i) {
+			batch[i] = Vec3Multiply(1.0f + float(i) / 64.0f, points[i % 4]);
+			expected[i] = TransformScalar(batch[i], m1);
+			Vector3 single = kernels.transform(batch[i], m1);
+			if (!NearlyEqual(single.x, expected[i].x, tolerance) ||
+			    !NearlyEqual(single.y, expected[i].y, tolerance) ||
+			    !NearlyEqual(single.z, expected[i].z, tolerance)) {
+				return false;
+			}
+		}
+		// 一括変換は 0 から 40 点まで (16 点ずつの AVX-512 版を 2 回まわし、
+		// 8 点ずつ・4 点ずつの版の端数もすべての長さを通る)。count より後ろに書かないことも見る
+		for (size_t count = 0; count <= kMaxPointCount; ++count) {
+			Vector3 batchResults[kMaxPointCount + 1];
+			for (Vector3& result : batchResults) {
+				result = {-1.0f, -2.0f, -3.0f};
+			}
+			kernels.transformArray(batch, batchResults, count, m1);
+			for (size_t i = 0; i < count; ++i) {
+				const Vector3& batched = batchResults[i];
+				if (!NearlyEqual(batched.x, expected[i].x, tolerance) ||
+				    !NearlyEqual(batched.y, expected[i].y, tolerance) ||
+				    !NearlyEqual(batched.z, expected[i].z, tolerance)) {
+					return false;
+				}
+			}
+			const Vector3& untouched = batchResults[count];
+			if (untouched.x != -1.0f || untouched.y != -2.0f || untouched.z != -3.0f) {
+				return false;
+			}
+		}
+	}
+
+	// 回転 + 平行移動のみの行列
+	const Matrix4x4 rigid = samples[2];
+	if (!NearlyEqual(kernels.inverseRigid(rigid), InverseScalar(rigid), tolerance)) {
+		return false;
+	}
+
+	// 特異な行列 (1 行目と 2 行目が同じ) は逆行列なしと判定できること
+	const Matrix4x4 singular = {1.0f, 2.0f, 3.0f, 0.0f, 1.0f, 2.0f, 3.0f, 0.0f,
+	                            0.0f, 0.0f, 1.0f, 0.0f, 4.0f, 5.0f, 6.0f, 1.0f};
+	Matrix4x4 unused;
+	if (kernels.tryInverse(singular, unused) || !kernels.tryInverse(samples[0], unused)) {
+		return false;
+	}
+	// 3 行目が 1, 2 行目の組み合わせの行列は、行列式が丸め誤差で 0 にならなくても特異と判定すること
+	Matrix4x4 rankTwo = {1.3f, -2.1f, 0.7f,  0.4f, 0.2f,  1.9f, -1.1f, 2.5f,
+	                     0.0f, 0.0f,  0.0f,  0.0f, 0.5f, 0.25f, -3.0f, 1.0f};
+	for (int column = 0; column < 4; ++column) {
+		rankTwo.m[2][column] = rankTwo.m[0][column] / 3.0f + 2.0f * rankTwo.m[1][column] / 7.0f;
+	}
+	if (kernels.tryInverse(rankTwo, unused)) {
+		return false;
+	}
+	return true;
+}
+
+const char* GetMathIsaName(MathIsa isa) {
+	switch (isa) {
+	case MathIsa::kAvx512:
+		return "AVX-512";
+	case MathIsa::kAvx2:
+		return "AVX2";
+	case MathIsa::kSse:
+		return "SSE";
+	default:
+		return "Scalar";
+	}
+}
@@ -0,0 +1,91 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cfloat>
+#include <cmath>
+
+/*---------------------------------
+ SIMD カーネル
+ ・CPU の命令セットを起動時 (main より前) に一度だけ判定し、
+   Multiply / MultiplyArray / Inverse / Transform / TransformArray などの実装を切り替える
+ ・スカラー版 (MultiplyScalar など) が基準実装
+ ・行列の積はどの SIMD 版も SSE 版と同じ順に掛けて足す (FMA を使わない) ので、
+   Multiply と MultiplyArray の結果はビットまで同じになる
+------------------------------------*/
+
+#if defined(_MSC_VER)
+// MSVC は /arch 指定なしでも各命令セットの組み込み関数を使える
+#define MATH_TARGET_AVX2
+#define MATH_TARGET_AVX512
+#else
+#define MATH_TARGET_AVX2 __attribute__((target("avx2,fma,f16c")))
+#define MATH_TARGET_AVX512 __attribute__((target("avx512f,avx2,fma,f16c")))
+#endif
+
+// 命令セット (数値が大きいほど上位)
+enum class MathIsa {
+	kScalar,
+	kSse,    // SSE2 (x64 では必ず使える)
+	kAvx2,   // AVX2 + FMA + F16C (半精度の変換)
+	kAvx512, // AVX-512F
+};
+
+// カーネルの関数テーブル
+struct MathKernels {
+	MathIsa isa;
+	Matrix4x4 (*multiply)(const Matrix4x4& m1, const Matrix4x4& m2);
+	void (*multiplyArray)(
+	    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count);
+	Matrix4x4 (*inverse)(const Matrix4x4& m);
+	bool (*tryInverse)(const Matrix4x4& m, Matrix4x4& result);
+	Matrix4x4 (*inverseAffine)(const Matrix4x4& m);
+	Matrix4x4 (*inverseRigid)(const Matrix4x4& m);
+	Vector3 (*transform)(const Vector3& vector, const Matrix4x4& matrix);
+	void (*transformArray)(
+	    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix);
+};
+
+// 行列式の丸め誤差の目安 (行列式の 24 項の絶対値の和)
+// 上 2 行から選ぶ 2 列と、下 2 行から選ぶ残りの 2 列の 6 通りに分けて求める
+inline float GetDeterminantScale(const Matrix4x4& m) {
+	auto pair = [&m](int top, int i, int j) {
+		return std::fabs(m.m[top][i] * m.m[top + 1][j]) + std::fabs(m.m[top][j] * m.m[top + 1][i]);
+	};
+	return pair(0, 0, 1) * pair(2, 2, 3) + pair(0, 0, 2) * pair(2, 1, 3) +
+	       pair(0, 0, 3) * pair(2, 1, 2) + pair(0, 1, 2) * pair(2, 0, 3) +
+	       pair(0, 1, 3) * pair(2, 0, 2) + pair(0, 2, 3) * pair(2, 0, 1);
+}
+
+// 逆行列を求めてよい行列式か
+// 行列式が丸め誤差の目安に比べて小さければ特異とみなす (階数の落ちた行列でも丸め誤差で 0 に
+// ならないことがあり、そのまま割ると意味のない大きな値の逆行列になる)
+// 平行移動の大きさは 0 の成分と掛かるので目安に入らない (原点から遠いアフィン変換も逆にできる)
+// scale は GetDeterminantScale の値
+inline bool IsInvertibleDeterminant(float determinant, float scale) {
+	const float kSingularTolerance = 32.0f * FLT_EPSILON;
+	return std::fabs(determinant) > kSingularTolerance * scale &&
+	       std::isfinite(1.0f / determinant);
+}
+
+// この CPU で使える最上位の命令セット
+MathIsa GetCpuMathIsa();
+
+// 現在選択されているカーネル (起動時に CPU 判定して選ぶ。書き換えは SelectMathKernels で)
+// 呼び出しごとの初期化の確認をなくすため、関数内の static ではなく名前空間の変数に持つ
+extern const MathKernels* gMathKernels;
+
+// 現在選択されているカーネル
+inline const MathKernels& GetMathKernels() { return *gMathKernels; }
+
+// AVX2 以上のカーネル (FMA, F16C も使える) が選ばれているか
+// AVX2 版とスカラー版だけを持つ処理の切り替えに使う (AVX-512 のときも AVX2 版になる)
+inline bool HasAvx2Kernels() { return GetMathKernels().isa >= MathIsa::kAvx2; }
+
+// カーネルを指定の命令セットに切り替える (CPU が対応していなければ対応している最上位に落とす)
+// ベンチマーク・検証用。起動直後のスレッドが 1 つの間に呼ぶこと
+void SelectMathKernels(MathIsa isa);
+
+// 指定の命令セットのカーネルがスカラー版と誤差 tolerance (相対) 以内で一致するか検証
+bool VerifyMathKernels(MathIsa isa, float tolerance);
+
+// 命令セット名
+const char* GetMathIsaName(MathIsa isa);
@@ -1,94 +1,15 @@
 ﻿#include "Mathfunction.h"
+#include "FastMath.h"
+#include "MathSimd.h"
+#include "Profiler.h"
 #include <cassert>
 #include <cmath>
 
-// 行列の積
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
-	Matrix4x4 result;
-	result.m[0][0] = (m1.m[0][0] * m2.m[0][0]) + (m1.m[0][1] * m2.m[1][0]) +
-	                 (m1.m[0][2] * m2.m[2][0]) + (m1.m[0][3] * m2.m[3][0]);
-	result.m[0][1] = (m1.m[0][0] * m2.m[0][1]) + (m1.m[0][1] * m2.m[1][1]) +
-	                 (m1.m[0][2] * m2.m[2][1]) + (m1.m[0][3] * m2.m[3][1]);
-	result.m[0][2] = (m1.m[0][0] * m2.m[0][2]) + (m1.m[0][1] * m2.m[1][2]) +
-	                 (m1.m[0][2] * m2.m[2][2]) + (m1.m[0][3] * m2.m[3][2]);
-	result.m[0][3] = (m1.m[0][0] * m2.m[0][3]) + (m1.m[0][1] * m2.m[1][3]) +
-	                 (m1.m[0][2] * m2.m[2][3]) + (m1.m[0][3] * m2.m[3][3]);
-	result.m[1][0] = (m1.m[1][0] * m2.m[0][0]) + (m1.m[1][1] * m2.m[1][0]) +
-	                 (m1.m[1][2] * m2.m[2][0]) + (m1.m[1][3] * m2.m[3][0]);
-	result.m[1][1] = (m1.m[1][0] * m2.m[0][1]) + (m1.m[1][1] * m2.m[1][1]) +
-	                 (m1.m[1][2] * m2.m[2][1]) + (m1.m[1][3] * m2.m[3][1]);
-	result.m[1][2] = (m1.m[1][0] * m2.m[0][2]) + (m1.m[1][1] * m2.m[1][2]) +
-	                 (m1.m[1][2] * m2.m[2][2]) + (m1.m[1][3] * m2.m[3][2]);
-	result.m[1][3] = (m1.m[1][0] * m2.m[0][3]) + (m1.m[1][1] * m2.m[1][3]) +
-	                 (m1.m[1][2] * m2.m[2][3]) + (m1.m[1][3] * m2.m[3][3]);
-
-	result.m[2][0] = (m1.m[2][0] * m2.m[0][0]) + (m1.m[2][1] * m2.m[1][0]) +
-	                 (m1.m[2][2] * m2.m[2][0]) + (m1.m[2][3] * m2.m[3][0]);
-	result.m[2][1] = (m1.m[2][0] * m2.m[0][1]) + (m1.m[2][1] * m2.m[1][1]) +
-	                 (m1.m[2][2] * m2.m[2][1]) + (m1.m[2][3] * m2.m[3][1]);
-	result.m[2][2] = (m1.m[2][0] * m2.m[0][2]) + (m1.m[2][1] * m2.m[1][2]) +
-	                 (m1.m[2][2] * m2.m[2][2]) + (m1.m[2][3] * m2.m[3][2]);
-	result.m[2][3] = (m1.m[2][0] * m2.m[0][3]) + (m1.m[2][1] * m2.m[1][3]) +
-	                 (m1.m[2][2] * m2.m[2][3]) + (m1.m[2][3] * m2.m[3][3]);
-	result.m[3][0] = (m1.m[3][0] * m2.m[0][0]) + (m1.m[3][1] * m2.m[1][0]) +
-	                 (m1.m[3][2] * m2.m[2][0]) + (m1.m[3][3] * m2.m[3][0]);
-	result.m[3][1] = (m1.m[3][0] * m2.m[0][1]) + (m1.m[3][1] * m2.m[1][1]) +
-	                 (m1.m[3][2] * m2.m[2][1]) + (m1.m[3][3] * m2.m[3][1]);
-	result.m[3][2] = (m1.m[3][0] * m2.m[0][2]) + (m1.m[3][1] * m2.m[1][2]) +
-	                 (m1.m[3][2] * m2.m[2][2]) + (m1.m[3][3] * m2.m[3][2]);
-	result.m[3][3] = (m1.m[3][0] * m2.m[0][3]) + (m1.m[3][1] * m2.m[1][3]) +
-	                 (m1.m[3][2] * m2.m[2][3]) + (m1.m[3][3] * m2.m[3][3]);
-
-	return result;
-}
-
-// 拡大縮小行列
-Matrix4x4 MakeScaleMatrix(const Vector3& scale) {
-	Matrix4x4 result;
-
-	result.m[0][0] = scale.x;
-	result.m[0][1] = 0.0f;
-	result.m[0][2] = 0.0f;
-	result.m[0][3] = 0.0f;
-	result.m[1][0] = 0.0f;
-	result.m[1][1] = scale.y;
-	result.m[1][2] = 0.0f;
-	result.m[1][3] = 0.0f;
-	result.m[2][0] = 0.0f;
-	result.m[2][1] = 0.0f;
-	result.m[2][2] = scale.z;
-	result.m[2][3] = 0.0f;
-	result.m[3][0] = 0.0f;
-	result.m[3][1] = 0.0f;
-	result.m[3][2] = 0.0f;
-	result.m[3][3] = 1.0f;
-
-	return result;
-}
-
-// 平行移動
-Matrix4x4 MakeTranslateMatrix(const Vector3& translate) {
-	Matrix4x4 result;
-
-	result.m[0][0] = 1.0f;
-	result.m[0][1] = 0.0f;
-	result.m[0][2] = 0.0f;
-	result.m[0][3] = 0.0f;
-	result.m[1][0] = 0.0f;
-	result.m[1][1] = 1.0f;
-	result.m[1][2] = 0.0f;
-	result.m[1][3] = 0.0f;
-	result.m[2][0] = 0.0f;
-	result.m[2][1] = 0.0f;
-	result.m[2][2] = 1.0f;
-	result.m[2][3] = 0.0f;
-	result.m[3][0] = translate.x;
-	result.m[3][1] = translate.y;
-	result.m[3][2] = translate.z;
-	result.m[3][3] = 1.0f;
-
-	return result;
-}
+// ヘッダーの constexpr 関数がコンパイル時に計算できることの確認
+static_assert(
+    Multiply(MakeIdentityMatrix(), MakeTranslateMatrix({1.0f, 2.0f, 3.0f})).m[3][1] == 2.0f);
+static_assert(Transform({1.0f, 0.0f, 0.0f}, MakeScaleMatrix({2.0f, 2.0f, 2.0f})).x == 2.0f);
+static_assert(Dot(Cross({1.0f, 0.0f, 0.0f}, {0.0f, 1.0f, 0.0f}), {0.0f, 0.0f, 1.0f}) == 1.0f);
 
 /*---------------------------------
  回転行列
@@ -97,8 +18,9 @@ Matrix4x4 MakeTranslateMatrix(const Vector3& translate) {
 // X軸
 Matrix4x4 MakeRotateXMatrix(float radian) {
 	Matrix4x4 result;
-	float cos = std::cos(radian);
-	float sin = std::sin(radian);
+	float sin;
+	float cos;
+	SinCos(radian, sin, cos);
 
 	result.m[0][0] = 1.0f;
 	result.m[0][1] = 0.0f;
@@ -123,8 +45,9 @@ Matrix4x4 MakeRotateXMatrix(float radian) {
 // Y軸
 Matrix4x4 MakeRotateYMatrix(float radian) {
 	Matrix4x4 result;
-	float cos = std::cos(radian);
-	float sin = std::sin(radian);
+	float sin;
+	float cos;
+	SinCos(radian, sin, cos);
 
 	result.m[0][0] = cos;
 	result.m[0][1] = 0.0f;
@@ -149,8 +72,9 @@ Matrix4x4 MakeRotateYMatrix(float radian) {
 // Z軸
 Matrix4x4 MakeRotateZMatrix(float radian) {
 	Matrix4x4 result;
-	float cos = std::cos(radian);
-	float sin = std::sin(radian);
+	float sin;
+	float cos;
+	SinCos(radian, sin, cos);
 
 	result.m[0][0] = cos;
 	result.m[0][1] = sin;
@@ -172,26 +96,34 @@ Matrix4x4 MakeRotateZMatrix(float radian) {
 	return result;
 }
 
-// ビューポート変換行列
-Matrix4x4 MakeViewportMatrix(
-    float left, float top, float width, float heght, float minDepth, float maxDepth) {
+// 各軸の sin, cos からアフィン変換を作る
+static Matrix4x4 MakeAffineMatrixFromSinCos(
+    const Vector3& scale, const Vector3& sin, const Vector3& cos, const Vector3& translate) {
 	Matrix4x4 result;
-
-	result.m[0][0] = width / 2.0f;
-	result.m[0][1] = 0.0f;
-	result.m[0][2] = 0.0f;
+	float sx = sin.x;
+	float cx = cos.x;
+	float sy = sin.y;
+	float cy = cos.y;
+	float sz = sin.z;
+	float cz = cos.z;
+
+	// Scale * RotateX * RotateY * RotateZ * Translate を展開した形
+	// 回転部分の各行にそれぞれの軸のスケールが掛かる
+	result.m[0][0] = scale.x * (cy * cz);
+	result.m[0][1] = scale.x * (cy * sz);
+	result.m[0][2] = scale.x * (-sy);
 	result.m[0][3] = 0.0f;
-	result.m[1][0] = 0.0f;
-	result.m[1][1] = -heght / 2.0f;
-	result.m[1][2] = 0.0f;
+	result.m[1][0] = scale.y * (sx * sy * cz - cx * sz);
+	result.m[1][1] = scale.y * (sx * sy * sz + cx * cz);
+	result.m[1][2] = scale.y * (sx * cy);
 	result.m[1][3] = 0.0f;
-	result.m[2][0] = 0.0f;
-	result.m[2][1] = 0.0f;
-	result.m[2][2] = maxDepth - minDepth;
+	result.m[2][0] = scale.z * (cx * sy * cz + sx * sz);
+	result.m[2][1] = scale.z * (cx * sy * sz - sx * cz);
+	result.m[2][2] = scale.z * (cx * cy);
 	result.m[2][3] = 0.0f;
-	result.m[3][0] = left + width / 2.0f;
-	result.m[3][1] = top + heght / 2.0f;
-	result.m[3][2] = minDepth;
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
 	result.m[3][3] = 1.0f;
 
 	return result;
@@ -199,25 +131,32 @@ Matrix4x4 MakeViewportMatrix(
 
 // アフィン変換
 Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rot, const Vector3& translate) {
+	// 各軸の sin, cos は 1 回ずつ
+	Vector3 sin;
+	Vector3 cos;
+	SinCos(rot.x, sin.x, cos.x);
+	SinCos(rot.y, sin.y, cos.y);
+	SinCos(rot.z, sin.z, cos.z);
+	return MakeAffineMatrixFromSinCos(scale, sin, cos, translate);
+}
 
-	// スケーリング行列
-	Matrix4x4 Scale = MakeScaleMatrix(scale);
-
-	// 回転行列
-	Matrix4x4 RotateX = MakeRotateXMatrix(rot.x);
-	Matrix4x4 RotateY = MakeRotateYMatrix(rot.y);
-	Matrix4x4 RotateZ = MakeRotateZMatrix(rot.z);
-
-	// 回転行列合成
-	Matrix4x4 Rotate = Multiply(Multiply(RotateX, RotateY), RotateZ);
-
-	// 平行移動行列
-	Matrix4x4 Translate = MakeTranslateMatrix(translate);
-
-	// スケール、回転、平行移動の合成
-	Matrix4x4 Transform = Multiply(Multiply(Scale, Rotate), Translate);
-
-	return Transform;
+// アフィン変換 (配列の一括作成)
+void MakeAffineMatrices(
+    const Vector3* scales, const Vector3* rotates, const Vector3* translates,
+    Matrix4x4* results, size_t count) {
+	PROFILE_SCOPE("MakeAffineMatrices");
+	// sin, cos は区切りごとにまとめて求める (Vector3 の配列を float の配列として渡す)
+	const size_t kChunkSize = 64;
+	Vector3 sines[kChunkSize];
+	Vector3 cosines[kChunkSize];
+	for (size_t begin = 0; begin < count; begin += kChunkSize) {
+		size_t chunk = count - begin < kChunkSize ? count - begin : kChunkSize;
+		SinCosArray(&rotates[begin].x, &sines[0].x, &cosines[0].x, chunk * 3);
+		for (size_t i = 0; i < chunk; ++i) {
+			results[begin + i] = MakeAffineMatrixFromSinCos(
+			    scales[begin + i], sines[i], cosines[i], translates[begin + i]);
+		}
+	}
 }
 
 // 透視投影行列
@@ -245,35 +184,8 @@ Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip
 	return result;
 }
 
-// 正射影行列
-Matrix4x4 MakeOrthographicMatrix(
-    float left, float top, float right, float bottom, float nearClip, float farClip) {
-	Matrix4x4 result;
-
-	result.m[0][0] = 2.0f / (right - left);
-	result.m[0][1] = 0.0f;
-	result.m[0][2] = 0.0f;
-	result.m[0][3] = 0.0f;
-	result.m[1][0] = 0.0f;
-	result.m[1][1] = 2.0f / (top - bottom);
-	result.m[1][2] = 0.0f;
-	result.m[1][3] = 0.0f;
-	result.m[2][0] = 0.0f;
-	result.m[2][1] = 0.0f;
-	result.m[2][2] = 1.0f / (farClip - nearClip);
-	result.m[2][3] = 0.0f;
-	result.m[3][0] = (left + right) / (left - right);
-	result.m[3][1] = (top + bottom) / (bottom - top);
-	result.m[3][2] = nearClip / (nearClip - farClip);
-	result.m[3][3] = 1.0f;
-
-	return result;
-}
-
-// 逆行列
-Matrix4x4 Inverse(const Matrix4x4& m) {
-	Matrix4x4 result;
-
+// 逆行列 (スカラー版。特異なら false)
+bool TryInverseScalar(const Matrix4x4& m, Matrix4x4& result) {
 	// 4x4の行列式を求める
 	float determinant = (m.m[0][0] * m.m[1][1] * m.m[2][2] * m.m[3][3]) +
 	                    (m.m[0][0] * m.m[1][2] * m.m[2][3] * m.m[3][1]) +
@@ -301,6 +213,9 @@ Matrix4x4 Inverse(const Matrix4x4& m) {
 	                    (m.m[0][1] * m.m[1][3] * m.m[2][2] * m.m[3][0]);
 
 	float a = 1.0f / determinant; // 1÷行列式(1/|A|)
+	if (!IsInvertibleDeterminant(determinant, GetDeterminantScale(m))) {
+		return false;
+	}
 
 	// 逆行列を求める
 	result.m[0][0] =
@@ -355,7 +270,7 @@ Matrix4x4 Inverse(const Matrix4x4& m) {
 
 	result.m[2][2] =
 	    a * ((m.m[0][0] * m.m[1][1] * m.m[3][3]) + (m.m[0][1] * m.m[1][3] * m.m[3][0]) +
-	         (m.m[0][3] * m.m[1][0] * m.m[3][1]) - (m.m[0][3] * m.m[1][1] * m.m[2][0]) -
+	         (m.m[0][3] * m.m[1][0] * m.m[3][1]) - (m.m[0][3] * m.m[1][1] * m.m[3][0]) -
 	         (m.m[0][1] * m.m[1][0] * m.m[3][3]) - (m.m[0][0] * m.m[1][3] * m.m[3][1]));
 
 	result.m[2][3] =
@@ -383,67 +298,94 @@ Matrix4x4 Inverse(const Matrix4x4& m) {
 	         (m.m[0][2] * m.m[1][0] * m.m[2][1]) - (m.m[0][2] * m.m[1][1] * m.m[2][0]) -
 	         (m.m[0][1] * m.m[1][0] * m.m[2][2]) - (m.m[0][0] * m.m[1][2] * m.m[2][1]));
 
+	return true;
+}
+
+// 逆行列 (スカラー版)
+Matrix4x4 InverseScalar(const Matrix4x4& m) {
+	Matrix4x4 result;
+	[[maybe_unused]] bool invertible = TryInverseScalar(m, result);
+	assert(invertible);
 	return result;
 }
 
-// 単位行列
-Matrix4x4 MakeIdentityMatrix() {
-	static const Matrix4x4 result{1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
-	                              0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+// 配列の積 (スカラー版)
+void MultiplyArrayScalar(
+    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = MultiplyScalar(m1[i], m2[i]);
+	}
+}
 
-	return result;
+// 配列の一括変換 (スカラー版)
+void TransformArrayScalar(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix) {
+	for (size_t i = 0; i < count; ++i) {
+		const Vector3& v = vectors[i];
+		float x =
+		    v.x * matrix.m[0][0] + v.y * matrix.m[1][0] + v.z * matrix.m[2][0] + matrix.m[3][0];
+		float y =
+		    v.x * matrix.m[0][1] + v.y * matrix.m[1][1] + v.z * matrix.m[2][1] + matrix.m[3][1];
+		float z =
+		    v.x * matrix.m[0][2] + v.y * matrix.m[1][2] + v.z * matrix.m[2][2] + matrix.m[3][2];
+		float w =
+		    v.x * matrix.m[0][3] + v.y * matrix.m[1][3] + v.z * matrix.m[2][3] + matrix.m[3][3];
+		// 除算は 1 回だけ
+		float invW = 1.0f / w;
+		results[i] = {x * invW, y * invW, z * invW};
+	}
 }
 
-// 変換
-Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix) {
-	Vector3 result;
-	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] +
-	           1.0f * matrix.m[3][0];
-	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] +
-	           1.0f * matrix.m[3][1];
-	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] +
-	           1.0f * matrix.m[3][2];
-	float w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] +
-	          1.0f * matrix.m[3][3];
-	assert(w != 0.0f);
-	result.x /= w;
-	result.y /= w;
-	result.z /= w;
+// 同次座標への配列の一括変換
+void TransformArrayHomogeneous(
+    const Vector3* vectors, Vector4* results, size_t count, const Matrix4x4& matrix) {
+	PROFILE_SCOPE("TransformArrayHomogeneous");
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = TransformHomogeneous(vectors[i], matrix);
+	}
+}
 
-	return result;
+// 行列の積 (実行時)
+Matrix4x4 MultiplyDispatch(const Matrix4x4& m1, const Matrix4x4& m2) {
+	return GetMathKernels().multiply(m1, m2);
 }
 
-// 長さ（ノルム）
-float Length(const Vector3& v) {
-	float result;
-	result = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
-	return result;
+// 配列の積
+void MultiplyArray(const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count) {
+	PROFILE_SCOPE("MultiplyArray");
+	GetMathKernels().multiplyArray(m1, m2, results, count);
 }
 
-// 加算
-Vector3 Vec3Add(const Vector3& v1, const Vector3& v2) {
-	Vector3 result;
-	result.x = v1.x + v2.x;
-	result.y = v1.y + v2.y;
-	result.z = v1.z + v2.z;
-	return result;
+// 逆行列
+Matrix4x4 Inverse(const Matrix4x4& m) { return GetMathKernels().inverse(m); }
+
+// 逆行列 (特異なら false)
+bool TryInverse(const Matrix4x4& m, Matrix4x4& result) {
+	return GetMathKernels().tryInverse(m, result);
 }
 
-// 減算
-Vector3 Vec3Subtract(const Vector3& v1, const Vector3& v2) {
-	Vector3 result;
-	result.x = v1.x - v2.x;
-	result.y = v1.y - v2.y;
-	result.z = v1.z - v2.z;
-	return result;
+// 逆行列 (アフィン変換用)
+Matrix4x4 InverseAffine(const Matrix4x4& m) { return GetMathKernels().inverseAffine(m); }
+
+// 逆行列 (回転 + 平行移動のみ用)
+Matrix4x4 InverseRigid(const Matrix4x4& m) { return GetMathKernels().inverseRigid(m); }
+
+// 変換 (実行時)
+Vector3 TransformDispatch(const Vector3& vector, const Matrix4x4& matrix) {
+	return GetMathKernels().transform(vector, matrix);
 }
 
-// スカラー倍
-Vector3 Vec3Multiply(float scalar, const Vector3& v) {
-	Vector3 result;
-	result.x = scalar * v.x;
-	result.y = scalar * v.y;
-	result.z = scalar * v.z;
+// 配列の一括変換
+void TransformArray(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix) {
+	PROFILE_SCOPE("TransformArray");
+	GetMathKernels().transformArray(vectors, results, count, matrix);
+}
+
+// 長さ（ノルム）
+float Length(const Vector3& v) {
+	float result;
+	result = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
 	return result;
 }
 
@@ -451,24 +393,12 @@ Vector3 Vec3Multiply(float scalar, const Vector3& v) {
 Vector3 Normalize(const Vector3& v) {
 	Vector3 result;
 	float norm = sqrtf(v.x * v.x + v.y * v.y + v.z * v.z);
+	if (norm == 0.0f) {
+		return {0.0f, 0.0f, 0.0f};
+	}
 	result.x = v.x / norm;
 	result.y = v.y / norm;
 	result.z = v.z / norm;
 	return result;
 }
 
-// クロス積
-Vector3 Cross(const Vector3& v1, const Vector3& v2) {
-	Vector3 result;
-	result.x = v1.y * v2.z - v1.z * v2.y;
-	result.y = v1.z * v2.x - v1.x * v2.z;
-	result.z = v1.x * v2.y - v1.y * v2.x;
-	return result;
-}
-
-// 内積
-float Dot(const Vector3& v1, const Vector3& v2) {
-	float result;
-	result = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
-	return result;
-}
\ No newline at end of file
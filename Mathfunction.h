@@ -1,25 +1,422 @@
 ﻿#pragma once
+#include <cassert>
+#include <cstddef>
+#include <type_traits>
+#include <xmmintrin.h>
 
-struct Vector3 {
-	float x;
-	float y;
-	float z;
+/*---------------------------------
+ ベクトルと行列
+ ・成分の型を選べる。ふだんは float の Vector3 / Vector4 / Matrix4x4 を使う
+ ・double 版 (Vector3d など) は原点から遠い位置を持つためのもの。
+   描画の前にカメラからの相対位置にして float に落とす (CameraRelative.h)
+------------------------------------*/
+template <typename T>
+struct Vector3T {
+	T x;
+	T y;
+	T z;
 };
 
-struct Matrix4x4 {
-	float m[4][4];
+// 同次座標 (クリップ空間の点など)
+template <typename T>
+struct Vector4T {
+	T x;
+	T y;
+	T z;
+	T w;
 };
 
-// 積
-Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2);
+template <typename T>
+struct Matrix4x4T {
+	T m[4][4];
+};
+
+using Vector3 = Vector3T<float>;
+using Vector4 = Vector4T<float>;
+using Matrix4x4 = Matrix4x4T<float>;
+using Vector3d = Vector3T<double>;
+using Vector4d = Vector4T<double>;
+using Matrix4x4d = Matrix4x4T<double>;
+
+/*---------------------------------
+ ヘッダーで定義する関数
+ ・sin, cos, sqrt などを使わないものは constexpr にしてある
+ ・定数の行列や頂点表はコンパイル時に計算される
+ ・成分の型の template になっていて、double 版にも使える ({...} で渡すと float 版になる)
+ ・SIMD 版に切り替える関数 (Multiply, Transform など) と cpp で定義する関数は float 版だけ。
+   double 版は …Scalar を使う
+------------------------------------*/
+
+// 成分の型を変える (double の位置を float に落とすときなど)
+template <typename To, typename From>
+constexpr Vector3T<To> Vec3Cast(const Vector3T<From>& v) {
+	return {To(v.x), To(v.y), To(v.z)};
+}
+
+// 加算
+template <typename T = float>
+constexpr Vector3T<T> Vec3Add(const Vector3T<T>& v1, const Vector3T<T>& v2) {
+	Vector3T<T> result;
+	result.x = v1.x + v2.x;
+	result.y = v1.y + v2.y;
+	result.z = v1.z + v2.z;
+	return result;
+}
+
+// 減算
+template <typename T = float>
+constexpr Vector3T<T> Vec3Subtract(const Vector3T<T>& v1, const Vector3T<T>& v2) {
+	Vector3T<T> result;
+	result.x = v1.x - v2.x;
+	result.y = v1.y - v2.y;
+	result.z = v1.z - v2.z;
+	return result;
+}
+
+// スカラー倍
+template <typename T = float>
+constexpr Vector3T<T> Vec3Multiply(std::type_identity_t<T> scalar, const Vector3T<T>& v) {
+	Vector3T<T> result;
+	result.x = scalar * v.x;
+	result.y = scalar * v.y;
+	result.z = scalar * v.z;
+	return result;
+}
+
+// 内積
+template <typename T = float>
+constexpr T Dot(const Vector3T<T>& v1, const Vector3T<T>& v2) {
+	T result;
+	result = v1.x * v2.x + v1.y * v2.y + v1.z * v2.z;
+	return result;
+}
+
+// ノルムの 2 乗 (大小を比べるだけなら sqrt がいらない)
+template <typename T = float>
+constexpr T LengthSquared(const Vector3T<T>& v) {
+	return Dot(v, v);
+}
+
+// 2 点間の距離の 2 乗
+template <typename T = float>
+constexpr T DistanceSquared(const Vector3T<T>& v1, const Vector3T<T>& v2) {
+	return LengthSquared(Vec3Subtract(v1, v2));
+}
+
+// クロス積
+template <typename T = float>
+constexpr Vector3T<T> Cross(const Vector3T<T>& v1, const Vector3T<T>& v2) {
+	Vector3T<T> result;
+	result.x = v1.y * v2.z - v1.z * v2.y;
+	result.y = v1.z * v2.x - v1.x * v2.z;
+	result.z = v1.x * v2.y - v1.y * v2.x;
+	return result;
+}
+
+// 積 (スカラー版。SIMD 版の基準)
+template <typename T = float>
+constexpr Matrix4x4T<T> MultiplyScalar(const Matrix4x4T<T>& m1, const Matrix4x4T<T>& m2) {
+	Matrix4x4T<T> result;
+	result.m[0][0] = (m1.m[0][0] * m2.m[0][0]) + (m1.m[0][1] * m2.m[1][0]) +
+	                 (m1.m[0][2] * m2.m[2][0]) + (m1.m[0][3] * m2.m[3][0]);
+	result.m[0][1] = (m1.m[0][0] * m2.m[0][1]) + (m1.m[0][1] * m2.m[1][1]) +
+	                 (m1.m[0][2] * m2.m[2][1]) + (m1.m[0][3] * m2.m[3][1]);
+	result.m[0][2] = (m1.m[0][0] * m2.m[0][2]) + (m1.m[0][1] * m2.m[1][2]) +
+	                 (m1.m[0][2] * m2.m[2][2]) + (m1.m[0][3] * m2.m[3][2]);
+	result.m[0][3] = (m1.m[0][0] * m2.m[0][3]) + (m1.m[0][1] * m2.m[1][3]) +
+	                 (m1.m[0][2] * m2.m[2][3]) + (m1.m[0][3] * m2.m[3][3]);
+	result.m[1][0] = (m1.m[1][0] * m2.m[0][0]) + (m1.m[1][1] * m2.m[1][0]) +
+	                 (m1.m[1][2] * m2.m[2][0]) + (m1.m[1][3] * m2.m[3][0]);
+	result.m[1][1] = (m1.m[1][0] * m2.m[0][1]) + (m1.m[1][1] * m2.m[1][1]) +
+	                 (m1.m[1][2] * m2.m[2][1]) + (m1.m[1][3] * m2.m[3][1]);
+	result.m[1][2] = (m1.m[1][0] * m2.m[0][2]) + (m1.m[1][1] * m2.m[1][2]) +
+	                 (m1.m[1][2] * m2.m[2][2]) + (m1.m[1][3] * m2.m[3][2]);
+	result.m[1][3] = (m1.m[1][0] * m2.m[0][3]) + (m1.m[1][1] * m2.m[1][3]) +
+	                 (m1.m[1][2] * m2.m[2][3]) + (m1.m[1][3] * m2.m[3][3]);
+
+	result.m[2][0] = (m1.m[2][0] * m2.m[0][0]) + (m1.m[2][1] * m2.m[1][0]) +
+	                 (m1.m[2][2] * m2.m[2][0]) + (m1.m[2][3] * m2.m[3][0]);
+	result.m[2][1] = (m1.m[2][0] * m2.m[0][1]) + (m1.m[2][1] * m2.m[1][1]) +
+	                 (m1.m[2][2] * m2.m[2][1]) + (m1.m[2][3] * m2.m[3][1]);
+	result.m[2][2] = (m1.m[2][0] * m2.m[0][2]) + (m1.m[2][1] * m2.m[1][2]) +
+	                 (m1.m[2][2] * m2.m[2][2]) + (m1.m[2][3] * m2.m[3][2]);
+	result.m[2][3] = (m1.m[2][0] * m2.m[0][3]) + (m1.m[2][1] * m2.m[1][3]) +
+	                 (m1.m[2][2] * m2.m[2][3]) + (m1.m[2][3] * m2.m[3][3]);
+	result.m[3][0] = (m1.m[3][0] * m2.m[0][0]) + (m1.m[3][1] * m2.m[1][0]) +
+	                 (m1.m[3][2] * m2.m[2][0]) + (m1.m[3][3] * m2.m[3][0]);
+	result.m[3][1] = (m1.m[3][0] * m2.m[0][1]) + (m1.m[3][1] * m2.m[1][1]) +
+	                 (m1.m[3][2] * m2.m[2][1]) + (m1.m[3][3] * m2.m[3][1]);
+	result.m[3][2] = (m1.m[3][0] * m2.m[0][2]) + (m1.m[3][1] * m2.m[1][2]) +
+	                 (m1.m[3][2] * m2.m[2][2]) + (m1.m[3][3] * m2.m[3][2]);
+	result.m[3][3] = (m1.m[3][0] * m2.m[0][3]) + (m1.m[3][1] * m2.m[1][3]) +
+	                 (m1.m[3][2] * m2.m[2][3]) + (m1.m[3][3] * m2.m[3][3]);
+
+	return result;
+}
+
+// m1 の 1 行 a と m2 の各行の積 (a[0] * row0 + a[1] * row1 + a[2] * row2 + a[3] * row3)
+inline __m128 MultiplyRowSse(__m128 a, __m128 row0, __m128 row1, __m128 row2, __m128 row3) {
+	__m128 r = _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(0, 0, 0, 0)), row0);
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(1, 1, 1, 1)), row1));
+	r = _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(2, 2, 2, 2)), row2));
+	return _mm_add_ps(r, _mm_mul_ps(_mm_shuffle_ps(a, a, _MM_SHUFFLE(3, 3, 3, 3)), row3));
+}
+
+// 積 (SSE 版。x64 では必ず使えるので、呼び出し元に展開させる)
+// AVX2 / AVX-512 の MultiplyArray も同じ順に掛けて足すので、結果はビットまで同じになる
+// 行のループは展開しておく (ループのままだと一度スタックに書いてから写すコードになる)
+inline Matrix4x4 MultiplySse(const Matrix4x4& m1, const Matrix4x4& m2) {
+	__m128 row0 = _mm_loadu_ps(m2.m[0]);
+	__m128 row1 = _mm_loadu_ps(m2.m[1]);
+	__m128 row2 = _mm_loadu_ps(m2.m[2]);
+	__m128 row3 = _mm_loadu_ps(m2.m[3]);
+	Matrix4x4 result;
+	_mm_storeu_ps(result.m[0], MultiplyRowSse(_mm_loadu_ps(m1.m[0]), row0, row1, row2, row3));
+	_mm_storeu_ps(result.m[1], MultiplyRowSse(_mm_loadu_ps(m1.m[1]), row0, row1, row2, row3));
+	_mm_storeu_ps(result.m[2], MultiplyRowSse(_mm_loadu_ps(m1.m[2]), row0, row1, row2, row3));
+	_mm_storeu_ps(result.m[3], MultiplyRowSse(_mm_loadu_ps(m1.m[3]), row0, row1, row2, row3));
+	return result;
+}
+
+// Multiply が MultiplySse を展開して使うか (起動時に CPU 判定して決める。MathSimd.cpp)
+// false はスカラー版のカーネルを選んだとき
+extern bool gMultiplySimd;
+
+// 積 (実行時に選ばれているカーネルを呼ぶ。Multiply から使う)
+Matrix4x4 MultiplyDispatch(const Matrix4x4& m1, const Matrix4x4& m2);
+
+// 積 (SIMD のカーネルなら SSE 版を展開して関数呼び出しなしで求める。定数式の中ではスカラー版)
+constexpr Matrix4x4 Multiply(const Matrix4x4& m1, const Matrix4x4& m2) {
+	if (std::is_constant_evaluated()) {
+		return MultiplyScalar(m1, m2);
+	}
+	if (gMultiplySimd) {
+		return MultiplySse(m1, m2);
+	}
+	return MultiplyDispatch(m1, m2);
+}
+
 // 拡大縮小行列
-Matrix4x4 MakeScaleMatrix(const Vector3& scale);
+template <typename T = float>
+constexpr Matrix4x4T<T> MakeScaleMatrix(const Vector3T<T>& scale) {
+	Matrix4x4T<T> result;
+
+	result.m[0][0] = scale.x;
+	result.m[0][1] = 0.0f;
+	result.m[0][2] = 0.0f;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = 0.0f;
+	result.m[1][1] = scale.y;
+	result.m[1][2] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = 0.0f;
+	result.m[2][1] = 0.0f;
+	result.m[2][2] = scale.z;
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = 0.0f;
+	result.m[3][1] = 0.0f;
+	result.m[3][2] = 0.0f;
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
+
 // 平行移動
-Matrix4x4 MakeTranslateMatrix(const Vector3& translate);
+template <typename T = float>
+constexpr Matrix4x4T<T> MakeTranslateMatrix(const Vector3T<T>& translate) {
+	Matrix4x4T<T> result;
+
+	result.m[0][0] = 1.0f;
+	result.m[0][1] = 0.0f;
+	result.m[0][2] = 0.0f;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = 0.0f;
+	result.m[1][1] = 1.0f;
+	result.m[1][2] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = 0.0f;
+	result.m[2][1] = 0.0f;
+	result.m[2][2] = 1.0f;
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
+
+// 単位行列
+template <typename T = float>
+constexpr Matrix4x4T<T> MakeIdentityMatrix() {
+	return {1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f, 0.0f, 0.0f,
+	        0.0f, 0.0f, 1.0f, 0.0f, 0.0f, 0.0f, 0.0f, 1.0f};
+}
 
 // ビューポート変換行列
-Matrix4x4 MakeViewportMatrix(
-    float left, float top, float width, float heght, float minDepth, float maxDepth);
+constexpr Matrix4x4 MakeViewportMatrix(
+    float left, float top, float width, float heght, float minDepth, float maxDepth) {
+	Matrix4x4 result;
+
+	result.m[0][0] = width / 2.0f;
+	result.m[0][1] = 0.0f;
+	result.m[0][2] = 0.0f;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = 0.0f;
+	result.m[1][1] = -heght / 2.0f;
+	result.m[1][2] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = 0.0f;
+	result.m[2][1] = 0.0f;
+	result.m[2][2] = maxDepth - minDepth;
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = left + width / 2.0f;
+	result.m[3][1] = top + heght / 2.0f;
+	result.m[3][2] = minDepth;
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
+
+// 正射影行列
+constexpr Matrix4x4 MakeOrthographicMatrix(
+    float left, float top, float right, float bottom, float nearClip, float farClip) {
+	Matrix4x4 result;
+
+	result.m[0][0] = 2.0f / (right - left);
+	result.m[0][1] = 0.0f;
+	result.m[0][2] = 0.0f;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = 0.0f;
+	result.m[1][1] = 2.0f / (top - bottom);
+	result.m[1][2] = 0.0f;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = 0.0f;
+	result.m[2][1] = 0.0f;
+	result.m[2][2] = 1.0f / (farClip - nearClip);
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = (left + right) / (left - right);
+	result.m[3][1] = (top + bottom) / (bottom - top);
+	result.m[3][2] = nearClip / (nearClip - farClip);
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
+
+// 変換 (スカラー版。SIMD 版の基準)
+template <typename T = float>
+constexpr Vector3T<T> TransformScalar(const Vector3T<T>& vector, const Matrix4x4T<T>& matrix) {
+	Vector3T<T> result;
+	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] +
+	           1.0f * matrix.m[3][0];
+	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] +
+	           1.0f * matrix.m[3][1];
+	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] +
+	           1.0f * matrix.m[3][2];
+	T w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] +
+	      1.0f * matrix.m[3][3];
+	assert(w != 0.0f);
+	result.x /= w;
+	result.y /= w;
+	result.z /= w;
+
+	return result;
+}
+
+// 変換 (実行時に CPU に合わせた SIMD 版を呼ぶ。Transform から使う)
+Vector3 TransformDispatch(const Vector3& vector, const Matrix4x4& matrix);
+
+// 変換 (CPU に合わせて SIMD 版を使う。定数式の中ではスカラー版)
+constexpr Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix) {
+	if (std::is_constant_evaluated()) {
+		return TransformScalar(vector, matrix);
+	}
+	return TransformDispatch(vector, matrix);
+}
+
+// 同次座標への変換 (w 除算なし。クリップしてから除算するときに使う)
+template <typename T = float>
+constexpr Vector4T<T> TransformHomogeneous(
+    const Vector3T<T>& vector, const Matrix4x4T<T>& matrix) {
+	Vector4T<T> result;
+	result.x = vector.x * matrix.m[0][0] + vector.y * matrix.m[1][0] + vector.z * matrix.m[2][0] +
+	           matrix.m[3][0];
+	result.y = vector.x * matrix.m[0][1] + vector.y * matrix.m[1][1] + vector.z * matrix.m[2][1] +
+	           matrix.m[3][1];
+	result.z = vector.x * matrix.m[0][2] + vector.y * matrix.m[1][2] + vector.z * matrix.m[2][2] +
+	           matrix.m[3][2];
+	result.w = vector.x * matrix.m[0][3] + vector.y * matrix.m[1][3] + vector.z * matrix.m[2][3] +
+	           matrix.m[3][3];
+	return result;
+}
+
+// 逆行列 (アフィン変換用。スカラー版)
+template <typename T = float>
+constexpr Matrix4x4T<T> InverseAffineScalar(const Matrix4x4T<T>& m) {
+	Matrix4x4T<T> result;
+
+	// 3x3 部分の逆行列 (各列 = 2 行ずつのクロス積 / 行列式)
+	Vector3T<T> row0 = {m.m[0][0], m.m[0][1], m.m[0][2]};
+	Vector3T<T> row1 = {m.m[1][0], m.m[1][1], m.m[1][2]};
+	Vector3T<T> row2 = {m.m[2][0], m.m[2][1], m.m[2][2]};
+	Vector3T<T> column0 = Cross(row1, row2);
+	Vector3T<T> column1 = Cross(row2, row0);
+	Vector3T<T> column2 = Cross(row0, row1);
+	T determinant = Dot(row0, column0);
+	assert(determinant != 0.0f);
+	T a = T(1) / determinant;
+
+	result.m[0][0] = column0.x * a;
+	result.m[0][1] = column1.x * a;
+	result.m[0][2] = column2.x * a;
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = column0.y * a;
+	result.m[1][1] = column1.y * a;
+	result.m[1][2] = column2.y * a;
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = column0.z * a;
+	result.m[2][1] = column1.z * a;
+	result.m[2][2] = column2.z * a;
+	result.m[2][3] = 0.0f;
+
+	// 平行移動は -t * (3x3 の逆行列)
+	const T* t = m.m[3];
+	result.m[3][0] = -(t[0] * result.m[0][0] + t[1] * result.m[1][0] + t[2] * result.m[2][0]);
+	result.m[3][1] = -(t[0] * result.m[0][1] + t[1] * result.m[1][1] + t[2] * result.m[2][1]);
+	result.m[3][2] = -(t[0] * result.m[0][2] + t[1] * result.m[1][2] + t[2] * result.m[2][2]);
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
+
+// 逆行列 (回転 + 平行移動のみ用。スカラー版)
+template <typename T = float>
+constexpr Matrix4x4T<T> InverseRigidScalar(const Matrix4x4T<T>& m) {
+	Matrix4x4T<T> result;
+
+	// 回転部分は転置
+	result.m[0][0] = m.m[0][0];
+	result.m[0][1] = m.m[1][0];
+	result.m[0][2] = m.m[2][0];
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = m.m[0][1];
+	result.m[1][1] = m.m[1][1];
+	result.m[1][2] = m.m[2][1];
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = m.m[0][2];
+	result.m[2][1] = m.m[1][2];
+	result.m[2][2] = m.m[2][2];
+	result.m[2][3] = 0.0f;
+
+	// 平行移動は -t * 転置 = 各回転行と t の内積
+	const T* t = m.m[3];
+	result.m[3][0] = -(t[0] * m.m[0][0] + t[1] * m.m[0][1] + t[2] * m.m[0][2]);
+	result.m[3][1] = -(t[0] * m.m[1][0] + t[1] * m.m[1][1] + t[2] * m.m[1][2]);
+	result.m[3][2] = -(t[0] * m.m[2][0] + t[1] * m.m[2][1] + t[2] * m.m[2][2]);
+	result.m[3][3] = 1.0f;
+
+	return result;
+}
 
 /*---------------------------------
  回転行列
@@ -32,45 +429,53 @@ Matrix4x4 MakeRotateYMatrix(float radian);
 // Z軸
 Matrix4x4 MakeRotateZMatrix(float radian);
 
-// アフィン変換
+// アフィン変換 (Scale * RotateX * RotateY * RotateZ * Translate を行列の積なしで直接作る)
 Matrix4x4 MakeAffineMatrix(const Vector3& scale, const Vector3& rot, const Vector3& translate);
+// アフィン変換 (配列の一括作成。results は count 個分確保しておくこと)
+void MakeAffineMatrices(
+    const Vector3* scales, const Vector3* rotates, const Vector3* translates,
+    Matrix4x4* results, size_t count);
 
 // 透視投影行列
 Matrix4x4 MakePerspectiveFovMatrix(float fovY, float aspectRatio, float nearClip, float farClip);
 
-// 正射影行列
-Matrix4x4 MakeOrthographicMatrix(
-    float left, float top, float right, float bottom, float nearClip, float farClip);
-
-// 逆行列
+// 逆行列 (CPU に合わせて SIMD 版を使う)
 Matrix4x4 Inverse(const Matrix4x4& m);
+// 逆行列 (スカラー版。SIMD 版の基準)
+Matrix4x4 InverseScalar(const Matrix4x4& m);
+// 逆行列 (特異なら result を変えずに false を返す。CPU に合わせて SIMD 版を使う)
+bool TryInverse(const Matrix4x4& m, Matrix4x4& result);
+// 逆行列 (特異なら false。スカラー版)
+bool TryInverseScalar(const Matrix4x4& m, Matrix4x4& result);
+// 逆行列 (アフィン変換用。4 列目が (0, 0, 0, 1) の行列に限る)
+// CPU に合わせて SIMD 版を使う
+Matrix4x4 InverseAffine(const Matrix4x4& m);
+// 逆行列 (回転 + 平行移動のみの行列用。スケールが入っていると正しくない)
+// CPU に合わせて SIMD 版を使う
+Matrix4x4 InverseRigid(const Matrix4x4& m);
 
-// 単位行列
-Matrix4x4 MakeIdentityMatrix();
+// 配列の積 (results[i] = m1[i] * m2[i]。results は m1, m2 と同じ配列でもよい)
+// 1 回の呼び出しでまとめて求めるので、積をたくさん求めるときは Multiply を繰り返すより速い
+void MultiplyArray(const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count);
+// 配列の積 (スカラー版。SIMD 版の基準)
+void MultiplyArrayScalar(
+    const Matrix4x4* m1, const Matrix4x4* m2, Matrix4x4* results, size_t count);
 
-// 変換
-Vector3 Transform(const Vector3& vector, const Matrix4x4& matrix);
+// 配列の一括変換 (w 除算込み)
+// ビュープロジェクション行列とビューポート行列を掛けておけば screen 座標まで 1 回で変換できる
+// w が 0 になる点は assert せず inf になるので、呼び出し側で除外しておくこと
+void TransformArray(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix);
+// 配列の一括変換 (スカラー版。SIMD 版の基準)
+void TransformArrayScalar(
+    const Vector3* vectors, Vector3* results, size_t count, const Matrix4x4& matrix);
+
+// 同次座標への配列の一括変換 (w 除算なし)
+void TransformArrayHomogeneous(
+    const Vector3* vectors, Vector4* results, size_t count, const Matrix4x4& matrix);
 
 // ノルム
 float Length(const Vector3& v);
 
-// ベクトル減算
-Vector3 Vec3Subtract(const Vector3& v1, const Vector3& v2);
-
-// スカラー倍
-Vector3 Vec3Multiply(float scalar, const Vector3& v);
-
-// 正規化
+// 正規化 (長さ 0 のベクトルは 0 ベクトルを返す)
 Vector3 Normalize(const Vector3& v);
-
-// クロス積
-Vector3 Cross(const Vector3& v1, const Vector3& v2);
-
-// 加算
-Vector3 Vec3Add(const Vector3& v1, const Vector3& v2);
-
-// 減算
-Vector3 Vec3Subtract(const Vector3& v1, const Vector3& v2);
-
-// 内積
-float Dot(const Vector3& v1, const Vector3& v2);
\ No newline at end of file
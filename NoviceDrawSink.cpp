@@ -0,0 +1,23 @@
+﻿#include "NoviceDrawSink.h"
+#include <Novice.h>
+
+void NoviceDrawSink::DrawLine(int x1, int y1, int x2, int y2, uint32_t color) {
+	Novice::DrawLine(x1, y1, x2, y2, color);
+}
+
+void NoviceDrawSink::DrawLines(const ScreenLine* lines, size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		const ScreenLine& line = lines[i];
+		Novice::DrawLine(line.x1, line.y1, line.x2, line.y2, line.color);
+	}
+}
+
+void NoviceDrawSink::DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) {
+	for (size_t i = 1; i < count; ++i) {
+		Novice::DrawLine(points[i - 1].x, points[i - 1].y, points[i].x, points[i].y, color);
+	}
+}
+
+void NoviceDrawSink::PrintText(int x, int y, const char* text) {
+	Novice::ScreenPrintf(x, y, "%s", text);
+}
@@ -0,0 +1,12 @@
+﻿#pragma once
+#include "DrawSink.h"
+
+// Novice のウィンドウに描画する
+class NoviceDrawSink : public DrawSink {
+public:
+	void DrawLine(int x1, int y1, int x2, int y2, uint32_t color) override;
+	// Novice にまとめて渡す口はないので、仮想呼び出しなしで Novice::DrawLine を続けて呼ぶ
+	void DrawLines(const ScreenLine* lines, size_t count) override;
+	void DrawLineStrip(const ScreenPoint* points, size_t count, uint32_t color) override;
+	void PrintText(int x, int y, const char* text) override;
+};
@@ -0,0 +1,88 @@
+﻿#include "ParallelLineBuffer.h"
+#include <algorithm>
+#include <cassert>
+
+void ParallelLineBuffer::Reset(uint32_t workerCount) {
+	workers_.resize(workerCount);
+	for (WorkerBuffer& worker : workers_) {
+		worker.lines.clear();
+		worker.stripPoints.clear();
+		worker.strips.clear();
+		worker.spans.clear();
+	}
+}
+
+void ParallelLineBuffer::BeginChunk(uint32_t workerIndex, size_t chunkIndex) {
+	assert(workerIndex < workers_.size());
+	WorkerBuffer& worker = workers_[workerIndex];
+	size_t begin = worker.lines.size();
+	size_t stripBegin = worker.strips.size();
+	worker.spans.push_back({chunkIndex, workerIndex, begin, begin, stripBegin, stripBegin});
+}
+
+void ParallelLineBuffer::AddStrip(
+    uint32_t workerIndex, const ScreenPoint* points, size_t count, uint32_t color) {
+	if (count < 2) {
+		return;
+	}
+	WorkerBuffer& worker = workers_[workerIndex];
+	worker.stripPoints.insert(worker.stripPoints.end(), points, points + count);
+	worker.strips.push_back({uint32_t(worker.stripPoints.size()), color});
+}
+
+void ParallelLineBuffer::MergeSpans() {
+	// 各チャンクの終わりは次のチャンクの始まり (最後はバッファの末尾)
+	merged_.clear();
+	for (WorkerBuffer& worker : workers_) {
+		for (size_t i = 0; i < worker.spans.size(); ++i) {
+			Span span = worker.spans[i];
+			bool last = i + 1 == worker.spans.size();
+			span.end = last ? worker.lines.size() : worker.spans[i + 1].begin;
+			span.stripEnd = last ? worker.strips.size() : worker.spans[i + 1].stripBegin;
+			merged_.push_back(span);
+		}
+	}
+	std::sort(merged_.begin(), merged_.end(), [](const Span& a, const Span& b) {
+		return a.chunkIndex < b.chunkIndex;
+	});
+}
+
+void ParallelLineBuffer::Submit(DrawSink& sink) {
+	MergeSpans();
+	for (const Span& span : merged_) {
+		const WorkerBuffer& worker = workers_[span.workerIndex];
+		if (span.end > span.begin) {
+			sink.DrawLines(worker.lines.data() + span.begin, span.end - span.begin);
+		}
+		for (size_t i = span.stripBegin; i < span.stripEnd; ++i) {
+			uint32_t begin = GetStripBegin(worker, i);
+			sink.DrawLineStrip(
+			    &worker.stripPoints[begin], worker.strips[i].end - begin, worker.strips[i].color);
+		}
+	}
+}
+
+void ParallelLineBuffer::Submit(FrameVector<ScreenLine>& lines) {
+	MergeSpans();
+	lines.Reserve(lines.Size() + GetLineCount());
+	for (const Span& span : merged_) {
+		const WorkerBuffer& worker = workers_[span.workerIndex];
+		lines.Append(worker.lines.data() + span.begin, span.end - span.begin);
+		for (size_t i = span.stripBegin; i < span.stripEnd; ++i) {
+			const Strip& strip = worker.strips[i];
+			for (uint32_t point = GetStripBegin(worker, i) + 1; point < strip.end; ++point) {
+				const ScreenPoint& sp = worker.stripPoints[point - 1];
+				const ScreenPoint& ep = worker.stripPoints[point];
+				lines.PushBack({sp.x, sp.y, ep.x, ep.y, strip.color});
+			}
+		}
+	}
+}
+
+size_t ParallelLineBuffer::GetLineCount() const {
+	size_t count = 0;
+	for (const WorkerBuffer& worker : workers_) {
+		count += worker.lines.size() + worker.stripPoints.size() - worker.strips.size();
+	}
+	return count;
+}
@@ -0,0 +1,80 @@
+﻿#pragma once
+#include "DrawSink.h"
+#include "FrameArena.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ 並列に線を集めるバッファ
+ ・ワーカーごとの線バッファに書き、Submit でチャンク番号順に並べ直して描画先へ出す
+ ・線分と折れ線を受け取れる。チャンクごとに線分を DrawLines でまとめて出してから折れ線を出す
+ ・スレッド数やどのワーカーがどのチャンクを処理したかに関係なく、出る線の順番は同じ
+------------------------------------*/
+class ParallelLineBuffer {
+public:
+	// ワーカー数を決めて空にする (容量は残す)
+	void Reset(uint32_t workerCount);
+
+	// チャンクを始める (以降の AddLine はこのチャンクの線になる)
+	void BeginChunk(uint32_t workerIndex, size_t chunkIndex);
+
+	// 線を追加する
+	void AddLine(uint32_t workerIndex, const ScreenLine& line) {
+		workers_[workerIndex].lines.push_back(line);
+	}
+
+	// 折れ線を追加する (points は count 個)
+	void AddStrip(uint32_t workerIndex, const ScreenPoint* points, size_t count, uint32_t color);
+
+	// チャンク番号順に sink へ出す (並列処理がすべて終わってから呼ぶこと)
+	void Submit(DrawSink& sink);
+	// チャンク番号順に lines の末尾へ足す (折れ線は 1 本ずつの線にする)
+	void Submit(FrameVector<ScreenLine>& lines);
+
+	// 溜まっている線の数 (折れ線は 1 本ずつ数える)
+	size_t GetLineCount() const;
+
+private:
+	// チャンク番号順に並べたチャンクを merged_ に作る
+	void MergeSpans();
+
+	// ワーカーのバッファの中のチャンク 1 つ分 (線分と折れ線の範囲)
+	struct Span {
+		size_t chunkIndex;
+		uint32_t workerIndex;
+		size_t begin;
+		size_t end;
+		size_t stripBegin;
+		size_t stripEnd;
+	};
+
+	// 折れ線 1 本 (点は前の折れ線の end から end まで)
+	struct Strip {
+		uint32_t end;
+		uint32_t color;
+	};
+
+	// 隣のワーカーとキャッシュラインを共有しないようにする
+#if defined(_MSC_VER)
+#pragma warning(push)
+#pragma warning(disable : 4324) // alignas で後ろを詰めたという警告 (詰めるのが目的)
+#endif
+	struct alignas(64) WorkerBuffer {
+		std::vector<ScreenLine> lines;
+		std::vector<ScreenPoint> stripPoints;
+		std::vector<Strip> strips;
+		std::vector<Span> spans;
+	};
+#if defined(_MSC_VER)
+#pragma warning(pop)
+#endif
+
+	// strips[index] の最初の点
+	static uint32_t GetStripBegin(const WorkerBuffer& worker, size_t index) {
+		return index > 0 ? worker.strips[index - 1].end : 0;
+	}
+
+	std::vector<WorkerBuffer> workers_;
+	std::vector<Span> merged_;
+};
@@ -0,0 +1,169 @@
+﻿#include "Profiler.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <memory>
+#include <mutex>
+
+#if PROFILER_ENABLED
+
+namespace {
+
+// スレッドごとのリングバッファの大きさ (2 の累乗)
+const uint64_t kRingSize = uint64_t(1) << 14;
+
+// 書くのは持ち主のスレッドだけ。読むのはフレームの区切りで、並列処理が止まっているとき
+struct ThreadBuffer {
+	ProfileEvent events[kRingSize];
+	// これまでに書いた数 (書いた場所は writeCount % kRingSize)
+	std::atomic<uint64_t> writeCount{0};
+	uint32_t threadIndex = 0;
+	uint32_t depth = 0;
+};
+
+// 全スレッドのバッファ (スレッドが終わっても残す)
+std::mutex gBuffersMutex;
+std::vector<std::unique_ptr<ThreadBuffer>> gBuffers;
+
+thread_local ThreadBuffer* tBuffer = nullptr;
+
+ThreadBuffer& GetThreadBuffer() {
+	if (!tBuffer) {
+		std::lock_guard<std::mutex> lock(gBuffersMutex);
+		gBuffers.push_back(std::make_unique<ThreadBuffer>());
+		tBuffer = gBuffers.back().get();
+		tBuffer->threadIndex = uint32_t(gBuffers.size() - 1);
+	}
+	return *tBuffer;
+}
+
+// tick と steady_clock の対応 (最初のフレームを基準にする)
+bool gHasBase = false;
+uint64_t gBaseTicks = 0;
+std::chrono::steady_clock::time_point gBaseTime;
+double gTicksPerMicrosecond = 1.0;
+
+uint64_t gFrameStart = 0;
+uint64_t gLastFrameStart = 0;
+uint64_t gLastFrameEnd = 0;
+std::vector<ProfileEvent> gFrameEvents;
+
+// 残っている区間のうち [from, to] に収まるものを events に足す
+void CollectEvents(uint64_t from, uint64_t to, std::vector<ProfileEvent>& events) {
+	std::lock_guard<std::mutex> lock(gBuffersMutex);
+	for (const std::unique_ptr<ThreadBuffer>& buffer : gBuffers) {
+		uint64_t count = buffer->writeCount.load(std::memory_order_acquire);
+		uint64_t first = count > kRingSize ? count - kRingSize : 0;
+		for (uint64_t i = first; i < count; ++i) {
+			const ProfileEvent& event = buffer->events[i & (kRingSize - 1)];
+			if (event.start >= from && event.end <= to) {
+				events.push_back(event);
+			}
+		}
+	}
+	std::sort(events.begin(), events.end(), [](const ProfileEvent& a, const ProfileEvent& b) {
+		if (a.threadIndex != b.threadIndex) {
+			return a.threadIndex < b.threadIndex;
+		}
+		return a.start < b.start || (a.start == b.start && a.depth < b.depth);
+	});
+}
+
+} // namespace
+
+ProfileScope::ProfileScope(const char* name) : name_(name) {
+	ThreadBuffer& buffer = GetThreadBuffer();
+	depth_ = buffer.depth++;
+	start_ = ReadProfileTicks();
+}
+
+ProfileScope::~ProfileScope() {
+	uint64_t end = ReadProfileTicks();
+	ThreadBuffer& buffer = *tBuffer;
+	--buffer.depth;
+	uint64_t count = buffer.writeCount.load(std::memory_order_relaxed);
+	buffer.events[count & (kRingSize - 1)] = {name_, start_, end, buffer.threadIndex, depth_};
+	buffer.writeCount.store(count + 1, std::memory_order_release);
+}
+
+void BeginProfileFrame() {
+	gFrameStart = ReadProfileTicks();
+	if (!gHasBase) {
+		gHasBase = true;
+		gBaseTicks = gFrameStart;
+		gBaseTime = std::chrono::steady_clock::now();
+	}
+}
+
+void EndProfileFrame() {
+	uint64_t frameEnd = ReadProfileTicks();
+
+	// 起動してからの経過時間で割るので、フレームが進むほど正確になる
+	double elapsedUs = std::chrono::duration<double, std::micro>(
+	                       std::chrono::steady_clock::now() - gBaseTime)
+	                       .count();
+	if (elapsedUs > 1000.0) {
+		gTicksPerMicrosecond = double(frameEnd - gBaseTicks) / elapsedUs;
+	}
+
+	gLastFrameStart = gFrameStart;
+	gLastFrameEnd = frameEnd;
+	// 容量は残るので、区間の数が落ち着けば確保しない
+	gFrameEvents.clear();
+	CollectEvents(gLastFrameStart, gLastFrameEnd, gFrameEvents);
+}
+
+const std::vector<ProfileEvent>& GetProfileFrameEvents() { return gFrameEvents; }
+uint64_t GetProfileFrameStart() { return gLastFrameStart; }
+uint64_t GetProfileFrameEnd() { return gLastFrameEnd; }
+double GetProfileTicksPerMicrosecond() { return gTicksPerMicrosecond; }
+
+bool WriteChromeTrace(const char* path) {
+	std::vector<ProfileEvent> events;
+	CollectEvents(0, UINT64_MAX, events);
+
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	if (fopen_s(&file, path, "w") != 0) {
+		file = nullptr;
+	}
+#else
+	file = std::fopen(path, "w");
+#endif
+	if (!file) {
+		return false;
+	}
+	// "X" は開始と長さを持つ区間。時刻はマイクロ秒
+	// 名前は文字列リテラルなのでエスケープしない
+	std::fprintf(file, "{\"displayTimeUnit\": \"ms\", \"traceEvents\": [\n");
+	for (size_t i = 0; i < events.size(); ++i) {
+		const ProfileEvent& event = events[i];
+		double start = double(int64_t(event.start - gBaseTicks)) / gTicksPerMicrosecond;
+		double duration = double(event.end - event.start) / gTicksPerMicrosecond;
+		std::fprintf(
+		    file,
+		    "  {\"name\": \"%s\", \"ph\": \"X\", \"ts\": %.3f, \"dur\": %.3f, \"pid\": 1, "
+		    "\"tid\": %u}%s\n",
+		    event.name, start, duration, event.threadIndex, i + 1 < events.size() ? "," : "");
+	}
+	std::fprintf(file, "]}\n");
+	std::fclose(file);
+	return true;
+}
+
+#else
+
+void BeginProfileFrame() {}
+void EndProfileFrame() {}
+
+const std::vector<ProfileEvent>& GetProfileFrameEvents() {
+	static const std::vector<ProfileEvent> kEmpty;
+	return kEmpty;
+}
+uint64_t GetProfileFrameStart() { return 0; }
+uint64_t GetProfileFrameEnd() { return 0; }
+double GetProfileTicksPerMicrosecond() { return 1.0; }
+
+bool WriteChromeTrace(const char*) { return false; }
+
+#endif
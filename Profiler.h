@@ -0,0 +1,91 @@
+﻿#pragma once
+#include <chrono>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+#if defined(_M_X64) || defined(__x86_64__)
+#if defined(_MSC_VER)
+#include <intrin.h>
+#else
+#include <x86intrin.h>
+#endif
+#endif
+
+// プロファイラを使うか (Debug では使う。Release でも計りたいときはプロジェクトで 1 を定義する)
+#if !defined(PROFILER_ENABLED)
+#if defined(_DEBUG)
+#define PROFILER_ENABLED 1
+#else
+#define PROFILER_ENABLED 0
+#endif
+#endif
+
+/*---------------------------------
+ プロファイラ
+ ・PROFILE_SCOPE("名前") を置いたブロックの開始と終了の時刻を記録する
+ ・記録はスレッドごとのリングバッファに書くのでロックを取らない (古いものから上書きされる)
+ ・BeginProfileFrame / EndProfileFrame で 1 フレーム分を取り出し、ImGui の表示に使う
+ ・PROFILER_ENABLED が 0 なら PROFILE_SCOPE は何も生成しない
+------------------------------------*/
+
+// 記録した区間
+struct ProfileEvent {
+	const char* name; // 文字列リテラル (ポインタだけ持つ)
+	uint64_t start;   // ReadProfileTicks の値
+	uint64_t end;
+	uint32_t threadIndex; // 初めて記録した順に 0, 1, 2, ...
+	uint32_t depth;       // 入れ子の深さ (0 が一番外)
+};
+
+// 時刻 (x64 は rdtsc、それ以外は steady_clock のナノ秒)
+inline uint64_t ReadProfileTicks() {
+#if defined(_M_X64) || defined(__x86_64__)
+	return __rdtsc();
+#else
+	return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+	                    std::chrono::steady_clock::now().time_since_epoch())
+	                    .count());
+#endif
+}
+
+#if PROFILER_ENABLED
+
+// ブロックを抜けるときに区間を記録する
+class ProfileScope {
+public:
+	explicit ProfileScope(const char* name);
+	~ProfileScope();
+	ProfileScope(const ProfileScope&) = delete;
+	ProfileScope& operator=(const ProfileScope&) = delete;
+
+private:
+	const char* name_;
+	uint64_t start_;
+	uint32_t depth_;
+};
+
+#define PROFILE_CONCAT_INNER(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_INNER(a, b)
+#define PROFILE_SCOPE(name) ProfileScope PROFILE_CONCAT(profileScope, __LINE__)(name)
+
+#else
+
+#define PROFILE_SCOPE(name) ((void)0)
+
+#endif
+
+// フレームの始まりと終わり (メインスレッドから、並列処理が動いていないときに呼ぶ)
+void BeginProfileFrame();
+void EndProfileFrame();
+
+// 直前に終わったフレームの区間 (スレッド番号順、その中は開始時刻順)
+const std::vector<ProfileEvent>& GetProfileFrameEvents();
+// 直前に終わったフレームの開始と終了の時刻
+uint64_t GetProfileFrameStart();
+uint64_t GetProfileFrameEnd();
+// 1 マイクロ秒あたりの tick 数 (steady_clock と比べて求める)
+double GetProfileTicksPerMicrosecond();
+
+// リングバッファに残っている区間をすべて Chrome のトレース形式で書き出す
+// (chrome://tracing や Perfetto で開ける)
+bool WriteChromeTrace(const char* path);
@@ -0,0 +1,95 @@
+﻿#include "ProfilerWindow.h"
+#include "Profiler.h"
+#include <cstdio>
+#include <imgui.h>
+
+#if PROFILER_ENABLED
+
+// 名前ごとに決まった色 (同じ名前は毎フレーム同じ色になる)
+static ImU32 GetEventColor(const char* name) {
+	// 文字列リテラルのアドレスは変わらないので、そのまま混ぜて使う
+	uint64_t hash = uint64_t(reinterpret_cast<uintptr_t>(name)) * 0x9E3779B97F4A7C15ull;
+	uint32_t r = 80 + uint32_t((hash >> 40) & 0x7F);
+	uint32_t g = 80 + uint32_t((hash >> 48) & 0x7F);
+	uint32_t b = 80 + uint32_t((hash >> 56) & 0x7F);
+	return IM_COL32(r, g, b, 255);
+}
+
+void DrawProfilerWindow() {
+	ImGui::Begin("Profiler");
+
+	const std::vector<ProfileEvent>& events = GetProfileFrameEvents();
+	const double ticksPerMicrosecond = GetProfileTicksPerMicrosecond();
+	const uint64_t frameStart = GetProfileFrameStart();
+	const uint64_t frameEnd = GetProfileFrameEnd();
+	const double frameTicks = frameEnd > frameStart ? double(frameEnd - frameStart) : 1.0;
+
+	ImGui::Text(
+	    "frame %.3f ms  events %d", frameTicks / ticksPerMicrosecond / 1000.0, int(events.size()));
+	ImGui::SameLine();
+	if (ImGui::Button("Export Chrome trace")) {
+		WriteChromeTrace("profile.json");
+	}
+
+	ImDrawList* drawList = ImGui::GetWindowDrawList();
+	const ImVec2 origin = ImGui::GetCursorScreenPos();
+	const float width = ImGui::GetContentRegionAvail().x;
+	const float kRowHeight = 18.0f;
+	const ImU32 kTextColor = IM_COL32(255, 255, 255, 255);
+	float y = origin.y;
+
+	// スレッドごとに 1 段落
+	size_t begin = 0;
+	while (begin < events.size()) {
+		uint32_t threadIndex = events[begin].threadIndex;
+		size_t end = begin;
+		uint32_t maxDepth = 0;
+		while (end < events.size() && events[end].threadIndex == threadIndex) {
+			maxDepth = events[end].depth > maxDepth ? events[end].depth : maxDepth;
+			++end;
+		}
+
+		char label[32];
+		snprintf(label, sizeof(label), "thread %u", threadIndex);
+		drawList->AddText(ImVec2(origin.x, y), kTextColor, label);
+		y += kRowHeight;
+
+		for (size_t i = begin; i < end; ++i) {
+			const ProfileEvent& event = events[i];
+			float x0 = origin.x + width * float(double(event.start - frameStart) / frameTicks);
+			float x1 = origin.x + width * float(double(event.end - frameStart) / frameTicks);
+			// 短すぎる区間も 1 ピクセルは描く
+			x1 = x1 < x0 + 1.0f ? x0 + 1.0f : x1;
+			float y0 = y + float(event.depth) * kRowHeight;
+			ImVec2 min(x0, y0);
+			ImVec2 max(x1, y0 + kRowHeight - 1.0f);
+			drawList->AddRectFilled(min, max, GetEventColor(event.name));
+			if (x1 - x0 > 30.0f) {
+				drawList->PushClipRect(min, max, true);
+				drawList->AddText(ImVec2(x0 + 2.0f, y0), kTextColor, event.name);
+				drawList->PopClipRect();
+			}
+			if (ImGui::IsMouseHoveringRect(min, max)) {
+				ImGui::SetTooltip(
+				    "%s\n%.3f us", event.name,
+				    double(event.end - event.start) / ticksPerMicrosecond);
+			}
+		}
+		y += float(maxDepth + 1) * kRowHeight + 4.0f;
+		begin = end;
+	}
+
+	// 描いた分だけウィンドウの中身を広げる
+	ImGui::Dummy(ImVec2(width, y - origin.y));
+	ImGui::End();
+}
+
+#else
+
+void DrawProfilerWindow() {
+	ImGui::Begin("Profiler");
+	ImGui::Text("Profiler is disabled (define PROFILER_ENABLED=1)");
+	ImGui::End();
+}
+
+#endif
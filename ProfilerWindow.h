@@ -0,0 +1,8 @@
+﻿#pragma once
+
+/*---------------------------------
+ プロファイラの ImGui 表示
+ ・直前のフレームの区間をスレッドごとに横に並べる (横が時間、縦が入れ子の深さ)
+ ・区間にカーソルを合わせると名前と時間を出す
+------------------------------------*/
+void DrawProfilerWindow();
@@ -0,0 +1,230 @@
+﻿#include "Quaternion.h"
+#include "FastMath.h"
+#include "MathSimd.h"
+#include "Profiler.h"
+#include <cmath>
+#include <immintrin.h>
+
+// ヘッダーの constexpr 関数がコンパイル時に計算できることの確認
+static_assert(Multiply(MakeIdentityQuaternion(), MakeIdentityQuaternion()).w == 1.0f);
+static_assert(MakeRotateMatrix(MakeIdentityQuaternion()).m[1][1] == 1.0f);
+
+// ノルム
+float Norm(const Quaternion& q) { return std::sqrt(Dot(q, q)); }
+
+// 正規化
+Quaternion Normalize(const Quaternion& q) {
+	float norm = Norm(q);
+	assert(norm != 0.0f);
+	float a = 1.0f / norm;
+	return {q.x * a, q.y * a, q.z * a, q.w * a};
+}
+
+// 任意軸回転
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle) {
+	float s;
+	float c;
+	SinCos(angle * 0.5f, s, c);
+	return {axis.x * s, axis.y * s, axis.z * s, c};
+}
+
+// オイラー角から
+Quaternion MakeEulerQuaternion(const Vector3& rotate) {
+	// 半角の sin, cos は 1 回ずつ
+	float sx;
+	float cx;
+	float sy;
+	float cy;
+	float sz;
+	float cz;
+	SinCos(rotate.x * 0.5f, sx, cx);
+	SinCos(rotate.y * 0.5f, sy, cy);
+	SinCos(rotate.z * 0.5f, sz, cz);
+
+	// Z * Y * X (X 軸から先に回す) を展開した形
+	Quaternion result;
+	result.x = cz * cy * sx - sz * sy * cx;
+	result.y = cz * sy * cx + sz * cy * sx;
+	result.z = sz * cy * cx - cz * sy * sx;
+	result.w = cz * cy * cx + sz * sy * sx;
+	return result;
+}
+
+// 球面線形補間
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	// q と -q は同じ回転なので、内積が負なら反転して近い方を通る
+	float dot = Dot(q0, q1);
+	float sign = dot < 0.0f ? -1.0f : 1.0f;
+	dot *= sign;
+
+	// ほぼ同じ向きなら sin が 0 に近く割れないので線形補間にする
+	const float kNearlyParallel = 0.9995f;
+	if (dot > kNearlyParallel) {
+		return Nlerp(q0, q1, t);
+	}
+	float theta = std::acos(dot);
+	float invSin = 1.0f / std::sin(theta);
+	float scale0 = std::sin((1.0f - t) * theta) * invSin;
+	float scale1 = std::sin(t * theta) * invSin * sign;
+	return {
+	    scale0 * q0.x + scale1 * q1.x, scale0 * q0.y + scale1 * q1.y,
+	    scale0 * q0.z + scale1 * q1.z, scale0 * q0.w + scale1 * q1.w};
+}
+
+// 線形補間して正規化
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t) {
+	float scale1 = Dot(q0, q1) < 0.0f ? -t : t;
+	float scale0 = 1.0f - t;
+	return Normalize(
+	    {scale0 * q0.x + scale1 * q1.x, scale0 * q0.y + scale1 * q1.y,
+	     scale0 * q0.z + scale1 * q1.z, scale0 * q0.w + scale1 * q1.w});
+}
+
+/*---------------------------------
+ SlerpFast
+ ・Nlerp は両端に比べて中ほどの角速度が速くなるので、t を 3 次式で補正してならす
+   t' = t + t(t - 0.5)(t - 1) * (A(t - 0.5)^2 + B)
+ ・A, B は 2 つのクォータニオンの内積 d の多項式 (Slerp に合うように当てはめた係数)
+------------------------------------*/
+
+namespace {
+
+// 補正した t
+inline float CorrectSlerpT(float t, float d) {
+	float a = 1.0904f + d * (-3.2452f + d * (3.55645f - d * 1.43519f));
+	float b = 0.848013f + d * (-1.06021f + d * 0.215638f);
+	float k = a * (t - 0.5f) * (t - 0.5f) + b;
+	return t + t * (t - 0.5f) * (t - 1.0f) * k;
+}
+
+void SlerpFastArrayScalar(
+    const Quaternion* q0s, const Quaternion* q1s, const float* ts, Quaternion* results,
+    size_t count) {
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = SlerpFast(q0s[i], q1s[i], ts[i]);
+	}
+}
+
+// 4 個のクォータニオン (各 128bit レーン) を x, y, z, w に並べ替える (逆変換も同じ)
+MATH_TARGET_AVX2 inline void Transpose4Avx2(__m256& r0, __m256& r1, __m256& r2, __m256& r3) {
+	__m256 t0 = _mm256_unpacklo_ps(r0, r1);
+	__m256 t1 = _mm256_unpacklo_ps(r2, r3);
+	__m256 t2 = _mm256_unpackhi_ps(r0, r1);
+	__m256 t3 = _mm256_unpackhi_ps(r2, r3);
+	r0 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(1, 0, 1, 0));
+	r1 = _mm256_shuffle_ps(t0, t1, _MM_SHUFFLE(3, 2, 3, 2));
+	r2 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(1, 0, 1, 0));
+	r3 = _mm256_shuffle_ps(t2, t3, _MM_SHUFFLE(3, 2, 3, 2));
+}
+
+// i 番と i + 4 番のクォータニオンを 1 レジスタに読む
+MATH_TARGET_AVX2 inline __m256 LoadQuaternionPairAvx2(const Quaternion* q) {
+	return _mm256_insertf128_ps(
+	    _mm256_castps128_ps256(_mm_loadu_ps(&q[0].x)), _mm_loadu_ps(&q[4].x), 1);
+}
+
+MATH_TARGET_AVX2 inline void StoreQuaternionPairAvx2(Quaternion* q, __m256 v) {
+	_mm_storeu_ps(&q[0].x, _mm256_castps256_ps128(v));
+	_mm_storeu_ps(&q[4].x, _mm256_extractf128_ps(v, 1));
+}
+
+// 8 個ずつ計算する
+MATH_TARGET_AVX2 void SlerpFastArrayAvx2(
+    const Quaternion* q0s, const Quaternion* q1s, const float* ts, Quaternion* results,
+    size_t count) {
+	const __m256 signMask = _mm256_set1_ps(-0.0f);
+	const __m256 half = _mm256_set1_ps(0.5f);
+	const __m256 one = _mm256_set1_ps(1.0f);
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 a[4];
+		__m256 b[4];
+		for (int lane = 0; lane < 4; ++lane) {
+			a[lane] = LoadQuaternionPairAvx2(q0s + i + lane);
+			b[lane] = LoadQuaternionPairAvx2(q1s + i + lane);
+		}
+		Transpose4Avx2(a[0], a[1], a[2], a[3]);
+		Transpose4Avx2(b[0], b[1], b[2], b[3]);
+
+		// 内積が負なら q1 を反転する
+		__m256 d = _mm256_mul_ps(a[0], b[0]);
+		d = _mm256_fmadd_ps(a[1], b[1], d);
+		d = _mm256_fmadd_ps(a[2], b[2], d);
+		d = _mm256_fmadd_ps(a[3], b[3], d);
+		__m256 sign = _mm256_and_ps(d, signMask);
+		d = _mm256_andnot_ps(signMask, d);
+
+		// t の補正 (CorrectSlerpT と同じ式)
+		__m256 t = _mm256_loadu_ps(ts + i);
+		__m256 ka = _mm256_fmadd_ps(d, _mm256_set1_ps(-1.43519f), _mm256_set1_ps(3.55645f));
+		ka = _mm256_fmadd_ps(d, ka, _mm256_set1_ps(-3.2452f));
+		ka = _mm256_fmadd_ps(d, ka, _mm256_set1_ps(1.0904f));
+		__m256 kb = _mm256_fmadd_ps(d, _mm256_set1_ps(0.215638f), _mm256_set1_ps(-1.06021f));
+		kb = _mm256_fmadd_ps(d, kb, _mm256_set1_ps(0.848013f));
+		__m256 centered = _mm256_sub_ps(t, half);
+		__m256 k = _mm256_fmadd_ps(_mm256_mul_ps(ka, centered), centered, kb);
+		__m256 cubic = _mm256_mul_ps(_mm256_mul_ps(t, centered), _mm256_sub_ps(t, one));
+		t = _mm256_fmadd_ps(cubic, k, t);
+
+		// q0 + t (q1 - q0) を正規化する
+		__m256 r[4];
+		__m256 normSquared = _mm256_setzero_ps();
+		for (int lane = 0; lane < 4; ++lane) {
+			__m256 target = _mm256_xor_ps(b[lane], sign);
+			r[lane] = _mm256_fmadd_ps(t, _mm256_sub_ps(target, a[lane]), a[lane]);
+			normSquared = _mm256_fmadd_ps(r[lane], r[lane], normSquared);
+		}
+		__m256 invNorm = _mm256_div_ps(one, _mm256_sqrt_ps(normSquared));
+		for (int lane = 0; lane < 4; ++lane) {
+			r[lane] = _mm256_mul_ps(r[lane], invNorm);
+		}
+
+		Transpose4Avx2(r[0], r[1], r[2], r[3]);
+		for (int lane = 0; lane < 4; ++lane) {
+			StoreQuaternionPairAvx2(results + i + lane, r[lane]);
+		}
+	}
+	SlerpFastArrayScalar(q0s + i, q1s + i, ts + i, results + i, count - i);
+}
+
+using SlerpFastArrayFunction = void (*)(
+    const Quaternion* q0s, const Quaternion* q1s, const float* ts, Quaternion* results,
+    size_t count);
+
+// SSE 環境ではスカラー版 (コンパイラの自動ベクトル化に任せる)
+SlerpFastArrayFunction GetSlerpFastArrayKernel() {
+	return HasAvx2Kernels() ? SlerpFastArrayAvx2 : SlerpFastArrayScalar;
+}
+
+} // namespace
+
+// 球面線形補間の近似
+Quaternion SlerpFast(const Quaternion& q0, const Quaternion& q1, float t) {
+	float dot = Dot(q0, q1);
+	float d = std::fabs(dot);
+	float scale1 = CorrectSlerpT(t, d);
+	float scale0 = 1.0f - scale1;
+	scale1 = dot < 0.0f ? -scale1 : scale1;
+	return Normalize(
+	    {scale0 * q0.x + scale1 * q1.x, scale0 * q0.y + scale1 * q1.y,
+	     scale0 * q0.z + scale1 * q1.z, scale0 * q0.w + scale1 * q1.w});
+}
+
+// SlerpFast の一括計算
+void SlerpFastArray(
+    const Quaternion* q0s, const Quaternion* q1s, const float* ts, Quaternion* results,
+    size_t count) {
+	PROFILE_SCOPE("SlerpFastArray");
+	GetSlerpFastArrayKernel()(q0s, q1s, ts, results, count);
+}
+
+// アフィン変換 (配列の一括作成)
+void MakeQuaternionAffineMatrices(
+    const Vector3* scales, const Quaternion* rotates, const Vector3* translates,
+    Matrix4x4* results, size_t count) {
+	PROFILE_SCOPE("MakeQuaternionAffineMatrices");
+	for (size_t i = 0; i < count; ++i) {
+		results[i] = MakeQuaternionAffineMatrix(scales[i], rotates[i], translates[i]);
+	}
+}
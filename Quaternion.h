@@ -0,0 +1,138 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cassert>
+#include <cstddef>
+
+/*---------------------------------
+ クォータニオン (回転)
+ ・x, y, z が虚部、w が実部。回転に使うときは長さ 1 にしておく
+ ・Multiply(q1, q2) は q2 の回転のあとに q1 の回転 (行列の Multiply とは順序が逆)
+   MakeRotateMatrix(Multiply(q1, q2)) == Multiply(MakeRotateMatrix(q2), MakeRotateMatrix(q1))
+ ・オイラー角と違って合成しても行列の積がいらず、ジンバルロックも起きない
+------------------------------------*/
+struct Quaternion {
+	float x;
+	float y;
+	float z;
+	float w;
+};
+
+// 単位クォータニオン (回転なし)
+constexpr Quaternion MakeIdentityQuaternion() { return {0.0f, 0.0f, 0.0f, 1.0f}; }
+
+// 積 (q2 の回転のあとに q1 の回転)
+constexpr Quaternion Multiply(const Quaternion& q1, const Quaternion& q2) {
+	Quaternion result;
+	result.x = q1.w * q2.x + q1.x * q2.w + q1.y * q2.z - q1.z * q2.y;
+	result.y = q1.w * q2.y - q1.x * q2.z + q1.y * q2.w + q1.z * q2.x;
+	result.z = q1.w * q2.z + q1.x * q2.y - q1.y * q2.x + q1.z * q2.w;
+	result.w = q1.w * q2.w - q1.x * q2.x - q1.y * q2.y - q1.z * q2.z;
+	return result;
+}
+
+// 共役 (長さ 1 なら逆回転)
+constexpr Quaternion Conjugate(const Quaternion& q) { return {-q.x, -q.y, -q.z, q.w}; }
+
+// 内積
+constexpr float Dot(const Quaternion& q1, const Quaternion& q2) {
+	return q1.x * q2.x + q1.y * q2.y + q1.z * q2.z + q1.w * q2.w;
+}
+
+// 逆クォータニオン
+constexpr Quaternion Inverse(const Quaternion& q) {
+	float normSquared = Dot(q, q);
+	assert(normSquared != 0.0f);
+	float a = 1.0f / normSquared;
+	return {-q.x * a, -q.y * a, -q.z * a, q.w * a};
+}
+
+// ベクトルを回転する (q は長さ 1)
+// v' = v + 2w(u x v) + 2u x (u x v)  (u は虚部)
+constexpr Vector3 RotateVector(const Vector3& vector, const Quaternion& q) {
+	Vector3 u = {q.x, q.y, q.z};
+	Vector3 uv = Cross(u, vector);
+	Vector3 uuv = Cross(u, uv);
+	return Vec3Add(vector, Vec3Add(Vec3Multiply(2.0f * q.w, uv), Vec3Multiply(2.0f, uuv)));
+}
+
+// 回転行列 (q は長さ 1)
+constexpr Matrix4x4 MakeRotateMatrix(const Quaternion& q) {
+	float xx = q.x * q.x;
+	float yy = q.y * q.y;
+	float zz = q.z * q.z;
+	float xy = q.x * q.y;
+	float xz = q.x * q.z;
+	float yz = q.y * q.z;
+	float wx = q.w * q.x;
+	float wy = q.w * q.y;
+	float wz = q.w * q.z;
+
+	Matrix4x4 result;
+	result.m[0][0] = 1.0f - 2.0f * (yy + zz);
+	result.m[0][1] = 2.0f * (xy + wz);
+	result.m[0][2] = 2.0f * (xz - wy);
+	result.m[0][3] = 0.0f;
+	result.m[1][0] = 2.0f * (xy - wz);
+	result.m[1][1] = 1.0f - 2.0f * (xx + zz);
+	result.m[1][2] = 2.0f * (yz + wx);
+	result.m[1][3] = 0.0f;
+	result.m[2][0] = 2.0f * (xz + wy);
+	result.m[2][1] = 2.0f * (yz - wx);
+	result.m[2][2] = 1.0f - 2.0f * (xx + yy);
+	result.m[2][3] = 0.0f;
+	result.m[3][0] = 0.0f;
+	result.m[3][1] = 0.0f;
+	result.m[3][2] = 0.0f;
+	result.m[3][3] = 1.0f;
+	return result;
+}
+
+// アフィン変換 (Scale * Rotate * Translate を行列の積なしで直接作る。rotate は長さ 1)
+// MakeAffineMatrix の回転をクォータニオンで渡す版
+constexpr Matrix4x4 MakeQuaternionAffineMatrix(
+    const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	Matrix4x4 result = MakeRotateMatrix(rotate);
+	// 回転部分の各行にそれぞれの軸のスケールが掛かる
+	for (int column = 0; column < 3; ++column) {
+		result.m[0][column] *= scale.x;
+		result.m[1][column] *= scale.y;
+		result.m[2][column] *= scale.z;
+	}
+	result.m[3][0] = translate.x;
+	result.m[3][1] = translate.y;
+	result.m[3][2] = translate.z;
+	return result;
+}
+
+// ノルム
+float Norm(const Quaternion& q);
+
+// 正規化
+Quaternion Normalize(const Quaternion& q);
+
+// 任意軸回転 (axis は長さ 1)
+Quaternion MakeRotateAxisAngleQuaternion(const Vector3& axis, float angle);
+
+// オイラー角から (MakeAffineMatrix と同じく X, Y, Z 軸の順に回す)
+Quaternion MakeEulerQuaternion(const Vector3& rotate);
+
+// 球面線形補間 (近い方の経路を通る。acos と sin を使う正確な版)
+Quaternion Slerp(const Quaternion& q0, const Quaternion& q1, float t);
+
+// 線形補間して正規化 (角速度は一定にならない)
+Quaternion Nlerp(const Quaternion& q0, const Quaternion& q1, float t);
+
+// 球面線形補間の近似 (t を 3 次式で補正した Nlerp。三角関数なし)
+// Slerp との角度の差は 1e-3 rad 以下 (内積 0 付近が最大で約 7.8e-4 rad。HeadlessCheck で確認)
+Quaternion SlerpFast(const Quaternion& q0, const Quaternion& q1, float t);
+
+// SlerpFast の一括計算 (キーフレーム補間用。results は count 個分確保しておくこと)
+// CPU に合わせて SIMD 版を使う。results に q0s や q1s と同じ配列を渡してもよい
+void SlerpFastArray(
+    const Quaternion* q0s, const Quaternion* q1s, const float* ts, Quaternion* results,
+    size_t count);
+
+// アフィン変換 (配列の一括作成。results は count 個分確保しておくこと)
+void MakeQuaternionAffineMatrices(
+    const Vector3* scales, const Quaternion* rotates, const Vector3* translates,
+    Matrix4x4* results, size_t count);
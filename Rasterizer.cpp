@@ -0,0 +1,270 @@
+﻿#include "Rasterizer.h"
+#include "DrawSink.h"
+#include "MathSimd.h"
+#include "Profiler.h"
+#include <algorithm>
+#include <cassert>
+#include <cmath>
+#include <immintrin.h>
+
+/*---------------------------------
+ 1 行分の描画 (x0 から x1 まで。x1 も含む)
+ ・AVX2 では 8 画素ずつ辺関数・深度を求め、3 辺の内側かつ手前の画素だけ書き換える
+ ・x1 より右は隣のタイル (別のスレッド) なので書かない
+------------------------------------*/
+
+namespace {
+
+// 画素の中心で辺関数が内側か
+inline bool IsInside(float e, bool includeEdge) { return e > 0.0f || (e == 0.0f && includeEdge); }
+
+void RasterizeSpanScalar(
+    const RasterTriangle& tri, int y, int x0, int x1, uint32_t* colors, float* depths) {
+	float py = float(y) + 0.5f;
+	for (int x = x0; x <= x1; ++x) {
+		float px = float(x) + 0.5f;
+		bool inside = true;
+		for (int edge = 0; edge < 3; ++edge) {
+			float e = tri.edgeA[edge] * px + tri.edgeB[edge] * py + tri.edgeC[edge];
+			inside = inside && IsInside(e, tri.includeEdge[edge]);
+		}
+		float z = tri.zA * px + tri.zB * py + tri.zC;
+		if (inside && z < depths[x]) {
+			depths[x] = z;
+			colors[x] = tri.color;
+		}
+	}
+}
+
+MATH_TARGET_AVX2 void RasterizeSpanAvx2(
+    const RasterTriangle& tri, int y, int x0, int x1, uint32_t* colors, float* depths) {
+	const __m256 laneOffsets = _mm256_setr_ps(0.5f, 1.5f, 2.5f, 3.5f, 4.5f, 5.5f, 6.5f, 7.5f);
+	const __m256i laneIndices = _mm256_setr_epi32(0, 1, 2, 3, 4, 5, 6, 7);
+	const __m256 zero = _mm256_setzero_ps();
+	float py = float(y) + 0.5f;
+
+	// 左端の 8 画素の値と、8 画素右へ進んだときの増分
+	__m256 px = _mm256_add_ps(_mm256_set1_ps(float(x0)), laneOffsets);
+	__m256 e[3];
+	__m256 eStep[3];
+	__m256 include[3];
+	for (int edge = 0; edge < 3; ++edge) {
+		__m256 a = _mm256_set1_ps(tri.edgeA[edge]);
+		e[edge] = _mm256_fmadd_ps(
+		    a, px, _mm256_set1_ps(tri.edgeB[edge] * py + tri.edgeC[edge]));
+		eStep[edge] = _mm256_set1_ps(tri.edgeA[edge] * 8.0f);
+		include[edge] = _mm256_castsi256_ps(_mm256_set1_epi32(tri.includeEdge[edge] ? -1 : 0));
+	}
+	__m256 z = _mm256_fmadd_ps(_mm256_set1_ps(tri.zA), px, _mm256_set1_ps(tri.zB * py + tri.zC));
+	__m256 zStep = _mm256_set1_ps(tri.zA * 8.0f);
+	__m256 color = _mm256_castsi256_ps(_mm256_set1_epi32(int(tri.color)));
+
+	for (int x = x0; x <= x1; x += 8) {
+		__m256 mask = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+		for (int edge = 0; edge < 3; ++edge) {
+			__m256 inside = _mm256_or_ps(
+			    _mm256_cmp_ps(e[edge], zero, _CMP_GT_OQ),
+			    _mm256_and_ps(_mm256_cmp_ps(e[edge], zero, _CMP_EQ_OQ), include[edge]));
+			mask = _mm256_and_ps(mask, inside);
+			e[edge] = _mm256_add_ps(e[edge], eStep[edge]);
+		}
+
+		if (x + 7 <= x1) {
+			__m256 oldDepth = _mm256_loadu_ps(depths + x);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, oldDepth, _CMP_LT_OQ));
+			if (_mm256_movemask_ps(mask) != 0) {
+				__m256 oldColor = _mm256_loadu_ps(reinterpret_cast<const float*>(colors + x));
+				_mm256_storeu_ps(depths + x, _mm256_blendv_ps(oldDepth, z, mask));
+				_mm256_storeu_ps(
+				    reinterpret_cast<float*>(colors + x), _mm256_blendv_ps(oldColor, color, mask));
+			}
+		} else {
+			// 右端の端数は範囲内のレーンだけ読み書きする
+			__m256i valid = _mm256_cmpgt_epi32(_mm256_set1_epi32(x1 - x + 1), laneIndices);
+			__m256 oldDepth = _mm256_maskload_ps(depths + x, valid);
+			mask = _mm256_and_ps(mask, _mm256_cmp_ps(z, oldDepth, _CMP_LT_OQ));
+			__m256i store = _mm256_and_si256(valid, _mm256_castps_si256(mask));
+			_mm256_maskstore_ps(depths + x, store, z);
+			_mm256_maskstore_ps(reinterpret_cast<float*>(colors + x), store, color);
+		}
+		z = _mm256_add_ps(z, zStep);
+	}
+}
+
+using RasterizeSpanFunction = void (*)(
+    const RasterTriangle& tri, int y, int x0, int x1, uint32_t* colors, float* depths);
+
+RasterizeSpanFunction GetRasterizeSpanKernel() {
+	return HasAvx2Kernels() ? RasterizeSpanAvx2 : RasterizeSpanScalar;
+}
+
+} // namespace
+
+Rasterizer::Rasterizer(int width, int height)
+    : width_(width), height_(height), tileCountX_((width + kTileSize - 1) / kTileSize),
+      tileCountY_((height + kTileSize - 1) / kTileSize), pixels_(size_t(width) * height),
+      depths_(size_t(width) * height) {
+	assert(width > 0 && height > 0);
+	bins_.resize(size_t(tileCountX_) * tileCountY_);
+	Clear(kColorBlack);
+}
+
+void Rasterizer::Clear(uint32_t color, float depth) {
+	std::fill(pixels_.begin(), pixels_.end(), color);
+	std::fill(depths_.begin(), depths_.end(), depth);
+}
+
+void Rasterizer::DrawTriangle(
+    const Vector3& v0, const Vector3& v1, const Vector3& v2, uint32_t color) {
+	// 符号付き面積の 2 倍 (screen は y が下向きなので時計回りが正)
+	float area = (v1.x - v0.x) * (v2.y - v0.y) - (v2.x - v0.x) * (v1.y - v0.y);
+	if (!(area > 0.0f) && (cullBackFaces_ || !(area < 0.0f))) {
+		// 裏向き・面積 0・NaN
+		return;
+	}
+	const Vector3* v[3] = {&v0, &v1, &v2};
+	if (area < 0.0f) {
+		// 両面描くときは裏向きを表向きに並べ替える
+		std::swap(v[1], v[2]);
+		area = -area;
+	}
+
+	// 画素の中心が入りうる範囲 (画面外の大きな座標は int にする前に切り詰める)
+	float minX = std::min({v0.x, v1.x, v2.x});
+	float maxX = std::max({v0.x, v1.x, v2.x});
+	float minY = std::min({v0.y, v1.y, v2.y});
+	float maxY = std::max({v0.y, v1.y, v2.y});
+	RasterTriangle tri;
+	tri.minX = int(std::ceil(std::max(minX, -1.0f) - 0.5f));
+	tri.maxX = int(std::floor(std::min(maxX, float(width_)) - 0.5f));
+	tri.minY = int(std::ceil(std::max(minY, -1.0f) - 0.5f));
+	tri.maxY = int(std::floor(std::min(maxY, float(height_)) - 0.5f));
+	tri.minX = std::max(tri.minX, 0);
+	tri.minY = std::max(tri.minY, 0);
+	tri.maxX = std::min(tri.maxX, width_ - 1);
+	tri.maxY = std::min(tri.maxY, height_ - 1);
+	if (tri.minX > tri.maxX || tri.minY > tri.maxY) {
+		return;
+	}
+
+	// 辺 i は v[i] から v[i + 1] へ。勾配 (a, b) は内側を向く
+	for (int edge = 0; edge < 3; ++edge) {
+		const Vector3& from = *v[edge];
+		const Vector3& to = *v[(edge + 1) % 3];
+		float a = from.y - to.y;
+		float b = to.x - from.x;
+		tri.edgeA[edge] = a;
+		tri.edgeB[edge] = b;
+		tri.edgeC[edge] = -(a * from.x + b * from.y);
+		// 左の辺 (内側が右) と、水平で内側が下の上の辺
+		tri.includeEdge[edge] = a > 0.0f || (a == 0.0f && b > 0.0f);
+	}
+
+	// 深度は screen 上で線形なので平面の式で求める
+	const Vector3& p0 = *v[0];
+	const Vector3& p1 = *v[1];
+	const Vector3& p2 = *v[2];
+	float invArea = 1.0f / area;
+	tri.zA = ((p1.z - p0.z) * (p2.y - p0.y) - (p2.z - p0.z) * (p1.y - p0.y)) * invArea;
+	tri.zB = ((p2.z - p0.z) * (p1.x - p0.x) - (p1.z - p0.z) * (p2.x - p0.x)) * invArea;
+	tri.zC = p0.z - tri.zA * p0.x - tri.zB * p0.y;
+	tri.color = color;
+
+	// 重なるタイルの箱に入れる (タイルの角で辺の外側とわかるものは入れない)
+	uint32_t index = uint32_t(triangles_.size());
+	bool binned = false;
+	int tileMinX = tri.minX / kTileSize;
+	int tileMaxX = tri.maxX / kTileSize;
+	int tileMinY = tri.minY / kTileSize;
+	int tileMaxY = tri.maxY / kTileSize;
+	for (int ty = tileMinY; ty <= tileMaxY; ++ty) {
+		float top = float(std::max(ty * kTileSize, tri.minY)) + 0.5f;
+		float bottom = float(std::min(ty * kTileSize + kTileSize - 1, tri.maxY)) + 0.5f;
+		for (int tx = tileMinX; tx <= tileMaxX; ++tx) {
+			float left = float(std::max(tx * kTileSize, tri.minX)) + 0.5f;
+			float right = float(std::min(tx * kTileSize + kTileSize - 1, tri.maxX)) + 0.5f;
+			bool outside = false;
+			for (int edge = 0; edge < 3 && !outside; ++edge) {
+				// 辺関数がいちばん大きくなる角
+				float x = tri.edgeA[edge] > 0.0f ? right : left;
+				float y = tri.edgeB[edge] > 0.0f ? bottom : top;
+				outside = tri.edgeA[edge] * x + tri.edgeB[edge] * y + tri.edgeC[edge] < 0.0f;
+			}
+			if (!outside) {
+				bins_[size_t(ty) * tileCountX_ + tx].push_back(index);
+				binned = true;
+			}
+		}
+	}
+	if (binned) {
+		triangles_.push_back(tri);
+	}
+}
+
+void Rasterizer::DrawTriangles(
+    const Vector3* vertices, const uint32_t* indices, size_t indexCount, uint32_t color) {
+	assert(indexCount % 3 == 0);
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		DrawTriangle(
+		    vertices[indices[i]], vertices[indices[i + 1]], vertices[indices[i + 2]], color);
+	}
+}
+
+void Rasterizer::DrawTriangles(
+    const ScreenPointFixed* points, const uint16_t* depths, const uint32_t* indices,
+    size_t indexCount, uint32_t color) {
+	assert(indexCount % 3 == 0);
+	for (size_t i = 0; i + 2 < indexCount; i += 3) {
+		Vector3 vertices[3];
+		for (int corner = 0; corner < 3; ++corner) {
+			uint32_t index = indices[i + corner];
+			vertices[corner] = {
+			    FixedToFloat(points[index].x), FixedToFloat(points[index].y),
+			    DecodeHalfDepth(depths[index])};
+		}
+		DrawTriangle(vertices[0], vertices[1], vertices[2], color);
+	}
+}
+
+void Rasterizer::RasterizeTile(size_t tileIndex) {
+	std::vector<uint32_t>& bin = bins_[tileIndex];
+	if (bin.empty()) {
+		return;
+	}
+	int tileX0 = int(tileIndex % tileCountX_) * kTileSize;
+	int tileY0 = int(tileIndex / tileCountX_) * kTileSize;
+	int tileX1 = std::min(tileX0 + kTileSize - 1, width_ - 1);
+	int tileY1 = std::min(tileY0 + kTileSize - 1, height_ - 1);
+
+	RasterizeSpanFunction rasterizeSpan = GetRasterizeSpanKernel();
+	for (uint32_t index : bin) {
+		const RasterTriangle& tri = triangles_[index];
+		int x0 = std::max(tri.minX, tileX0);
+		int x1 = std::min(tri.maxX, tileX1);
+		int y0 = std::max(tri.minY, tileY0);
+		int y1 = std::min(tri.maxY, tileY1);
+		for (int y = y0; y <= y1; ++y) {
+			size_t row = size_t(y) * width_;
+			rasterizeSpan(tri, y, x0, x1, pixels_.data() + row, depths_.data() + row);
+		}
+	}
+	bin.clear();
+}
+
+void Rasterizer::Flush() {
+	PROFILE_SCOPE("Rasterize");
+	for (size_t tile = 0; tile < bins_.size(); ++tile) {
+		RasterizeTile(tile);
+	}
+	triangles_.clear();
+}
+
+void Rasterizer::Flush(JobSystem& jobSystem) {
+	PROFILE_SCOPE("Rasterize");
+	jobSystem.ParallelFor(bins_.size(), 1, [this](size_t begin, size_t end, uint32_t) {
+		for (size_t tile = begin; tile < end; ++tile) {
+			RasterizeTile(tile);
+		}
+	});
+	triangles_.clear();
+}
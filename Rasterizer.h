@@ -0,0 +1,90 @@
+﻿#pragma once
+#include "JobSystem.h"
+#include "Mathfunction.h"
+#include "ScreenVertex.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ 三角形のソフトウェアラスタライザ (GPU なしで塗りつぶしの画像を作る)
+ ・頂点は screen 座標 (TransformArray にビュープロジェクション * ビューポート行列を渡した出力)
+   x, y は画素、z は MakeViewportMatrix の minDepth〜maxDepth の深度
+ ・DrawTriangle は三角形を画面のタイルごとの箱に振り分けるだけで、Flush でまとめて描く
+ ・タイルごとに独立しているので、Flush(JobSystem&) はタイルを並列に描く
+   同じタイルの三角形は積んだ順に描くので、並列でも結果は同じ
+ ・画素の中心 (x + 0.5, y + 0.5) を辺関数で判定し、辺の上は左上ルールで片方だけに含める
+ ・深度は小さいほど手前 (深度が同じなら先に描いたものが残る)
+------------------------------------*/
+// 描く準備を済ませた三角形 (Rasterizer の中で使う)
+struct RasterTriangle {
+	// 辺関数 E(x, y) = a * x + b * y + c (内側が正)
+	float edgeA[3];
+	float edgeB[3];
+	float edgeC[3];
+	// 辺の上の画素を含めるか (左上ルール)
+	bool includeEdge[3];
+	// 深度の平面 z = zA * x + zB * y + zC
+	float zA;
+	float zB;
+	float zC;
+	// 画面内に切り詰めた範囲 (画素、max も含む)
+	int minX;
+	int minY;
+	int maxX;
+	int maxY;
+	uint32_t color;
+};
+
+class Rasterizer {
+public:
+	// タイルの一辺の画素数
+	static const int kTileSize = 64;
+
+	Rasterizer(int width, int height);
+
+	// 色と深度を塗りつぶす
+	void Clear(uint32_t color, float depth = 1.0f);
+
+	// 裏向き (screen 上で反時計回り) の三角形を描かない (初期値は true)
+	void SetCullBackFaces(bool cullBackFaces) { cullBackFaces_ = cullBackFaces; }
+
+	// 三角形を積む (表は screen 上で時計回り)
+	void DrawTriangle(const Vector3& v0, const Vector3& v1, const Vector3& v2, uint32_t color);
+	// 番号付きの三角形をまとめて積む (indices は 3 個で 1 枚)
+	void DrawTriangles(
+	    const Vector3* vertices, const uint32_t* indices, size_t indexCount, uint32_t color);
+	// 詰めた形式 (16.16 の座標と fp16 の深度の列) から読む版
+	void DrawTriangles(
+	    const ScreenPointFixed* points, const uint16_t* depths, const uint32_t* indices,
+	    size_t indexCount, uint32_t color);
+
+	// 積んだ三角形を描く
+	void Flush();
+	void Flush(JobSystem& jobSystem);
+
+	int GetWidth() const { return width_; }
+	int GetHeight() const { return height_; }
+	// 1 画素 RGBA (Novice と同じ並び)、width x height
+	const std::vector<uint32_t>& GetPixels() const { return pixels_; }
+	const std::vector<float>& GetDepths() const { return depths_; }
+	uint32_t GetPixel(int x, int y) const { return pixels_[size_t(y) * width_ + x]; }
+	float GetDepth(int x, int y) const { return depths_[size_t(y) * width_ + x]; }
+	// 積んだまま Flush していない三角形の数
+	size_t GetPendingTriangleCount() const { return triangles_.size(); }
+
+private:
+	// タイル 1 枚を描く
+	void RasterizeTile(size_t tileIndex);
+
+	int width_;
+	int height_;
+	int tileCountX_;
+	int tileCountY_;
+	bool cullBackFaces_ = true;
+	std::vector<uint32_t> pixels_;
+	std::vector<float> depths_;
+	std::vector<RasterTriangle> triangles_;
+	// タイルごとの三角形の番号 (積んだ順)
+	std::vector<std::vector<uint32_t>> bins_;
+};
@@ -0,0 +1,73 @@
+﻿#include "SceneFile.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+
+/*---------------------------------
+ シーンの変換ツール
+ ・テキストのシーンを読んで、メモリマップで読めるバイナリのシーンファイルを書き出す
+ ・使い方: SceneConverter 入力.txt 出力.scene
+ ・書き出した後に SceneFile で開き直して確かめる
+------------------------------------*/
+
+namespace {
+
+// ファイルをすべて読む
+bool ReadFile(const char* path, std::vector<char>& text) {
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	if (fopen_s(&file, path, "rb") != 0) {
+		file = nullptr;
+	}
+#else
+	file = std::fopen(path, "rb");
+#endif
+	if (!file) {
+		return false;
+	}
+	char buffer[64 * 1024];
+	size_t read;
+	while ((read = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+		text.insert(text.end(), buffer, buffer + read);
+	}
+	bool ok = std::ferror(file) == 0;
+	std::fclose(file);
+	return ok;
+}
+
+} // namespace
+
+int main(int argc, char** argv) {
+	if (argc != 3) {
+		std::fprintf(stderr, "usage: %s INPUT.txt OUTPUT.scene\n", argv[0]);
+		return 1;
+	}
+	const char* inputPath = argv[1];
+	const char* outputPath = argv[2];
+
+	std::vector<char> text;
+	if (!ReadFile(inputPath, text)) {
+		std::fprintf(stderr, "cannot read %s\n", inputPath);
+		return 1;
+	}
+	SceneData scene;
+	std::string error;
+	if (!ParseSceneText(text.data(), text.size(), scene, error)) {
+		std::fprintf(stderr, "%s: %s\n", inputPath, error.c_str());
+		return 1;
+	}
+	if (!WriteSceneFile(outputPath, scene, error)) {
+		std::fprintf(stderr, "%s\n", error.c_str());
+		return 1;
+	}
+
+	SceneFile file;
+	if (!file.Open(outputPath)) {
+		std::fprintf(stderr, "%s\n", file.GetError().c_str());
+		return 1;
+	}
+	std::printf(
+	    "%s: %zu spheres, %zu transforms\n", outputPath, file.GetSphereCount(),
+	    file.GetTransformCount());
+	return 0;
+}
@@ -0,0 +1,304 @@
+﻿#include "SceneFile.h"
+#include "Profiler.h"
+#include <cassert>
+#include <charconv>
+#include <cmath>
+#include <cstdio>
+#include <cstring>
+#include <string_view>
+#if defined(_WIN32)
+#define WIN32_LEAN_AND_MEAN
+#define NOMINMAX
+#include <Windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+namespace {
+
+// 要素 1 つの大きさ
+const uint64_t kSectionElementSizes[kSceneSectionCount] = {
+    sizeof(Vector3), sizeof(float), sizeof(Vector3), sizeof(Vector3), sizeof(Vector3)};
+
+uint64_t AlignUp(uint64_t value) {
+	return (value + kSceneFileAlignment - 1) / kSceneFileAlignment * kSceneFileAlignment;
+}
+
+// 配列ごとの要素数
+uint64_t GetSectionCount(const SceneFileHeader& header, uint32_t section) {
+	return section <= uint32_t(SceneSection::kSphereRadii) ? header.sphereCount
+	                                                         : header.transformCount;
+}
+
+bool IsSpace(char c) { return c == ' ' || c == '\t' || c == '\r'; }
+
+// 1 行を空白で区切って読む
+class LineReader {
+public:
+	LineReader(const char* begin, const char* end) : p_(begin), end_(end) {}
+
+	// 次の語 (なければ空)
+	std::string_view NextWord() {
+		while (p_ < end_ && IsSpace(*p_)) {
+			++p_;
+		}
+		const char* begin = p_;
+		while (p_ < end_ && !IsSpace(*p_)) {
+			++p_;
+		}
+		return {begin, size_t(p_ - begin)};
+	}
+
+	bool ReadFloat(float& value) {
+		std::string_view word = NextWord();
+		const char* last = word.data() + word.size();
+		std::from_chars_result result = std::from_chars(word.data(), last, value);
+		return result.ec == std::errc() && result.ptr == last && std::isfinite(value);
+	}
+
+	bool ReadVector3(Vector3& v) { return ReadFloat(v.x) && ReadFloat(v.y) && ReadFloat(v.z); }
+
+private:
+	const char* p_;
+	const char* end_;
+};
+
+bool WriteBytes(FILE* file, const void* data, uint64_t size) {
+	return size == 0 || std::fwrite(data, 1, size_t(size), file) == size;
+}
+
+} // namespace
+
+bool ParseSceneText(const char* text, size_t size, SceneData& scene, std::string& error) {
+	const char* end = text + size;
+	int lineNumber = 0;
+	for (const char* line = text; line < end;) {
+		++lineNumber;
+		const char* lineEnd = static_cast<const char*>(std::memchr(line, '\n', size_t(end - line)));
+		if (!lineEnd) {
+			lineEnd = end;
+		}
+		// コメントを外す
+		const char* comment =
+		    static_cast<const char*>(std::memchr(line, '#', size_t(lineEnd - line)));
+		LineReader reader(line, comment ? comment : lineEnd);
+		line = lineEnd + 1;
+
+		std::string_view keyword = reader.NextWord();
+		if (keyword.empty()) {
+			continue;
+		}
+		bool ok = false;
+		if (keyword == "sphere") {
+			Vector3 center;
+			float radius;
+			ok = reader.ReadVector3(center) && reader.ReadFloat(radius) && radius >= 0.0f;
+			if (ok) {
+				scene.sphereCenters.push_back(center);
+				scene.sphereRadii.push_back(radius);
+			}
+		} else if (keyword == "transform") {
+			Vector3 scale;
+			Vector3 rotate;
+			Vector3 translate;
+			ok = reader.ReadVector3(scale) && reader.ReadVector3(rotate) &&
+			     reader.ReadVector3(translate);
+			if (ok) {
+				scene.transformScales.push_back(scale);
+				scene.transformRotates.push_back(rotate);
+				scene.transformTranslates.push_back(translate);
+			}
+		} else {
+			error = "line " + std::to_string(lineNumber) + ": unknown kind " + std::string(keyword);
+			return false;
+		}
+		// 数が足りない・多い・数でない
+		if (!ok || !reader.NextWord().empty()) {
+			error = "line " + std::to_string(lineNumber) + ": invalid " + std::string(keyword);
+			return false;
+		}
+	}
+	return true;
+}
+
+bool WriteSceneFile(const char* path, const SceneData& scene, std::string& error) {
+	assert(scene.sphereCenters.size() == scene.sphereRadii.size());
+	assert(scene.transformScales.size() == scene.transformRotates.size());
+	assert(scene.transformScales.size() == scene.transformTranslates.size());
+	const void* sections[kSceneSectionCount] = {
+	    scene.sphereCenters.data(), scene.sphereRadii.data(), scene.transformScales.data(),
+	    scene.transformRotates.data(), scene.transformTranslates.data()};
+
+	// 配列をヘッダーの後ろに境界を揃えて並べる
+	SceneFileHeader header{};
+	std::memcpy(header.magic, kSceneFileMagic, sizeof(header.magic));
+	header.version = kSceneFileVersion;
+	header.headerSize = sizeof(SceneFileHeader);
+	header.sectionCount = kSceneSectionCount;
+	header.sphereCount = scene.sphereCenters.size();
+	header.transformCount = scene.transformScales.size();
+	uint64_t offset = AlignUp(sizeof(SceneFileHeader));
+	for (uint32_t i = 0; i < kSceneSectionCount; ++i) {
+		header.sections[i].offset = offset;
+		header.sections[i].size = GetSectionCount(header, i) * kSectionElementSizes[i];
+		offset = AlignUp(offset + header.sections[i].size);
+	}
+	header.fileSize = offset;
+
+	FILE* file = nullptr;
+#if defined(_MSC_VER)
+	if (fopen_s(&file, path, "wb") != 0) {
+		file = nullptr;
+	}
+#else
+	file = std::fopen(path, "wb");
+#endif
+	if (!file) {
+		error = std::string("cannot open ") + path;
+		return false;
+	}
+	static const char kPadding[kSceneFileAlignment] = {};
+	bool ok = WriteBytes(file, &header, sizeof(header));
+	uint64_t written = sizeof(header);
+	for (uint32_t i = 0; i < kSceneSectionCount && ok; ++i) {
+		ok = WriteBytes(file, kPadding, header.sections[i].offset - written) &&
+		     WriteBytes(file, sections[i], header.sections[i].size);
+		written = header.sections[i].offset + header.sections[i].size;
+	}
+	ok = ok && WriteBytes(file, kPadding, header.fileSize - written);
+	ok = std::fclose(file) == 0 && ok;
+	if (!ok) {
+		error = std::string("cannot write ") + path;
+	}
+	return ok;
+}
+
+bool SceneFile::Open(const char* path) {
+	PROFILE_SCOPE("SceneFile::Open");
+	Close();
+
+#if defined(_WIN32)
+	HANDLE file = CreateFileA(
+	    path, GENERIC_READ, FILE_SHARE_READ, nullptr, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL,
+	    nullptr);
+	if (file == INVALID_HANDLE_VALUE) {
+		error_ = std::string("cannot open ") + path;
+		return false;
+	}
+	file_ = file;
+	LARGE_INTEGER fileSize;
+	if (!GetFileSizeEx(file, &fileSize) || fileSize.QuadPart < LONGLONG(sizeof(SceneFileHeader))) {
+		error_ = std::string("not a scene file: ") + path;
+		Unmap();
+		return false;
+	}
+	mappedSize_ = size_t(fileSize.QuadPart);
+	mapping_ = CreateFileMappingA(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+	if (mapping_) {
+		data_ = static_cast<const std::byte*>(MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0));
+	}
+	if (!data_) {
+		error_ = std::string("cannot map ") + path;
+		Unmap();
+		return false;
+	}
+#else
+	int file = open(path, O_RDONLY);
+	if (file < 0) {
+		error_ = std::string("cannot open ") + path;
+		return false;
+	}
+	struct stat status;
+	if (fstat(file, &status) != 0 || status.st_size < off_t(sizeof(SceneFileHeader))) {
+		error_ = std::string("not a scene file: ") + path;
+		close(file);
+		return false;
+	}
+	mappedSize_ = size_t(status.st_size);
+	// マップした後はファイルを閉じてよい
+	void* data = mmap(nullptr, mappedSize_, PROT_READ, MAP_PRIVATE, file, 0);
+	close(file);
+	if (data == MAP_FAILED) {
+		error_ = std::string("cannot map ") + path;
+		return false;
+	}
+	data_ = static_cast<const std::byte*>(data);
+#endif
+
+	header_ = reinterpret_cast<const SceneFileHeader*>(data_);
+	if (!Validate(mappedSize_)) {
+		error_ += std::string(": ") + path;
+		Unmap();
+		return false;
+	}
+
+	// 配列を使い始める前に OS にまとめて読み込ませる (要素ごとの変換はしない)
+#if defined(_WIN32)
+	WIN32_MEMORY_RANGE_ENTRY range{const_cast<std::byte*>(data_), mappedSize_};
+	PrefetchVirtualMemory(GetCurrentProcess(), 1, &range, 0);
+#else
+	madvise(const_cast<std::byte*>(data_), mappedSize_, MADV_WILLNEED);
+#endif
+	return true;
+}
+
+bool SceneFile::Validate(uint64_t fileSize) {
+	const SceneFileHeader& header = *header_;
+	if (std::memcmp(header.magic, kSceneFileMagic, sizeof(header.magic)) != 0) {
+		error_ = "not a scene file";
+		return false;
+	}
+	if (header.version != kSceneFileVersion || header.headerSize != sizeof(SceneFileHeader) ||
+	    header.sectionCount != kSceneSectionCount) {
+		error_ = "unsupported version " + std::to_string(header.version);
+		return false;
+	}
+	if (header.fileSize != fileSize) {
+		error_ = "truncated file";
+		return false;
+	}
+	for (uint32_t i = 0; i < kSceneSectionCount; ++i) {
+		const SceneFileSection& section = header.sections[i];
+		// 要素数から求めた大きさと一致し、ファイルに収まり、境界が揃っていること
+		// (要素数がファイルより大きいものは先に外し、掛け算があふれないようにする)
+		uint64_t count = GetSectionCount(header, i);
+		if (count > fileSize || section.size != count * kSectionElementSizes[i] ||
+		    section.offset % kSceneFileAlignment != 0 || section.offset < sizeof(header) ||
+		    section.offset > fileSize || section.size > fileSize - section.offset) {
+			error_ = "invalid section " + std::to_string(i);
+			return false;
+		}
+	}
+	return true;
+}
+
+void SceneFile::Close() {
+	Unmap();
+	error_.clear();
+}
+
+void SceneFile::Unmap() {
+#if defined(_WIN32)
+	if (data_) {
+		UnmapViewOfFile(data_);
+	}
+	if (mapping_) {
+		CloseHandle(mapping_);
+	}
+	if (file_) {
+		CloseHandle(file_);
+	}
+#else
+	if (data_) {
+		munmap(const_cast<std::byte*>(data_), mappedSize_);
+	}
+#endif
+	data_ = nullptr;
+	header_ = nullptr;
+	mappedSize_ = 0;
+	file_ = nullptr;
+	mapping_ = nullptr;
+}
@@ -0,0 +1,136 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <bit>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+/*---------------------------------
+ シーンファイル (バイナリ)
+ ・球 (中心・半径) とトランスフォーム (スケール・回転・平行移動) を属性ごとの配列で持つ
+ ・各配列は 64byte 境界に置くので、メモリマップしたまま Vector3 / float の配列として使える
+   (読み込み時に要素ごとの変換や確保をしない。起動時間はページインだけで決まる)
+ ・リトルエンディアン固定。形式を変えたら kSceneFileVersion を上げる
+ ・テキストからは SceneConverter で作る
+------------------------------------*/
+
+static_assert(std::endian::native == std::endian::little, "シーンファイルはリトルエンディアンのまま読む");
+
+// ファイル先頭の識別子と形式の版
+const char kSceneFileMagic[4] = {'S', 'C', 'N', 'B'};
+const uint32_t kSceneFileVersion = 1;
+// 各配列の先頭の境界 (Vector3Soa と同じ)
+const uint64_t kSceneFileAlignment = 64;
+
+// 配列の種類 (ヘッダーの sections の並び)
+enum class SceneSection : uint32_t {
+	kSphereCenters,      // Vector3 x 球の数
+	kSphereRadii,        // float x 球の数
+	kTransformScales,    // Vector3 x トランスフォームの数
+	kTransformRotates,   // Vector3 x トランスフォームの数 (オイラー角、ラジアン)
+	kTransformTranslates, // Vector3 x トランスフォームの数
+	kCount,
+};
+const uint32_t kSceneSectionCount = uint32_t(SceneSection::kCount);
+
+// 配列の位置 (ファイル先頭からのバイト数) と大きさ
+struct SceneFileSection {
+	uint64_t offset;
+	uint64_t size;
+};
+
+// ファイル先頭のヘッダー
+struct SceneFileHeader {
+	char magic[4];
+	uint32_t version;
+	// sizeof(SceneFileHeader)
+	uint32_t headerSize;
+	uint32_t sectionCount;
+	uint64_t fileSize;
+	uint64_t sphereCount;
+	uint64_t transformCount;
+	SceneFileSection sections[kSceneSectionCount];
+};
+static_assert(sizeof(SceneFileHeader) == 40 + 16 * kSceneSectionCount, "詰め物が入ると形式が変わる");
+static_assert(sizeof(Vector3) == 12, "Vector3 の配列をそのまま書く");
+
+/*---------------------------------
+ シーンの中身 (書き出し用、変換ツールで使う)
+------------------------------------*/
+struct SceneData {
+	std::vector<Vector3> sphereCenters;
+	std::vector<float> sphereRadii;
+	std::vector<Vector3> transformScales;
+	std::vector<Vector3> transformRotates;
+	std::vector<Vector3> transformTranslates;
+};
+
+// テキストを読む (失敗したら false を返し、error に行番号と理由を入れる)
+// 1 行 1 つで、# から行末まではコメント
+//   sphere    中心x 中心y 中心z 半径
+//   transform スケールxyz 回転xyz 平行移動xyz
+bool ParseSceneText(const char* text, size_t size, SceneData& scene, std::string& error);
+
+// バイナリで書き出す (失敗したら false を返し、error に理由を入れる)
+bool WriteSceneFile(const char* path, const SceneData& scene, std::string& error);
+
+/*---------------------------------
+ シーンファイルの読み込み
+ ・ファイルを読み取り専用でメモリマップし、ヘッダーと配列の範囲だけ確かめる
+ ・Get で返す配列はマップした領域を直接指す (Close するまで使える)
+------------------------------------*/
+class SceneFile {
+public:
+	SceneFile() = default;
+	SceneFile(const SceneFile&) = delete;
+	SceneFile& operator=(const SceneFile&) = delete;
+	~SceneFile() { Close(); }
+
+	// 開く (失敗したら false。理由は GetError)
+	bool Open(const char* path);
+	void Close();
+
+	bool IsOpen() const { return data_ != nullptr; }
+	const std::string& GetError() const { return error_; }
+
+	size_t GetSphereCount() const { return header_ ? size_t(header_->sphereCount) : 0; }
+	const Vector3* GetSphereCenters() const {
+		return GetSection<Vector3>(SceneSection::kSphereCenters);
+	}
+	const float* GetSphereRadii() const { return GetSection<float>(SceneSection::kSphereRadii); }
+
+	size_t GetTransformCount() const { return header_ ? size_t(header_->transformCount) : 0; }
+	const Vector3* GetTransformScales() const {
+		return GetSection<Vector3>(SceneSection::kTransformScales);
+	}
+	const Vector3* GetTransformRotates() const {
+		return GetSection<Vector3>(SceneSection::kTransformRotates);
+	}
+	const Vector3* GetTransformTranslates() const {
+		return GetSection<Vector3>(SceneSection::kTransformTranslates);
+	}
+
+private:
+	// 開いていなければ nullptr
+	template<typename T>
+	const T* GetSection(SceneSection section) const {
+		if (!header_) {
+			return nullptr;
+		}
+		return reinterpret_cast<const T*>(data_ + header_->sections[uint32_t(section)].offset);
+	}
+
+	// ヘッダーと配列の範囲を確かめる
+	bool Validate(uint64_t fileSize);
+	// マップを外す (error_ は残す)
+	void Unmap();
+
+	const std::byte* data_ = nullptr;
+	const SceneFileHeader* header_ = nullptr;
+	size_t mappedSize_ = 0;
+	// OS のハンドル (Windows のみ。ファイルとマッピング)
+	void* file_ = nullptr;
+	void* mapping_ = nullptr;
+	std::string error_;
+};
@@ -0,0 +1,259 @@
+﻿#include "ScreenVertex.h"
+#include "MathSimd.h"
+#include "Profiler.h"
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+
+namespace {
+
+// x, y が表せる画素の範囲 (16.16 でも int16 でも収まる)
+constexpr float kMinCoordinate = -32768.0f;
+constexpr float kMaxCoordinate = 32767.0f;
+
+// 表せる範囲に寄せる (NaN は最小値にする)
+inline float ClampCoordinate(float value, bool& inRange) {
+	if (value >= kMinCoordinate && value <= kMaxCoordinate) {
+		return value;
+	}
+	inRange = false;
+	return value > kMaxCoordinate ? kMaxCoordinate : kMinCoordinate;
+}
+
+// screen までの変換 (TransformArrayScalar と同じ計算)
+inline Vector3 ProjectScalar(const Vector3& v, const Matrix4x4& matrix) {
+	float x = v.x * matrix.m[0][0] + v.y * matrix.m[1][0] + v.z * matrix.m[2][0] + matrix.m[3][0];
+	float y = v.x * matrix.m[0][1] + v.y * matrix.m[1][1] + v.z * matrix.m[2][1] + matrix.m[3][1];
+	float z = v.x * matrix.m[0][2] + v.y * matrix.m[1][2] + v.z * matrix.m[2][2] + matrix.m[3][2];
+	float w = v.x * matrix.m[0][3] + v.y * matrix.m[1][3] + v.z * matrix.m[2][3] + matrix.m[3][3];
+	float invW = 1.0f / w;
+	return {x * invW, y * invW, z * invW};
+}
+
+bool TransformArrayToScreenFixedScalar(
+    const Vector3* vectors, ScreenPointFixed* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	bool inRange = true;
+	for (size_t i = 0; i < count; ++i) {
+		Vector3 screen = ProjectScalar(vectors[i], matrix);
+		float x = ClampCoordinate(screen.x, inRange);
+		float y = ClampCoordinate(screen.y, inRange);
+		points[i] = {
+		    int32_t(std::nearbyint(x * float(kFixedOne))),
+		    int32_t(std::nearbyint(y * float(kFixedOne)))};
+		if (depths) {
+			depths[i] = FloatToHalf(1.0f - screen.z);
+		}
+	}
+	return inRange;
+}
+
+bool TransformArrayToScreen16Scalar(
+    const Vector3* vectors, ScreenPoint16* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	bool inRange = true;
+	for (size_t i = 0; i < count; ++i) {
+		Vector3 screen = ProjectScalar(vectors[i], matrix);
+		points[i] = {
+		    int16_t(ClampCoordinate(screen.x, inRange)),
+		    int16_t(ClampCoordinate(screen.y, inRange))};
+		if (depths) {
+			depths[i] = FloatToHalf(1.0f - screen.z);
+		}
+	}
+	return inRange;
+}
+
+/*---------------------------------
+ AVX2 (8 点ずつ)
+------------------------------------*/
+
+// 行列の各要素を 8 レーンに広げる
+MATH_TARGET_AVX2 inline void BroadcastMatrixAvx2(const Matrix4x4& matrix, __m256 (&m)[4][4]) {
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			m[row][column] = _mm256_set1_ps(matrix.m[row][column]);
+		}
+	}
+}
+
+// 8 点を読んで screen まで変換する (読み込みの並べ替えは TransformArrayAvx2 と同じ)
+MATH_TARGET_AVX2 inline void ProjectAvx2(
+    const Vector3* vectors, const __m256 (&m)[4][4], __m256& x, __m256& y, __m256& z) {
+	const float* src = &vectors[0].x;
+	__m256 m0 = _mm256_loadu_ps(src);
+	__m256 m1 = _mm256_loadu_ps(src + 8);
+	__m256 m2 = _mm256_loadu_ps(src + 16);
+	__m256 a = _mm256_permute2f128_ps(m0, m1, 0x30);
+	__m256 b = _mm256_permute2f128_ps(m0, m2, 0x21);
+	__m256 c = _mm256_permute2f128_ps(m1, m2, 0x30);
+	x = _mm256_shuffle_ps(
+	    a, _mm256_shuffle_ps(b, c, _MM_SHUFFLE(1, 1, 2, 2)), _MM_SHUFFLE(2, 0, 3, 0));
+	y = _mm256_shuffle_ps(
+	    _mm256_shuffle_ps(a, b, _MM_SHUFFLE(0, 0, 1, 1)),
+	    _mm256_shuffle_ps(b, c, _MM_SHUFFLE(2, 2, 3, 3)), _MM_SHUFFLE(2, 0, 2, 0));
+	z = _mm256_shuffle_ps(
+	    _mm256_shuffle_ps(a, b, _MM_SHUFFLE(1, 1, 2, 2)),
+	    _mm256_shuffle_ps(c, c, _MM_SHUFFLE(3, 3, 0, 0)), _MM_SHUFFLE(2, 0, 2, 0));
+
+	__m256 out[4];
+	for (int column = 0; column < 4; ++column) {
+		__m256 r = _mm256_fmadd_ps(x, m[0][column], m[3][column]);
+		r = _mm256_fmadd_ps(y, m[1][column], r);
+		out[column] = _mm256_fmadd_ps(z, m[2][column], r);
+	}
+	__m256 invW = _mm256_div_ps(_mm256_set1_ps(1.0f), out[3]);
+	x = _mm256_mul_ps(out[0], invW);
+	y = _mm256_mul_ps(out[1], invW);
+	z = _mm256_mul_ps(out[2], invW);
+}
+
+// 表せる範囲に寄せる (max は NaN のとき 2 番目の引数を返すので NaN は最小値になる)
+MATH_TARGET_AVX2 inline __m256 ClampCoordinateAvx2(__m256 value, __m256& inRange) {
+	const __m256 minimum = _mm256_set1_ps(kMinCoordinate);
+	const __m256 maximum = _mm256_set1_ps(kMaxCoordinate);
+	inRange = _mm256_and_ps(
+	    inRange, _mm256_and_ps(
+	                 _mm256_cmp_ps(value, minimum, _CMP_GE_OQ),
+	                 _mm256_cmp_ps(value, maximum, _CMP_LE_OQ)));
+	return _mm256_min_ps(_mm256_max_ps(value, minimum), maximum);
+}
+
+// 1 - z を fp16 にして 8 個書く
+MATH_TARGET_AVX2 inline void StoreHalfDepthsAvx2(uint16_t* depths, __m256 z) {
+	__m128i half = _mm256_cvtps_ph(
+	    _mm256_sub_ps(_mm256_set1_ps(1.0f), z), _MM_FROUND_TO_NEAREST_INT | _MM_FROUND_NO_EXC);
+	_mm_storeu_si128(reinterpret_cast<__m128i*>(depths), half);
+}
+
+MATH_TARGET_AVX2 bool TransformArrayToScreenFixedAvx2(
+    const Vector3* vectors, ScreenPointFixed* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	__m256 m[4][4];
+	BroadcastMatrixAvx2(matrix, m);
+	const __m256 one = _mm256_set1_ps(float(kFixedOne));
+	__m256 inRange = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x, y, z;
+		ProjectAvx2(vectors + i, m, x, y, z);
+		__m256i fixedX = _mm256_cvtps_epi32(_mm256_mul_ps(ClampCoordinateAvx2(x, inRange), one));
+		__m256i fixedY = _mm256_cvtps_epi32(_mm256_mul_ps(ClampCoordinateAvx2(y, inRange), one));
+		// 各 128bit レーンで x, y を交互に並べ、レーンをまたいで点の順に戻す
+		__m256i low = _mm256_unpacklo_epi32(fixedX, fixedY);
+		__m256i high = _mm256_unpackhi_epi32(fixedX, fixedY);
+		__m256i* dst = reinterpret_cast<__m256i*>(points + i);
+		_mm256_storeu_si256(dst, _mm256_permute2x128_si256(low, high, 0x20));
+		_mm256_storeu_si256(dst + 1, _mm256_permute2x128_si256(low, high, 0x31));
+		if (depths) {
+			StoreHalfDepthsAvx2(depths + i, z);
+		}
+	}
+	bool tailInRange = TransformArrayToScreenFixedScalar(
+	    vectors + i, points + i, depths ? depths + i : nullptr, count - i, matrix);
+	return tailInRange && _mm256_movemask_ps(inRange) == 0xFF;
+}
+
+MATH_TARGET_AVX2 bool TransformArrayToScreen16Avx2(
+    const Vector3* vectors, ScreenPoint16* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	__m256 m[4][4];
+	BroadcastMatrixAvx2(matrix, m);
+	const __m256i lowMask = _mm256_set1_epi32(0xFFFF);
+	__m256 inRange = _mm256_castsi256_ps(_mm256_set1_epi32(-1));
+
+	size_t i = 0;
+	for (; i + 8 <= count; i += 8) {
+		__m256 x, y, z;
+		ProjectAvx2(vectors + i, m, x, y, z);
+		// (int) と同じ切り捨て
+		__m256i pixelX = _mm256_cvttps_epi32(ClampCoordinateAvx2(x, inRange));
+		__m256i pixelY = _mm256_cvttps_epi32(ClampCoordinateAvx2(y, inRange));
+		// 下位 16bit に x、上位 16bit に y
+		__m256i packed =
+		    _mm256_or_si256(_mm256_and_si256(pixelX, lowMask), _mm256_slli_epi32(pixelY, 16));
+		_mm256_storeu_si256(reinterpret_cast<__m256i*>(points + i), packed);
+		if (depths) {
+			StoreHalfDepthsAvx2(depths + i, z);
+		}
+	}
+	bool tailInRange = TransformArrayToScreen16Scalar(
+	    vectors + i, points + i, depths ? depths + i : nullptr, count - i, matrix);
+	return tailInRange && _mm256_movemask_ps(inRange) == 0xFF;
+}
+
+} // namespace
+
+// float を fp16 に
+uint16_t FloatToHalf(float value) {
+	uint32_t bits;
+	std::memcpy(&bits, &value, sizeof(bits));
+	uint32_t sign = (bits >> 16) & 0x8000;
+	uint32_t magnitude = bits & 0x7FFFFFFF;
+
+	// inf, NaN (NaN は仮数の上位を残して quiet NaN にする)
+	if (magnitude >= 0x7F800000) {
+		uint32_t nan = magnitude > 0x7F800000 ? 0x200 | ((magnitude >> 13) & 0x3FF) : 0;
+		return uint16_t(sign | 0x7C00 | nan);
+	}
+	// 65520 以上は丸めると inf
+	if (magnitude >= 0x477FF000) {
+		return uint16_t(sign | 0x7C00);
+	}
+	// 2^-14 未満は非正規化数 (2^24 倍して整数に丸めればそのまま仮数になる)
+	if (magnitude < 0x38800000) {
+		float absolute;
+		std::memcpy(&absolute, &magnitude, sizeof(absolute));
+		return uint16_t(sign | uint32_t(std::nearbyint(absolute * 16777216.0f)));
+	}
+	// 指数の偏りを 127 から 15 に直し、仮数を 10bit に最近接偶数丸め
+	uint32_t half = (magnitude - 0x38000000) >> 13;
+	uint32_t rest = magnitude & 0x1FFF;
+	if (rest > 0x1000 || (rest == 0x1000 && (half & 1) != 0)) {
+		++half;
+	}
+	return uint16_t(sign | half);
+}
+
+// fp16 を float に
+float HalfToFloat(uint16_t value) {
+	uint32_t sign = uint32_t(value & 0x8000) << 16;
+	uint32_t exponent = (value >> 10) & 0x1F;
+	uint32_t mantissa = value & 0x3FF;
+	if (exponent == 0) {
+		// 0 と非正規化数
+		float magnitude = float(mantissa) * (1.0f / 16777216.0f);
+		return sign != 0 ? -magnitude : magnitude;
+	}
+	// inf, NaN (F16C と同じく NaN は quiet NaN にする)
+	uint32_t bits = exponent == 0x1F
+	                    ? sign | 0x7F800000 | (mantissa << 13) | (mantissa != 0 ? 0x400000 : 0)
+	                    : sign | ((exponent + 112) << 23) | (mantissa << 13);
+	float result;
+	std::memcpy(&result, &bits, sizeof(result));
+	return result;
+}
+
+// 16.16 固定小数点の screen 座標へ一括変換
+bool TransformArrayToScreenFixed(
+    const Vector3* vectors, ScreenPointFixed* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	PROFILE_SCOPE("TransformArrayToScreenFixed");
+	// SSE 環境では F16C が使えるとは限らないのでスカラー版 (AVX-512 版はない)
+	if (HasAvx2Kernels()) {
+		return TransformArrayToScreenFixedAvx2(vectors, points, depths, count, matrix);
+	}
+	return TransformArrayToScreenFixedScalar(vectors, points, depths, count, matrix);
+}
+
+// int16 の screen 座標へ一括変換
+bool TransformArrayToScreen16(
+    const Vector3* vectors, ScreenPoint16* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix) {
+	PROFILE_SCOPE("TransformArrayToScreen16");
+	if (HasAvx2Kernels()) {
+		return TransformArrayToScreen16Avx2(vectors, points, depths, count, matrix);
+	}
+	return TransformArrayToScreen16Scalar(vectors, points, depths, count, matrix);
+}
@@ -0,0 +1,53 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cstddef>
+#include <cstdint>
+
+/*---------------------------------
+ screen 座標の詰めた形式 (変換の出力を小さくして、段やスレッドの間で流す量を減らす)
+ ・ScreenPointFixed : x, y を 16.16 固定小数点 (8 バイト)。画素未満の位置も残る
+ ・ScreenPoint16    : x, y を int16 の画素 (4 バイト)。(int) で切り捨てた値と同じ
+ ・深度は別の列に fp16 で持つ (2 バイト)。1 付近に集まる深度の精度を保つため 1 - z を入れる
+ ・x, y が表せる範囲は画素で -32768〜32767 くらい。範囲外の点は端に寄せて false を返すので、
+   呼び出し側は float の経路に戻すこと
+------------------------------------*/
+// 16.16 固定小数点の screen 座標
+struct ScreenPointFixed {
+	int32_t x;
+	int32_t y;
+};
+
+// int16 の画素の screen 座標
+struct ScreenPoint16 {
+	int16_t x;
+	int16_t y;
+};
+
+// 固定小数点の 1.0
+constexpr int32_t kFixedOne = 1 << 16;
+
+// 固定小数点を画素に (float を (int) にしたのと同じく 0 に向かって切り捨てる)
+constexpr int FixedToInt(int32_t value) {
+	return value < 0 ? -int((-int64_t(value)) >> 16) : int(value >> 16);
+}
+
+// 固定小数点を float に
+constexpr float FixedToFloat(int32_t value) { return float(value) * (1.0f / float(kFixedOne)); }
+
+// float と fp16 (IEEE 754 binary16) の変換 (最近接偶数丸め、範囲外は inf)
+uint16_t FloatToHalf(float value);
+float HalfToFloat(uint16_t value);
+
+// fp16 の深度列の値を深度に戻す
+inline float DecodeHalfDepth(uint16_t value) { return 1.0f - HalfToFloat(value); }
+
+// screen までの一括変換 (w 除算込み) をして詰めた形式で書く
+// ・matrix はビュープロジェクション * ビューポート行列 (TransformArray と同じ)
+// ・depths は nullptr なら書かない
+// ・すべての点が範囲内なら true
+bool TransformArrayToScreenFixed(
+    const Vector3* vectors, ScreenPointFixed* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix);
+bool TransformArrayToScreen16(
+    const Vector3* vectors, ScreenPoint16* points, uint16_t* depths, size_t count,
+    const Matrix4x4& matrix);
@@ -0,0 +1,32 @@
+﻿#pragma once
+#include "Mathfunction.h"
+
+// 球
+struct Sphere {
+	Vector3 center;
+	float radius;
+};
+
+// 平面 (Dot(normal, p) == distance となる点 p の集まり。normal は単位ベクトル)
+struct Plane {
+	Vector3 normal;
+	float distance;
+};
+
+// 線分 (origin から origin + diff まで)
+struct Segment {
+	Vector3 origin;
+	Vector3 diff;
+};
+
+// 半直線 (origin から diff の向きに t >= 0)
+struct Ray {
+	Vector3 origin;
+	Vector3 diff;
+};
+
+// 軸に平行な箱
+struct AABB {
+	Vector3 min;
+	Vector3 max;
+};
@@ -0,0 +1,98 @@
+﻿#include "SphereMesh.h"
+#include "FastMath.h"
+#include <cassert>
+#include <cmath>
+#include <atomic>
+#include <memory>
+#include <mutex>
+
+namespace {
+
+UnitSphereMesh BuildUnitSphereMesh(uint32_t subdivision) {
+	const float pi = 3.14159265358979f;
+	const float kLonEvery = pi * 2.0f / float(subdivision);
+	const float kLatEvery = pi / float(subdivision);
+
+	UnitSphereMesh mesh;
+	mesh.subdivision = subdivision;
+	mesh.vertices.resize((subdivision + 1) * subdivision);
+	mesh.edges.reserve(subdivision * subdivision * 4);
+	mesh.triangles.reserve(subdivision * subdivision * 6);
+
+	// 経度の sin, cos は全段で共通なので先に求めておく
+	std::vector<float> lonCos(subdivision);
+	std::vector<float> lonSin(subdivision);
+	for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+		float lon = lonIndex * kLonEvery;
+		SinCos(lon, lonSin[lonIndex], lonCos[lonIndex]);
+	}
+
+	for (uint32_t latIndex = 0; latIndex <= subdivision; ++latIndex) {
+		// 緯度の方向に分割
+		float lat = -pi / 2.0f + kLatEvery * latIndex;
+		float latSin;
+		float latCos;
+		SinCos(lat, latSin, latCos);
+		for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+			mesh.vertices[latIndex * subdivision + lonIndex] = {
+			    latCos * lonCos[lonIndex], latSin, latCos * lonSin[lonIndex]};
+		}
+	}
+
+	for (uint32_t latIndex = 0; latIndex < subdivision; ++latIndex) {
+		for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+			// a:現在の点 b:緯度方向に次の点 c:経度方向に次の点
+			uint32_t a = latIndex * subdivision + lonIndex;
+			uint32_t b = (latIndex + 1) * subdivision + lonIndex;
+			uint32_t c = latIndex * subdivision + (lonIndex + 1) % subdivision;
+			mesh.edges.push_back(a);
+			mesh.edges.push_back(b);
+			mesh.edges.push_back(a);
+			mesh.edges.push_back(c);
+			// d:緯度方向にも経度方向にも次の点。四角形 abdc を 2 枚に分ける
+			uint32_t d = (latIndex + 1) * subdivision + (lonIndex + 1) % subdivision;
+			mesh.triangles.insert(mesh.triangles.end(), {a, b, d, a, d, c});
+		}
+	}
+
+	mesh.stripLength = subdivision + 1;
+	mesh.stripCount = subdivision * 2 - 1;
+	mesh.strips.reserve(mesh.stripLength * mesh.stripCount);
+	// 緯線 (南極と北極の段は 1 点に縮むので除く)
+	for (uint32_t latIndex = 1; latIndex < subdivision; ++latIndex) {
+		for (uint32_t lonIndex = 0; lonIndex <= subdivision; ++lonIndex) {
+			mesh.strips.push_back(latIndex * subdivision + lonIndex % subdivision);
+		}
+	}
+	// 経線
+	for (uint32_t lonIndex = 0; lonIndex < subdivision; ++lonIndex) {
+		for (uint32_t latIndex = 0; latIndex <= subdivision; ++latIndex) {
+			mesh.strips.push_back(latIndex * subdivision + lonIndex);
+		}
+	}
+	return mesh;
+}
+
+} // namespace
+
+const UnitSphereMesh& GetUnitSphereMesh(uint32_t subdivision) {
+	assert(subdivision >= 3 && subdivision <= kMaxSphereSubdivision);
+
+	// 作成済みならロックせずに返す
+	static std::atomic<const UnitSphereMesh*> cache[kMaxSphereSubdivision + 1];
+	const UnitSphereMesh* mesh = cache[subdivision].load(std::memory_order_acquire);
+	if (mesh) {
+		return *mesh;
+	}
+
+	static std::mutex mutex;
+	static std::vector<std::unique_ptr<UnitSphereMesh>> meshes;
+	std::lock_guard<std::mutex> lock(mutex);
+	mesh = cache[subdivision].load(std::memory_order_relaxed);
+	if (!mesh) {
+		meshes.push_back(std::make_unique<UnitSphereMesh>(BuildUnitSphereMesh(subdivision)));
+		mesh = meshes.back().get();
+		cache[subdivision].store(mesh, std::memory_order_release);
+	}
+	return *mesh;
+}
@@ -0,0 +1,33 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ 単位球 (原点中心、半径 1) のワイヤーフレームと三角形
+ ・分割数ごとに一度だけ作って使い回す
+ ・描画時は半径と中心を行列に含めて TransformArray に渡す
+------------------------------------*/
+struct UnitSphereMesh {
+	uint32_t subdivision;
+	// 折れ線 1 本の点の数 (subdivision + 1) と本数 (subdivision * 2 - 1)
+	uint32_t stripLength;
+	uint32_t stripCount;
+	// 緯度は南極から北極まで (subdivision + 1) 段、経度は一周 subdivision 本
+	// 番号は latIndex * subdivision + lonIndex
+	std::vector<Vector3> vertices;
+	// 線分の両端の頂点番号 (2 個で 1 本)
+	std::vector<uint32_t> edges;
+	// 折れ線の頂点番号 (1 本あたり stripLength 個。極で点になる緯線は含まない)
+	// 緯線 (subdivision - 1 本、最初の点に戻って閉じる) の後に経線 (subdivision 本、南極から北極へ)
+	// 頂点を共有するので edges より少ない点で同じ線を引ける
+	std::vector<uint32_t> strips;
+	// 三角形の頂点番号 (3 個で 1 枚。外から見て時計回り。極の周りには面積 0 のものも含む)
+	std::vector<uint32_t> triangles;
+};
+
+// 分割数の上限
+const uint32_t kMaxSphereSubdivision = 256;
+
+// 分割数に対応した単位球を返す (初回だけ作る。複数スレッドから呼んでよい)
+const UnitSphereMesh& GetUnitSphereMesh(uint32_t subdivision);
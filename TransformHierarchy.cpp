@@ -0,0 +1,121 @@
+﻿#include "TransformHierarchy.h"
+#include "Profiler.h"
+#include <cassert>
+
+uint32_t TransformHierarchy::AddNode(
+    uint32_t parent, const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	assert(parent == kNoParent || parent < parents_.size());
+	uint32_t index = uint32_t(parents_.size());
+	parents_.push_back(parent);
+	scales_.push_back(scale);
+	rotates_.push_back(rotate);
+	translates_.push_back(translate);
+	worldMatrices_.push_back(MakeIdentityMatrix());
+	dirty_.push_back(0);
+	MarkDirty(index);
+	return index;
+}
+
+void TransformHierarchy::Clear() {
+	parents_.clear();
+	scales_.clear();
+	rotates_.clear();
+	translates_.clear();
+	worldMatrices_.clear();
+	dirty_.clear();
+	firstDirty_ = SIZE_MAX;
+	updated_.clear();
+}
+
+void TransformHierarchy::Reserve(size_t capacity) {
+	parents_.reserve(capacity);
+	scales_.reserve(capacity);
+	rotates_.reserve(capacity);
+	translates_.reserve(capacity);
+	worldMatrices_.reserve(capacity);
+	dirty_.reserve(capacity);
+	updated_.reserve(capacity);
+}
+
+void TransformHierarchy::SetParent(uint32_t index, uint32_t parent) {
+	// 親が後ろにあるとトポロジカル順が崩れる
+	assert(parent == kNoParent || parent < index);
+	parents_[index] = parent;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetScale(uint32_t index, const Vector3& scale) {
+	scales_[index] = scale;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetRotate(uint32_t index, const Quaternion& rotate) {
+	rotates_[index] = rotate;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetTranslate(uint32_t index, const Vector3& translate) {
+	translates_[index] = translate;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::SetLocal(
+    uint32_t index, const Vector3& scale, const Quaternion& rotate, const Vector3& translate) {
+	scales_[index] = scale;
+	rotates_[index] = rotate;
+	translates_[index] = translate;
+	MarkDirty(index);
+}
+
+void TransformHierarchy::MarkDirty(uint32_t index) {
+	assert(index < parents_.size());
+	dirty_[index] = 1;
+	if (index < firstDirty_) {
+		firstDirty_ = index;
+	}
+}
+
+size_t TransformHierarchy::UpdateWorldMatrices() {
+	PROFILE_SCOPE("UpdateWorldMatrices");
+	updated_.clear();
+	if (firstDirty_ == SIZE_MAX) {
+		return 0;
+	}
+
+	// 親は子より前にあるので、前から 1 回見れば親の印が子孫まで伝わる
+	size_t count = parents_.size();
+	for (size_t i = firstDirty_; i < count; ++i) {
+		uint32_t parent = parents_[i];
+		if (dirty_[i] || (parent != kNoParent && dirty_[parent])) {
+			dirty_[i] = 1;
+			updated_.push_back(uint32_t(i));
+		}
+	}
+
+	// ローカル行列をまとめて作り、親のワールド行列を掛ける
+	// 親が同じ回で作り直されていても、前にあるので先に終わっている
+	for (uint32_t i : updated_) {
+		worldMatrices_[i] = MakeQuaternionAffineMatrix(scales_[i], rotates_[i], translates_[i]);
+	}
+	// 積は Multiply (インライン) で 1 つずつ求める
+	// MultiplyArray は 1 組ずつ同じ積を繰り返すだけなので、深さごとに並べ替えて親を集めても
+	// 並べ替えと行列のコピーが増えるだけで速くならない
+	for (uint32_t i : updated_) {
+		uint32_t parent = parents_[i];
+		if (parent != kNoParent) {
+			worldMatrices_[i] = Multiply(worldMatrices_[i], worldMatrices_[parent]);
+		}
+	}
+
+	for (uint32_t i : updated_) {
+		dirty_[i] = 0;
+	}
+	firstDirty_ = SIZE_MAX;
+	return updated_.size();
+}
+
+const Matrix4x4& TransformHierarchy::GetWorldMatrix(uint32_t index) const {
+	// 自分か親を変えたまま UpdateWorldMatrices を呼んでいない (親は前にあるので印より前なら最新)
+	assert(index < firstDirty_);
+	return worldMatrices_[index];
+}
@@ -0,0 +1,65 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include "Quaternion.h"
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+/*---------------------------------
+ トランスフォームの階層 (親子関係)
+ ・ノードは 1 本の配列に並べ、親は必ず子より前に置く (トポロジカル順)
+ ・各ノードはローカルの拡縮・回転・平行移動とワールド行列を持つ
+ ・Set で変えたノードに印を付け、UpdateWorldMatrices で印の付いたノードとその子孫だけ作り直す
+   (動かないノードのワールド行列はそのまま使い回す)
+------------------------------------*/
+class TransformHierarchy {
+public:
+	// 親なし (ワールド直下)
+	static const uint32_t kNoParent = UINT32_MAX;
+
+	// 末尾に追加して番号を返す (parent はすでにあるノードか kNoParent)
+	uint32_t AddNode(
+	    uint32_t parent, const Vector3& scale, const Quaternion& rotate,
+	    const Vector3& translate);
+	// すべて消す
+	void Clear();
+	void Reserve(size_t capacity);
+
+	// 親を付け替える (parent は index より前のノードか kNoParent)
+	void SetParent(uint32_t index, uint32_t parent);
+	void SetScale(uint32_t index, const Vector3& scale);
+	void SetRotate(uint32_t index, const Quaternion& rotate);
+	void SetTranslate(uint32_t index, const Vector3& translate);
+	void SetLocal(
+	    uint32_t index, const Vector3& scale, const Quaternion& rotate, const Vector3& translate);
+
+	uint32_t GetParent(uint32_t index) const { return parents_[index]; }
+	const Vector3& GetScale(uint32_t index) const { return scales_[index]; }
+	const Quaternion& GetRotate(uint32_t index) const { return rotates_[index]; }
+	const Vector3& GetTranslate(uint32_t index) const { return translates_[index]; }
+
+	// 変えたノードとその子孫のワールド行列を作り直し、作り直した数を返す
+	size_t UpdateWorldMatrices();
+
+	// UpdateWorldMatrices を呼んだあとのワールド行列
+	const Matrix4x4& GetWorldMatrix(uint32_t index) const;
+	const Matrix4x4* GetWorldMatrices() const { return worldMatrices_.data(); }
+	// 前回の UpdateWorldMatrices で作り直したノードの番号 (小さい順)
+	const std::vector<uint32_t>& GetUpdatedIndices() const { return updated_; }
+
+	size_t GetCount() const { return parents_.size(); }
+
+private:
+	void MarkDirty(uint32_t index);
+
+	std::vector<uint32_t> parents_;
+	std::vector<Vector3> scales_;
+	std::vector<Quaternion> rotates_;
+	std::vector<Vector3> translates_;
+	std::vector<Matrix4x4> worldMatrices_;
+	// 作り直しの印 (UpdateWorldMatrices の中では親から伝わった印も付ける)
+	std::vector<uint8_t> dirty_;
+	// 印の付いた最小の番号 (これより前は調べなくてよい)
+	size_t firstDirty_ = SIZE_MAX;
+	std::vector<uint32_t> updated_;
+};
@@ -0,0 +1,565 @@
+﻿#include "Vector3Soa.h"
+#include "MathSimd.h"
+#include <cassert>
+#include <cmath>
+#include <cstring>
+#include <immintrin.h>
+#include <new>
+#include <utility>
+
+/*---------------------------------
+ Vector3Soa
+------------------------------------*/
+
+namespace {
+
+// 1 本の配列の要素数を 16 の倍数に切り上げる (各配列の先頭を 64byte 境界に揃えるため)
+size_t RoundUpCapacity(size_t capacity) {
+	const size_t kLanes = Vector3Soa::kAlignment / sizeof(float);
+	return (capacity + kLanes - 1) / kLanes * kLanes;
+}
+
+float* AllocateStreams(size_t capacity) {
+	if (capacity == 0) {
+		return nullptr;
+	}
+	return static_cast<float*>(::operator new[](
+	    capacity * 3 * sizeof(float), std::align_val_t(Vector3Soa::kAlignment)));
+}
+
+void FreeStreams(float* buffer) {
+	if (buffer) {
+		::operator delete[](buffer, std::align_val_t(Vector3Soa::kAlignment));
+	}
+}
+
+} // namespace
+
+Vector3Soa::Vector3Soa(size_t size) { Resize(size); }
+
+Vector3Soa::Vector3Soa(const Vector3* vectors, size_t count) { FromArray(vectors, count); }
+
+Vector3Soa::Vector3Soa(const Vector3Soa& other) {
+	Resize(other.size_);
+	// 空の配列は確保していない (nullptr) ので memcpy に渡さない
+	if (size_ > 0) {
+		std::memcpy(x_, other.x_, size_ * sizeof(float));
+		std::memcpy(y_, other.y_, size_ * sizeof(float));
+		std::memcpy(z_, other.z_, size_ * sizeof(float));
+	}
+}
+
+Vector3Soa::Vector3Soa(Vector3Soa&& other) noexcept
+    : buffer_(std::exchange(other.buffer_, nullptr)), x_(std::exchange(other.x_, nullptr)),
+      y_(std::exchange(other.y_, nullptr)), z_(std::exchange(other.z_, nullptr)),
+      size_(std::exchange(other.size_, 0)), capacity_(std::exchange(other.capacity_, 0)) {}
+
+Vector3Soa& Vector3Soa::operator=(const Vector3Soa& other) {
+	if (this != &other) {
+		Resize(other.size_);
+		if (size_ > 0) {
+			std::memcpy(x_, other.x_, size_ * sizeof(float));
+			std::memcpy(y_, other.y_, size_ * sizeof(float));
+			std::memcpy(z_, other.z_, size_ * sizeof(float));
+		}
+	}
+	return *this;
+}
+
+Vector3Soa& Vector3Soa::operator=(Vector3Soa&& other) noexcept {
+	if (this != &other) {
+		FreeStreams(buffer_);
+		buffer_ = std::exchange(other.buffer_, nullptr);
+		x_ = std::exchange(other.x_, nullptr);
+		y_ = std::exchange(other.y_, nullptr);
+		z_ = std::exchange(other.z_, nullptr);
+		size_ = std::exchange(other.size_, 0);
+		capacity_ = std::exchange(other.capacity_, 0);
+	}
+	return *this;
+}
+
+Vector3Soa::~Vector3Soa() { FreeStreams(buffer_); }
+
+void Vector3Soa::Reserve(size_t capacity) {
+	if (capacity <= capacity_) {
+		return;
+	}
+	capacity = RoundUpCapacity(capacity);
+	float* buffer = AllocateStreams(capacity);
+	if (size_ > 0) {
+		std::memcpy(buffer, x_, size_ * sizeof(float));
+		std::memcpy(buffer + capacity, y_, size_ * sizeof(float));
+		std::memcpy(buffer + capacity * 2, z_, size_ * sizeof(float));
+	}
+	FreeStreams(buffer_);
+	buffer_ = buffer;
+	x_ = buffer;
+	y_ = buffer + capacity;
+	z_ = buffer + capacity * 2;
+	capacity_ = capacity;
+}
+
+void Vector3Soa::Resize(size_t size) {
+	Reserve(size);
+	size_ = size;
+}
+
+void Vector3Soa::PushBack(const Vector3& v) {
+	if (size_ == capacity_) {
+		Reserve(capacity_ == 0 ? kAlignment / sizeof(float) : capacity_ * 2);
+	}
+	Set(size_++, v);
+}
+
+void Vector3Soa::FromArray(const Vector3* vectors, size_t count) {
+	Resize(count);
+	for (size_t i = 0; i < count; ++i) {
+		Set(i, vectors[i]);
+	}
+}
+
+void Vector3Soa::ToArray(Vector3* vectors) const {
+	for (size_t i = 0; i < size_; ++i) {
+		vectors[i] = Get(i);
+	}
+}
+
+/*---------------------------------
+ カーネル
+ ・スカラー版は端数処理と SSE 環境 (コンパイラの自動ベクトル化に任せる) で使う
+------------------------------------*/
+
+namespace {
+
+// 配列同士の加算
+void AddScalar(const float* a, const float* b, float* r, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = a[i] + b[i];
+	}
+}
+
+// 配列同士の減算
+void SubtractScalar(const float* a, const float* b, float* r, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = a[i] - b[i];
+	}
+}
+
+// 配列のスカラー倍
+void ScaleScalar(float s, const float* a, float* r, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = s * a[i];
+	}
+}
+
+void DotScalar(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* r, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = ax[i] * bx[i] + ay[i] * by[i] + az[i] * bz[i];
+	}
+}
+
+void CrossScalar(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* rx, float* ry, float* rz, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		float x = ay[i] * bz[i] - az[i] * by[i];
+		float y = az[i] * bx[i] - ax[i] * bz[i];
+		float z = ax[i] * by[i] - ay[i] * bx[i];
+		rx[i] = x;
+		ry[i] = y;
+		rz[i] = z;
+	}
+}
+
+void LengthScalar(const float* x, const float* y, const float* z, float* r, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		r[i] = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+	}
+}
+
+void NormalizeScalar(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n) {
+	for (size_t i = 0; i < n; ++i) {
+		float norm = sqrtf(x[i] * x[i] + y[i] * y[i] + z[i] * z[i]);
+		// 長さ 0 は 0 ベクトル (Normalize(const Vector3&) と同じ)
+		if (norm == 0.0f) {
+			rx[i] = 0.0f;
+			ry[i] = 0.0f;
+			rz[i] = 0.0f;
+			continue;
+		}
+		rx[i] = x[i] / norm;
+		ry[i] = y[i] / norm;
+		rz[i] = z[i] / norm;
+	}
+}
+
+void TransformPointsScalar(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n,
+    const Matrix4x4& m) {
+	for (size_t i = 0; i < n; ++i) {
+		float tx = x[i] * m.m[0][0] + y[i] * m.m[1][0] + z[i] * m.m[2][0] + m.m[3][0];
+		float ty = x[i] * m.m[0][1] + y[i] * m.m[1][1] + z[i] * m.m[2][1] + m.m[3][1];
+		float tz = x[i] * m.m[0][2] + y[i] * m.m[1][2] + z[i] * m.m[2][2] + m.m[3][2];
+		float tw = x[i] * m.m[0][3] + y[i] * m.m[1][3] + z[i] * m.m[2][3] + m.m[3][3];
+		float invW = 1.0f / tw;
+		rx[i] = tx * invW;
+		ry[i] = ty * invW;
+		rz[i] = tz * invW;
+	}
+}
+
+/*---------------------------------
+ AVX2 (8 要素ずつ)
+------------------------------------*/
+
+MATH_TARGET_AVX2 void AddAvx2(const float* a, const float* b, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_store_ps(r + i, _mm256_add_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i)));
+	}
+	AddScalar(a + i, b + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX2 void SubtractAvx2(const float* a, const float* b, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_store_ps(r + i, _mm256_sub_ps(_mm256_load_ps(a + i), _mm256_load_ps(b + i)));
+	}
+	SubtractScalar(a + i, b + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX2 void ScaleAvx2(float s, const float* a, float* r, size_t n) {
+	__m256 vs = _mm256_set1_ps(s);
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		_mm256_store_ps(r + i, _mm256_mul_ps(vs, _mm256_load_ps(a + i)));
+	}
+	ScaleScalar(s, a + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX2 void DotAvx2(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 d = _mm256_mul_ps(_mm256_load_ps(ax + i), _mm256_load_ps(bx + i));
+		d = _mm256_fmadd_ps(_mm256_load_ps(ay + i), _mm256_load_ps(by + i), d);
+		d = _mm256_fmadd_ps(_mm256_load_ps(az + i), _mm256_load_ps(bz + i), d);
+		_mm256_storeu_ps(r + i, d);
+	}
+	DotScalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX2 void CrossAvx2(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* rx, float* ry, float* rz, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 x1 = _mm256_load_ps(ax + i);
+		__m256 y1 = _mm256_load_ps(ay + i);
+		__m256 z1 = _mm256_load_ps(az + i);
+		__m256 x2 = _mm256_load_ps(bx + i);
+		__m256 y2 = _mm256_load_ps(by + i);
+		__m256 z2 = _mm256_load_ps(bz + i);
+		_mm256_store_ps(rx + i, _mm256_fmsub_ps(y1, z2, _mm256_mul_ps(z1, y2)));
+		_mm256_store_ps(ry + i, _mm256_fmsub_ps(z1, x2, _mm256_mul_ps(x1, z2)));
+		_mm256_store_ps(rz + i, _mm256_fmsub_ps(x1, y2, _mm256_mul_ps(y1, x2)));
+	}
+	CrossScalar(ax + i, ay + i, az + i, bx + i, by + i, bz + i, rx + i, ry + i, rz + i, n - i);
+}
+
+MATH_TARGET_AVX2 void LengthAvx2(
+    const float* x, const float* y, const float* z, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 vx = _mm256_load_ps(x + i);
+		__m256 vy = _mm256_load_ps(y + i);
+		__m256 vz = _mm256_load_ps(z + i);
+		__m256 d = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+		_mm256_storeu_ps(r + i, _mm256_sqrt_ps(d));
+	}
+	LengthScalar(x + i, y + i, z + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX2 void NormalizeAvx2(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n) {
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 vx = _mm256_load_ps(x + i);
+		__m256 vy = _mm256_load_ps(y + i);
+		__m256 vz = _mm256_load_ps(z + i);
+		__m256 d = _mm256_fmadd_ps(vz, vz, _mm256_fmadd_ps(vy, vy, _mm256_mul_ps(vx, vx)));
+		__m256 norm = _mm256_sqrt_ps(d);
+		// 長さ 0 の要素は 0 / 0 の NaN をマスクで 0 にする
+		__m256 nonZero = _mm256_cmp_ps(norm, _mm256_setzero_ps(), _CMP_NEQ_OQ);
+		_mm256_store_ps(rx + i, _mm256_and_ps(_mm256_div_ps(vx, norm), nonZero));
+		_mm256_store_ps(ry + i, _mm256_and_ps(_mm256_div_ps(vy, norm), nonZero));
+		_mm256_store_ps(rz + i, _mm256_and_ps(_mm256_div_ps(vz, norm), nonZero));
+	}
+	NormalizeScalar(x + i, y + i, z + i, rx + i, ry + i, rz + i, n - i);
+}
+
+MATH_TARGET_AVX2 void TransformPointsAvx2(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n,
+    const Matrix4x4& m) {
+	__m256 c[4][4];
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			c[row][column] = _mm256_set1_ps(m.m[row][column]);
+		}
+	}
+	size_t i = 0;
+	for (; i + 8 <= n; i += 8) {
+		__m256 vx = _mm256_load_ps(x + i);
+		__m256 vy = _mm256_load_ps(y + i);
+		__m256 vz = _mm256_load_ps(z + i);
+		__m256 out[4];
+		for (int column = 0; column < 4; ++column) {
+			__m256 r = _mm256_fmadd_ps(vx, c[0][column], c[3][column]);
+			r = _mm256_fmadd_ps(vy, c[1][column], r);
+			out[column] = _mm256_fmadd_ps(vz, c[2][column], r);
+		}
+		__m256 invW = _mm256_div_ps(_mm256_set1_ps(1.0f), out[3]);
+		_mm256_store_ps(rx + i, _mm256_mul_ps(out[0], invW));
+		_mm256_store_ps(ry + i, _mm256_mul_ps(out[1], invW));
+		_mm256_store_ps(rz + i, _mm256_mul_ps(out[2], invW));
+	}
+	TransformPointsScalar(x + i, y + i, z + i, rx + i, ry + i, rz + i, n - i, m);
+}
+
+/*---------------------------------
+ AVX-512 (16 要素ずつ)
+------------------------------------*/
+
+MATH_TARGET_AVX512 void AddAvx512(const float* a, const float* b, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_store_ps(r + i, _mm512_add_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i)));
+	}
+	AddAvx2(a + i, b + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX512 void SubtractAvx512(const float* a, const float* b, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_store_ps(r + i, _mm512_sub_ps(_mm512_load_ps(a + i), _mm512_load_ps(b + i)));
+	}
+	SubtractAvx2(a + i, b + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX512 void ScaleAvx512(float s, const float* a, float* r, size_t n) {
+	__m512 vs = _mm512_set1_ps(s);
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		_mm512_store_ps(r + i, _mm512_mul_ps(vs, _mm512_load_ps(a + i)));
+	}
+	ScaleAvx2(s, a + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX512 void DotAvx512(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512 d = _mm512_mul_ps(_mm512_load_ps(ax + i), _mm512_load_ps(bx + i));
+		d = _mm512_fmadd_ps(_mm512_load_ps(ay + i), _mm512_load_ps(by + i), d);
+		d = _mm512_fmadd_ps(_mm512_load_ps(az + i), _mm512_load_ps(bz + i), d);
+		_mm512_storeu_ps(r + i, d);
+	}
+	DotAvx2(ax + i, ay + i, az + i, bx + i, by + i, bz + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX512 void CrossAvx512(
+    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+    const float* bz, float* rx, float* ry, float* rz, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512 x1 = _mm512_load_ps(ax + i);
+		__m512 y1 = _mm512_load_ps(ay + i);
+		__m512 z1 = _mm512_load_ps(az + i);
+		__m512 x2 = _mm512_load_ps(bx + i);
+		__m512 y2 = _mm512_load_ps(by + i);
+		__m512 z2 = _mm512_load_ps(bz + i);
+		_mm512_store_ps(rx + i, _mm512_fmsub_ps(y1, z2, _mm512_mul_ps(z1, y2)));
+		_mm512_store_ps(ry + i, _mm512_fmsub_ps(z1, x2, _mm512_mul_ps(x1, z2)));
+		_mm512_store_ps(rz + i, _mm512_fmsub_ps(x1, y2, _mm512_mul_ps(y1, x2)));
+	}
+	CrossAvx2(ax + i, ay + i, az + i, bx + i, by + i, bz + i, rx + i, ry + i, rz + i, n - i);
+}
+
+MATH_TARGET_AVX512 void LengthAvx512(
+    const float* x, const float* y, const float* z, float* r, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512 vx = _mm512_load_ps(x + i);
+		__m512 vy = _mm512_load_ps(y + i);
+		__m512 vz = _mm512_load_ps(z + i);
+		__m512 d = _mm512_fmadd_ps(vz, vz, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vx, vx)));
+		_mm512_storeu_ps(r + i, _mm512_sqrt_ps(d));
+	}
+	LengthAvx2(x + i, y + i, z + i, r + i, n - i);
+}
+
+MATH_TARGET_AVX512 void NormalizeAvx512(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n) {
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512 vx = _mm512_load_ps(x + i);
+		__m512 vy = _mm512_load_ps(y + i);
+		__m512 vz = _mm512_load_ps(z + i);
+		__m512 d = _mm512_fmadd_ps(vz, vz, _mm512_fmadd_ps(vy, vy, _mm512_mul_ps(vx, vx)));
+		__m512 norm = _mm512_sqrt_ps(d);
+		// 長さ 0 の要素は割らずに 0 にする
+		__mmask16 nonZero = _mm512_cmp_ps_mask(norm, _mm512_setzero_ps(), _CMP_NEQ_OQ);
+		_mm512_store_ps(rx + i, _mm512_maskz_div_ps(nonZero, vx, norm));
+		_mm512_store_ps(ry + i, _mm512_maskz_div_ps(nonZero, vy, norm));
+		_mm512_store_ps(rz + i, _mm512_maskz_div_ps(nonZero, vz, norm));
+	}
+	NormalizeAvx2(x + i, y + i, z + i, rx + i, ry + i, rz + i, n - i);
+}
+
+MATH_TARGET_AVX512 void TransformPointsAvx512(
+    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz, size_t n,
+    const Matrix4x4& m) {
+	__m512 c[4][4];
+	for (int row = 0; row < 4; ++row) {
+		for (int column = 0; column < 4; ++column) {
+			c[row][column] = _mm512_set1_ps(m.m[row][column]);
+		}
+	}
+	size_t i = 0;
+	for (; i + 16 <= n; i += 16) {
+		__m512 vx = _mm512_load_ps(x + i);
+		__m512 vy = _mm512_load_ps(y + i);
+		__m512 vz = _mm512_load_ps(z + i);
+		__m512 out[4];
+		for (int column = 0; column < 4; ++column) {
+			__m512 r = _mm512_fmadd_ps(vx, c[0][column], c[3][column]);
+			r = _mm512_fmadd_ps(vy, c[1][column], r);
+			out[column] = _mm512_fmadd_ps(vz, c[2][column], r);
+		}
+		__m512 invW = _mm512_div_ps(_mm512_set1_ps(1.0f), out[3]);
+		_mm512_store_ps(rx + i, _mm512_mul_ps(out[0], invW));
+		_mm512_store_ps(ry + i, _mm512_mul_ps(out[1], invW));
+		_mm512_store_ps(rz + i, _mm512_mul_ps(out[2], invW));
+	}
+	TransformPointsAvx2(x + i, y + i, z + i, rx + i, ry + i, rz + i, n - i, m);
+}
+
+/*---------------------------------
+ カーネル選択
+ ・Multiply などと同じく GetMathKernels() で選ばれている命令セットに従う
+------------------------------------*/
+
+struct SoaKernels {
+	void (*add)(const float* a, const float* b, float* r, size_t n);
+	void (*subtract)(const float* a, const float* b, float* r, size_t n);
+	void (*scale)(float s, const float* a, float* r, size_t n);
+	void (*dot)(
+	    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+	    const float* bz, float* r, size_t n);
+	void (*cross)(
+	    const float* ax, const float* ay, const float* az, const float* bx, const float* by,
+	    const float* bz, float* rx, float* ry, float* rz, size_t n);
+	void (*length)(const float* x, const float* y, const float* z, float* r, size_t n);
+	void (*normalize)(
+	    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz,
+	    size_t n);
+	void (*transform)(
+	    const float* x, const float* y, const float* z, float* rx, float* ry, float* rz,
+	    size_t n, const Matrix4x4& m);
+};
+
+const SoaKernels kScalarSoaKernels = {
+    AddScalar,       SubtractScalar,       ScaleScalar, DotScalar, CrossScalar, LengthScalar,
+    NormalizeScalar, TransformPointsScalar};
+const SoaKernels kAvx2SoaKernels = {
+    AddAvx2,       SubtractAvx2,       ScaleAvx2, DotAvx2, CrossAvx2, LengthAvx2,
+    NormalizeAvx2, TransformPointsAvx2};
+const SoaKernels kAvx512SoaKernels = {
+    AddAvx512,       SubtractAvx512,       ScaleAvx512, DotAvx512, CrossAvx512, LengthAvx512,
+    NormalizeAvx512, TransformPointsAvx512};
+
+const SoaKernels& GetSoaKernels() {
+	if (GetMathKernels().isa == MathIsa::kAvx512) {
+		return kAvx512SoaKernels;
+	}
+	return HasAvx2Kernels() ? kAvx2SoaKernels : kScalarSoaKernels;
+}
+
+} // namespace
+
+/*---------------------------------
+ SoA 配列の一括計算
+------------------------------------*/
+
+// 加算
+void Vec3Add(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result) {
+	assert(v2.Size() == v1.Size());
+	size_t n = v1.Size();
+	result.Resize(n);
+	const SoaKernels& kernels = GetSoaKernels();
+	kernels.add(v1.X(), v2.X(), result.X(), n);
+	kernels.add(v1.Y(), v2.Y(), result.Y(), n);
+	kernels.add(v1.Z(), v2.Z(), result.Z(), n);
+}
+
+// 減算
+void Vec3Subtract(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result) {
+	assert(v2.Size() == v1.Size());
+	size_t n = v1.Size();
+	result.Resize(n);
+	const SoaKernels& kernels = GetSoaKernels();
+	kernels.subtract(v1.X(), v2.X(), result.X(), n);
+	kernels.subtract(v1.Y(), v2.Y(), result.Y(), n);
+	kernels.subtract(v1.Z(), v2.Z(), result.Z(), n);
+}
+
+// スカラー倍
+void Vec3Multiply(float scalar, const Vector3Soa& v, Vector3Soa& result) {
+	size_t n = v.Size();
+	result.Resize(n);
+	const SoaKernels& kernels = GetSoaKernels();
+	kernels.scale(scalar, v.X(), result.X(), n);
+	kernels.scale(scalar, v.Y(), result.Y(), n);
+	kernels.scale(scalar, v.Z(), result.Z(), n);
+}
+
+// 内積
+void Dot(const Vector3Soa& v1, const Vector3Soa& v2, float* results) {
+	assert(v2.Size() == v1.Size());
+	GetSoaKernels().dot(v1.X(), v1.Y(), v1.Z(), v2.X(), v2.Y(), v2.Z(), results, v1.Size());
+}
+
+// クロス積
+void Cross(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result) {
+	assert(v2.Size() == v1.Size());
+	size_t n = v1.Size();
+	result.Resize(n);
+	GetSoaKernels().cross(
+	    v1.X(), v1.Y(), v1.Z(), v2.X(), v2.Y(), v2.Z(), result.X(), result.Y(), result.Z(), n);
+}
+
+// ノルム
+void Length(const Vector3Soa& v, float* results) {
+	GetSoaKernels().length(v.X(), v.Y(), v.Z(), results, v.Size());
+}
+
+// 正規化
+void Normalize(const Vector3Soa& v, Vector3Soa& result) {
+	size_t n = v.Size();
+	result.Resize(n);
+	GetSoaKernels().normalize(v.X(), v.Y(), v.Z(), result.X(), result.Y(), result.Z(), n);
+}
+
+// 変換
+void TransformArray(const Vector3Soa& vectors, Vector3Soa& results, const Matrix4x4& matrix) {
+	size_t n = vectors.Size();
+	results.Resize(n);
+	GetSoaKernels().transform(
+	    vectors.X(), vectors.Y(), vectors.Z(), results.X(), results.Y(), results.Z(), n, matrix);
+}
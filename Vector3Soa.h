@@ -0,0 +1,95 @@
+﻿#pragma once
+#include "Mathfunction.h"
+#include <cstddef>
+
+/*---------------------------------
+ Vector3 の SoA 配列
+ ・x, y, z をそれぞれ 64byte 境界に揃えた別々の配列に持つ
+ ・まとめて計算する関数は AVX2 なら 8 要素、AVX-512 なら 16 要素ずつ処理する
+------------------------------------*/
+class Vector3Soa {
+public:
+	// 各配列の先頭の境界 (AVX-512 の 1 レジスタ分)
+	static const size_t kAlignment = 64;
+
+	Vector3Soa() = default;
+	explicit Vector3Soa(size_t size);
+	Vector3Soa(const Vector3* vectors, size_t count);
+	Vector3Soa(const Vector3Soa& other);
+	Vector3Soa(Vector3Soa&& other) noexcept;
+	Vector3Soa& operator=(const Vector3Soa& other);
+	Vector3Soa& operator=(Vector3Soa&& other) noexcept;
+	~Vector3Soa();
+
+	// 要素数を変える (増えた分は不定値)
+	void Resize(size_t size);
+	// 容量だけ確保する
+	void Reserve(size_t capacity);
+	// 末尾に追加
+	void PushBack(const Vector3& v);
+	// 空にする (容量は残す)
+	void Clear() { size_ = 0; }
+
+	size_t Size() const { return size_; }
+	size_t Capacity() const { return capacity_; }
+	bool Empty() const { return size_ == 0; }
+
+	float* X() { return x_; }
+	float* Y() { return y_; }
+	float* Z() { return z_; }
+	const float* X() const { return x_; }
+	const float* Y() const { return y_; }
+	const float* Z() const { return z_; }
+
+	Vector3 Get(size_t index) const { return {x_[index], y_[index], z_[index]}; }
+	void Set(size_t index, const Vector3& v) {
+		x_[index] = v.x;
+		y_[index] = v.y;
+		z_[index] = v.z;
+	}
+
+	// Vector3 の配列から変換 (要素数は count になる)
+	void FromArray(const Vector3* vectors, size_t count);
+	// Vector3 の配列へ変換 (vectors は Size() 個分確保しておくこと)
+	void ToArray(Vector3* vectors) const;
+
+private:
+	// x, y, z の 3 本を 1 回の確保でまかなう
+	float* buffer_ = nullptr;
+	float* x_ = nullptr;
+	float* y_ = nullptr;
+	float* z_ = nullptr;
+	size_t size_ = 0;
+	size_t capacity_ = 0;
+};
+
+/*---------------------------------
+ SoA 配列の一括計算
+ ・result は自動で入力と同じ要素数になる
+ ・2 つの配列を受け取るものは、どちらも同じ要素数であること
+ ・result に入力と同じ配列を渡してもよい (要素数が変わらないので確保し直さない)
+------------------------------------*/
+
+// 加算
+void Vec3Add(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result);
+
+// 減算
+void Vec3Subtract(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result);
+
+// スカラー倍
+void Vec3Multiply(float scalar, const Vector3Soa& v, Vector3Soa& result);
+
+// 内積 (results は Size() 個分確保しておくこと)
+void Dot(const Vector3Soa& v1, const Vector3Soa& v2, float* results);
+
+// クロス積
+void Cross(const Vector3Soa& v1, const Vector3Soa& v2, Vector3Soa& result);
+
+// ノルム (results は Size() 個分確保しておくこと)
+void Length(const Vector3Soa& v, float* results);
+
+// 正規化 (長さ 0 の要素は 0 ベクトルにする)
+void Normalize(const Vector3Soa& v, Vector3Soa& result);
+
+// 変換 (w 除算込み)
+void TransformArray(const Vector3Soa& vectors, Vector3Soa& results, const Matrix4x4& matrix);